@@ -0,0 +1,12 @@
+#include <stdio.h>
+
+// 位置无关的指针表, 使用 -z pack-relative-relocs 链接时这些 R_X86_64_RELATIVE 重定位会被压缩到 .relr.dyn 中
+static const char *names[] = {"alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta"};
+static const char **name_pointers[] = {&names[0], &names[2], &names[4], &names[6]};
+
+int main() {
+    for (unsigned i = 0; i < sizeof(name_pointers) / sizeof(name_pointers[0]); i++) {
+        printf("%s\n", *name_pointers[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,1212 @@
+/*
+ *Copyright (c) 2023 All rights reserved
+ *@description: 可嵌入的 ELF64 解析库
+ *@author: Zhixing Lu
+ *@date: 2023-11-20
+ *@email: luzhixing12345@163.com
+ *@Github: luzhixing12345
+ */
+
+#include "libreadelf.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define RELF_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+__attribute__((format(printf, 2, 3))) static int relf_error(RELF_file *file, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(file->error, RELF_ERROR_SIZE, format, args);
+    va_end(args);
+    return 1;
+}
+
+/**
+ * @brief 段名, 需要先通过 RELF_validate_headers
+ */
+char *RELF_section_name(RELF_file *file, Elf64_Shdr *shdr) {
+    return (char *)file->addr + file->shstrtab_offset + shdr->sh_name;
+}
+
+static int relf_string_table_valid(RELF_file *file, Elf64_Word index) {
+    if (index >= file->ehdr.e_shnum) {
+        return 0;
+    }
+    Elf64_Shdr *strtab = &file->shdr[index];
+    return strtab->sh_type == SHT_STRTAB && strtab->sh_size &&
+           ((char *)file->addr)[strtab->sh_offset + strtab->sh_size - 1] == '\0';
+}
+
+/**
+ * @brief 检查 ELF 头描述的程序头表, 段表以及段的范围
+ *
+ * @param file shdr 为 NULL 时只检查程序头表
+ * @param file_size
+ * @return int 合法返回 0, 否则 file->error 中保存原因
+ */
+int RELF_validate_headers(RELF_file *file, uint64_t file_size) {
+    Elf64_Ehdr *ehdr = &file->ehdr;
+    if (ehdr->e_phnum && (ehdr->e_phentsize != sizeof(Elf64_Phdr) || ehdr->e_phoff > file_size ||
+                          (uint64_t)ehdr->e_phnum * sizeof(Elf64_Phdr) > file_size - ehdr->e_phoff)) {
+        return relf_error(file, "the program header table is out of the file");
+    }
+    if (!file->shdr || !ehdr->e_shnum) {
+        return 0;
+    }
+    if (ehdr->e_shentsize != sizeof(Elf64_Shdr) || ehdr->e_shstrndx >= ehdr->e_shnum) {
+        return relf_error(file, "bad section header table");
+    }
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        Elf64_Shdr *shdr = &file->shdr[i];
+        if (shdr->sh_type != SHT_NOBITS &&
+            (shdr->sh_offset > file_size || shdr->sh_size > file_size - shdr->sh_offset)) {
+            return relf_error(file, "section %d is out of the file", i);
+        }
+    }
+    // 所有段名都在段表字符串表之内, 并且字符串表以 '\0' 结尾
+    // 段表字符串表通过 shstrtab_offset 访问, --batch 中它是单独读入的一块内存
+    Elf64_Shdr *shstrtab = &file->shdr[ehdr->e_shstrndx];
+    if (shstrtab->sh_type != SHT_STRTAB || !shstrtab->sh_size ||
+        ((char *)file->addr)[file->shstrtab_offset + shstrtab->sh_size - 1] != '\0') {
+        return relf_error(file, "bad section header string table");
+    }
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        if (file->shdr[i].sh_name >= shstrtab->sh_size) {
+            return relf_error(file, "the name of section %d is out of range", i);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 检查符号表的 st_name 和 st_shndx
+ *
+ * @param file
+ * @param index 符号表的段索引
+ * @param validated 已经检查过的符号表, 每个段一位, 为 NULL 时总是检查
+ *                  多个重定位段通常关联同一个符号表, 每个符号表只检查一次
+ * @return int 合法返回 0, 否则 file->error 中保存原因
+ */
+static int relf_validate_symbols(RELF_file *file, int index, uint8_t *validated) {
+    if (validated && (validated[index / 8] & (1 << (index % 8)))) {
+        return 0;
+    }
+    Elf64_Shdr *shdr = &file->shdr[index];
+    if (!relf_string_table_valid(file, shdr->sh_link)) {
+        return relf_error(file, "symbol table %d has a bad string table", index);
+    }
+    Elf64_Xword strtab_size = file->shdr[shdr->sh_link].sh_size;
+    Elf64_Sym *symbols = (Elf64_Sym *)((char *)file->addr + shdr->sh_offset);
+    uint64_t symbol_number = shdr->sh_size / sizeof(Elf64_Sym);
+    for (uint64_t i = 0; i < symbol_number; i++) {
+        // 没有名字的符号使用 st_shndx 对应的段名
+        if (symbols[i].st_name >= strtab_size || (!symbols[i].st_name && symbols[i].st_shndx != SHN_ABS &&
+                                                  symbols[i].st_shndx >= file->ehdr.e_shnum)) {
+            return relf_error(file, "bad symbol %lu in symbol table %d", i, index);
+        }
+    }
+    if (validated) {
+        validated[index / 8] |= 1 << (index % 8);
+    }
+    return 0;
+}
+
+static int relf_validate_relocations(RELF_file *file, int index, uint8_t *validated) {
+    Elf64_Shdr *shdr = &file->shdr[index];
+    uint64_t symbol_number = 1;  // 没有关联符号表时只允许 0 号符号
+    if (shdr->sh_link) {
+        Elf64_Word link = shdr->sh_link;
+        if (link >= file->ehdr.e_shnum ||
+            (file->shdr[link].sh_type != SHT_SYMTAB && file->shdr[link].sh_type != SHT_DYNSYM)) {
+            return relf_error(file, "relocation section %d has a bad symbol table", index);
+        }
+        if (relf_validate_symbols(file, link, validated)) {
+            return 1;
+        }
+        symbol_number = file->shdr[link].sh_size / sizeof(Elf64_Sym);
+    }
+    // Elf64_Rel 和 Elf64_Rela 的 r_info 都在偏移 8 处, 只有每一项的大小不同
+    uint64_t entry_size = shdr->sh_type == SHT_RELA ? sizeof(Elf64_Rela) : sizeof(Elf64_Rel);
+    char *entries = (char *)file->addr + shdr->sh_offset;
+    uint64_t rela_number = shdr->sh_size / entry_size;
+    for (uint64_t i = 0; i < rela_number; i++) {
+        Elf64_Rel *rel = (Elf64_Rel *)(entries + i * entry_size);
+        if (ELF64_R_SYM(rel->r_info) >= symbol_number) {
+            return relf_error(file, "bad symbol index in relocation %lu of section %d", i, index);
+        }
+    }
+    return 0;
+}
+
+static int relf_validate_sections(RELF_file *file, int checks, uint8_t *validated) {
+    for (int i = 0; i < file->ehdr.e_shnum; i++) {
+        Elf64_Shdr *shdr = &file->shdr[i];
+        if ((checks & RELF_CHECK_SYMBOLS) && (shdr->sh_type == SHT_SYMTAB || shdr->sh_type == SHT_DYNSYM)) {
+            if (relf_validate_symbols(file, i, validated)) {
+                return 1;
+            }
+        } else if ((checks & RELF_CHECK_RELOCATIONS) && (shdr->sh_type == SHT_RELA || shdr->sh_type == SHT_REL)) {
+            if (relf_validate_relocations(file, i, validated)) {
+                return 1;
+            }
+        } else if ((checks & RELF_CHECK_VERSIONS) &&
+                   (shdr->sh_type == SHT_GNU_verdef || shdr->sh_type == SHT_GNU_verneed)) {
+            if (!relf_string_table_valid(file, shdr->sh_link)) {
+                return relf_error(file, "version section %d has a bad string table", i);
+            }
+        } else if ((checks & RELF_CHECK_INTERP) && shdr->sh_type == SHT_PROGBITS && shdr->sh_size &&
+                   !strcmp(RELF_section_name(file, shdr), ".interp")) {
+            if (((char *)file->addr)[shdr->sh_offset + shdr->sh_size - 1] != '\0') {
+                return relf_error(file, ".interp is not terminated");
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 检查需要遍历的表的内容, 需要先通过 RELF_validate_headers
+ *
+ * @param file
+ * @param checks RELF_CHECK_* 的组合
+ * @return int 合法返回 0, 否则 file->error 中保存原因
+ */
+int RELF_validate_tables(RELF_file *file, int checks) {
+    if (!file->shdr) {
+        return 0;
+    }
+    // 位图只在这次调用中使用, 不保存在 file 中, 多个线程可以同时检查同一个文件
+    // 分配失败时只是不跳过检查过的符号表
+    uint8_t *validated = calloc((file->ehdr.e_shnum + 7) / 8, 1);
+    int error = relf_validate_sections(file, checks, validated);
+    free(validated);
+    return error;
+}
+
+/**
+ * @brief 符号表, 需要先通过 RELF_validate_tables(RELF_CHECK_SYMBOLS)
+ */
+RELF_symbols RELF_symbol_span(RELF_file *file, Elf64_Shdr *shdr) {
+    RELF_symbols span;
+    span.symbols = (Elf64_Sym *)((char *)file->addr + shdr->sh_offset);
+    span.symbol_number = shdr->sh_size / sizeof(Elf64_Sym);
+    span.strtab = (char *)file->addr + file->shdr[shdr->sh_link].sh_offset;
+    return span;
+}
+
+/**
+ * @brief 符号名, st_name 为 0 的符号 (不包括 ABS) 使用 st_shndx 对应的段名
+ */
+char *RELF_symbol_name(RELF_file *file, RELF_symbols *span, Elf64_Sym *sym) {
+    if (sym->st_name || sym->st_shndx == SHN_ABS) {
+        return (char *)span->strtab + sym->st_name;
+    }
+    return RELF_section_name(file, &file->shdr[sym->st_shndx]);
+}
+
+/**
+ * @brief 重定位表, 需要先通过 RELF_validate_tables(RELF_CHECK_RELOCATIONS)
+ */
+RELF_relocations RELF_rela_span(RELF_file *file, Elf64_Shdr *shdr) {
+    // 没有关联符号表的重定位只会引用 0 号符号, 这个符号只读, 不影响可重入
+    static Elf64_Sym null_symbol;
+    RELF_relocations span;
+    if (shdr->sh_type == SHT_REL) {
+        span.relas = NULL;
+        span.rels = (Elf64_Rel *)((char *)file->addr + shdr->sh_offset);
+        span.rela_number = shdr->sh_size / sizeof(Elf64_Rel);
+    } else {
+        span.relas = (Elf64_Rela *)((char *)file->addr + shdr->sh_offset);
+        span.rels = NULL;
+        span.rela_number = shdr->sh_size / sizeof(Elf64_Rela);
+    }
+    if (shdr->sh_link) {
+        span.symbols = RELF_symbol_span(file, &file->shdr[shdr->sh_link]);
+    } else {
+        span.symbols.symbols = &null_symbol;
+        span.symbols.symbol_number = 1;
+        span.symbols.strtab = "";
+    }
+    return span;
+}
+
+/**
+ * @brief RELR 表, 只需要 RELF_validate_headers
+ */
+RELF_relr RELF_relr_span(RELF_file *file, Elf64_Shdr *shdr) {
+    RELF_relr span;
+    span.relrs = (Elf64_Relr *)((char *)file->addr + shdr->sh_offset);
+    span.relr_number = shdr->sh_size / sizeof(Elf64_Relr);
+    return span;
+}
+
+/**
+ * @brief 统计 RELR 表的项和展开之后的重定位数量, 不展开
+ *
+ * @param span
+ * @param summary
+ */
+void RELF_relr_summarize(RELF_relr *span, RELF_relr_summary *summary) {
+    // 地址项计 1, 位图项计置位的个数, 用掩码选择而不是分支
+    uint64_t bitmap_number = 0;
+    uint64_t location_number = 0;
+    for (uint64_t i = 0; i < span->relr_number; i++) {
+        Elf64_Relr entry = span->relrs[i];
+        uint64_t is_bitmap = entry & 1;
+        uint64_t mask = -is_bitmap;
+        bitmap_number += is_bitmap;
+        location_number += ((uint64_t)__builtin_popcountll(entry >> 1) & mask) | (~mask & 1);
+    }
+    summary->address_number = span->relr_number - bitmap_number;
+    summary->bitmap_number = bitmap_number;
+    summary->location_number = location_number;
+}
+
+/**
+ * @brief 展开 RELR 表, 按照表中的顺序写入每一个需要重定位的地址
+ *
+ * @param span
+ * @param addresses 至少 RELF_relr_summarize 得到的 location_number 项
+ * @return uint64_t 写入的地址数量
+ */
+uint64_t RELF_relr_expand(RELF_relr *span, Elf64_Addr *addresses) {
+    Elf64_Addr base = 0;
+    uint64_t n = 0;
+    for (uint64_t i = 0; i < span->relr_number; i++) {
+        Elf64_Relr entry = span->relrs[i];
+        if (!(entry & 1)) {
+            addresses[n++] = entry;
+            base = entry + sizeof(Elf64_Addr);
+            continue;
+        }
+        // 每次取最低的置位, 循环次数等于置位的个数, 没有逐位的判断
+        for (uint64_t bits = entry >> 1; bits; bits &= bits - 1) {
+            addresses[n++] = base + (Elf64_Addr)__builtin_ctzll(bits) * sizeof(Elf64_Addr);
+        }
+        base += 63 * sizeof(Elf64_Addr);
+    }
+    return n;
+}
+
+/**
+ * @brief 获取字符串表 strtab_index 中 offset 处的字符串
+ *
+ * @param file
+ * @param strtab_index
+ * @param offset
+ * @return const char* 越界返回 NULL
+ */
+const char *RELF_string(RELF_file *file, Elf64_Word strtab_index, Elf64_Word offset) {
+    if (strtab_index >= file->ehdr.e_shnum) {
+        return NULL;
+    }
+    Elf64_Shdr *strtab = &file->shdr[strtab_index];
+    if (offset >= strtab->sh_size) {
+        return NULL;
+    }
+    return (char *)file->addr + strtab->sh_offset + offset;
+}
+
+/**
+ * @brief 程序头表
+ *
+ * @param file
+ * @return Elf64_Phdr* 没有程序头表时返回 NULL
+ */
+Elf64_Phdr *RELF_segments(RELF_file *file) {
+    if (!file->ehdr.e_phnum) {
+        return NULL;
+    }
+    return (Elf64_Phdr *)((char *)file->addr + file->ehdr.e_phoff);
+}
+
+/**
+ * @brief 查所有 section 找到段名为 .interp 的地址
+ *
+ * @param file
+ * @return const char*
+ */
+const char *RELF_interpreter(RELF_file *file) {
+    for (int i = 0; i < file->ehdr.e_shnum; i++) {
+        Elf64_Shdr *shdr = &file->shdr[i];
+        if (shdr->sh_type == SHT_PROGBITS && !strcmp(RELF_section_name(file, shdr), ".interp")) {
+            return (char *)file->addr + shdr->sh_offset;
+        }
+    }
+    return "";
+}
+
+/**
+ * @brief 把内存中的一段数据作为 ELF 文件, shdr 直接指向其中的段表, 不做拷贝
+ *
+ * @param file
+ * @param addr
+ * @param size
+ * @param checks RELF_CHECK_* 的组合
+ * @return int 成功返回 0, 失败时 file->error 中保存原因
+ */
+int RELF_open_memory(RELF_file *file, void *addr, uint64_t size, int checks) {
+    memset(file, 0, sizeof(RELF_file));
+    if (size < sizeof(Elf64_Ehdr)) {
+        return relf_error(file, "Not an ELF64 file");
+    }
+    memcpy(&file->ehdr, addr, sizeof(Elf64_Ehdr));
+    Elf64_Ehdr *ehdr = &file->ehdr;
+    if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) || ehdr->e_ident[EI_CLASS] != ELFCLASS64) {
+        return relf_error(file, "Not an ELF64 file");
+    }
+    if (ehdr->e_shoff > size || (uint64_t)ehdr->e_shnum * sizeof(Elf64_Shdr) > size - ehdr->e_shoff) {
+        return relf_error(file, "the section header table is out of the file");
+    }
+    file->addr = addr;
+    file->size = size;
+    file->shdr = (Elf64_Shdr *)((char *)addr + ehdr->e_shoff);
+    if (ehdr->e_shnum && ehdr->e_shstrndx < ehdr->e_shnum) {
+        file->shstrtab_offset = file->shdr[ehdr->e_shstrndx].sh_offset;
+    }
+    return RELF_validate_headers(file, size) || RELF_validate_tables(file, checks);
+}
+
+/**
+ * @brief 打开 ELF 文件并做完整的内存映射, shdr 直接指向映射中的段表
+ *
+ * @param file
+ * @param path
+ * @param checks RELF_CHECK_* 的组合
+ * @return int 成功返回 0, 失败时 file->error 中保存原因, 不需要调用 RELF_close
+ */
+int RELF_open(RELF_file *file, const char *path, int checks) {
+    memset(file, 0, sizeof(RELF_file));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return relf_error(file, "%s", strerror(errno));
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < (off_t)sizeof(Elf64_Ehdr)) {
+        close(fd);
+        return relf_error(file, "Not an ELF64 file");
+    }
+    void *addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return relf_error(file, "%s", strerror(error));
+    }
+    if (RELF_open_memory(file, addr, size, checks)) {
+        munmap(addr, size);
+        return 1;
+    }
+    file->mapped = 1;
+    return 0;
+}
+
+/**
+ * @brief 释放 RELF_open 映射的内存
+ *
+ * @param file
+ */
+void RELF_close(RELF_file *file) {
+    if (file->mapped) {
+        munmap(file->addr, file->size);
+        file->mapped = 0;
+    }
+}
+
+/**
+ * @brief 获取段类型
+ *
+ * @param section_type
+ * @return char*
+ */
+char *RELF_section_type(Elf64_Word section_type) {
+    switch (section_type) {
+        case SHT_NULL:
+            return "NULL";
+        case SHT_PROGBITS:
+            // 该部分保存由程序定义的信息,其格式和含义完全由程序决定.
+            // 其格式和含义完全由程序决定
+            return "PROGBITS";
+        case SHT_SYMTAB:
+            // 符号表
+            return "SYMTAB";
+        case SHT_STRTAB:
+            // 字符串表
+            return "STRTAB";
+        case SHT_RELA:
+            // 有明确后缀的重定位条目
+            return "RELA";
+        case SHT_HASH:
+            // hash 表
+            return "HASH";
+        case SHT_DYNAMIC:
+            // 动态链接
+            return "DYNAMIC";
+        case SHT_NOTE:
+            // 包含以某种方式标记文件的信息
+            // 比如 .note.gnu.propert
+            return "NOTE";
+        case SHT_NOBITS:
+            // 文件中不占空间
+            // bss
+            return "NOBITS";
+        case SHT_REL:
+            // 没有明确后缀的重定位条目
+            return "REL";
+        case SHT_RELR:
+            // 压缩的相对重定位, 只有地址
+            return "RELR";
+        case SHT_DYNSYM:
+            // 符号表
+            return "DYNSYM";
+        case SHT_SHLIB:
+            // 保留
+            return "";
+            // 这里其实有一大堆 GNU 的扩展符号
+            // https://sourceware.org/git/?p=binutils-gdb.git;a=blob;f=binutils/readelf.c;h=b872876a8b660be19e1ffc66ee300d0bbfaed345;hb=HEAD#l4942
+        case SHT_INIT_ARRAY:
+            return "INIT_ARRAY";
+        case SHT_FINI_ARRAY:
+            return "FINI_ARRAY";
+        case SHT_PREINIT_ARRAY:
+            return "PREINIT_ARRAY";
+        case SHT_GNU_HASH:
+            return "GNU_HASH";
+        case SHT_GROUP:
+            return "GROUP";
+        case SHT_SYMTAB_SHNDX:
+            return "SYMTAB SECTION INDICES";
+        case SHT_GNU_verdef:
+            return "VERDEF";
+        case SHT_GNU_verneed:
+            return "VERNEED";
+        case SHT_GNU_versym:
+            return "VERSYM";
+        case 0x6ffffff0:
+            return "VERSYM";
+        case 0x6ffffffc:
+            return "VERDEF";
+        case 0x7ffffffd:
+            return "AUXILIARY";
+        case 0x7fffffff:
+            return "FILTER";
+        case SHT_GNU_LIBLIST:
+            return "GNU_LIBLIST";
+        default:
+            return "";
+    }
+}
+
+/**
+ * @brief 获取段标记位信息
+ *
+ * @param section_flag
+ * @param buffer 至少 RELF_SECTION_FLAGS_SIZE 字节
+ * @return char*
+ */
+char *RELF_section_flags(Elf64_Xword section_flag, char *buffer) {
+    // https://sourceware.org/git?p=binutils-gdb.git;a=blob;f=binutils/readelf.c;h=b872876a8b660be19e1ffc66ee300d0bbfaed345;hb=HEAD#l6812
+
+    // SHF_WRITE:段内容可以被写入.
+    // SHF_ALLOC:段在程序执行时被分配内存.
+    // SHF_EXECINSTR:段包含可执行指令.
+    // SHF_MASKPROC:该位由处理器架构定义.
+    char *p = buffer;
+    if (section_flag & SHF_WRITE)
+        *p++ = 'W';
+    if (section_flag & SHF_ALLOC)
+        *p++ = 'A';
+    if (section_flag & SHF_EXECINSTR)
+        *p++ = 'X';
+    if (section_flag & SHF_MERGE)
+        *p++ = 'M';
+    if (section_flag & SHF_STRINGS)
+        *p++ = 'S';
+    if (section_flag & SHF_INFO_LINK)
+        *p++ = 'I';
+    if (section_flag & SHF_LINK_ORDER)
+        *p++ = 'L';
+    if (section_flag & SHF_OS_NONCONFORMING)
+        *p++ = 'O';
+    if (section_flag & SHF_GROUP)
+        *p++ = 'G';
+    if (section_flag & SHF_TLS)
+        *p++ = 'T';
+    if (section_flag & SHF_EXCLUDE)
+        *p++ = 'E';
+    if (section_flag & SHF_COMPRESSED)
+        *p++ = 'C';
+    *p = 0;
+    return buffer;
+}
+
+
+/**
+ * @brief 符号表中的符号类型
+ *
+ * @param st_info
+ * @return char*
+ */
+char *RELF_symbol_type(int st_info) {
+    switch (st_info) {
+        case STT_NOTYPE:
+            // 符号类型未指定, 未知的一些符号比如 printf
+            return "NOTYPE";
+        case STT_OBJECT:
+            // 符号与数据对象相关联,如变量、数组等等.
+            return "OBJECT";
+        case STT_FUNC:
+            // 符号与函数或其他可执行代码相关联
+            return "FUNC";
+        case STT_SECTION:
+            // 该符号与一个章节相关联.这种类型的符号表项主要用于重新定位,通常与 STB_LOCAL 绑定.
+            return "SECTION";
+        case STT_FILE:
+            // 文件符号具有 STB_LOCAL 绑定功能,其分区索引为 SHN_ABS,如果存在,则位于文件的其他 STB_LOCAL 符号之前.
+            // 如果存在,它位于文件的其他 STB_LOCAL 符号之前
+            return "FILE";
+        case STT_COMMON:
+            // 符号是一种常见的数据对象
+            return "COMMON";
+        case STT_TLS:
+            // 符号是线程本地数据对象
+            return "TLS";
+        case STT_GNU_IFUNC:
+            // 间接函数, 加载时调用解析函数得到真正的地址
+            return "IFUNC";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+char *RELF_symbol_bind(int st_info) {
+    switch (st_info) {
+        case STB_LOCAL:
+            // 本地符号在包含其定义的对象文件之外是不可见的.
+            // 定义的对象文件外是不可见的.同名的局部符号可存在于多个文件中
+            // 而不会相互干扰.
+            return "LOCAL";
+        case STB_GLOBAL:
+            // 全局符号对合并的所有对象文件都是可见的.一个文件的
+            // 全局符号的定义将满足另一个文件对同一全局符号的未定义引用.
+            // 对同一全局符号的未定义引用.
+            return "GLOBAL";
+        case STB_WEAK:
+            // 弱符号类似于全局符号,但其定义的优先级较低.
+            return "WEAK";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+char *RELF_symbol_vis(int st_other) {
+    switch (st_other) {
+        case STV_DEFAULT:
+            return "DEFAULT";
+        case STV_INTERNAL:
+            return "INTERNAL";
+        case STV_HIDDEN:
+            return "HIDDEN";
+        case STV_PROTECTED:
+            return "PROTECTED";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+
+char *RELF_relocation_type(int type) {
+    switch (type) {
+        // x86_64 架构的重定位类型
+        case R_X86_64_NONE:
+            return "R_X86_64_NONE";
+        case R_X86_64_64:
+            return "R_X86_64_64";
+        case R_X86_64_PC32:
+            return "R_X86_64_PC32";
+        case R_X86_64_GOT32:
+            return "R_X86_64_GOT32";
+        case R_X86_64_PLT32:
+            return "R_X86_64_PLT32";
+        case R_X86_64_COPY:
+            return "R_X86_64_COPY";
+        case R_X86_64_GLOB_DAT:
+            return "R_X86_64_GLOB_DAT";
+        case R_X86_64_JUMP_SLOT:
+            return "R_X86_64_JUMP_SLOT";
+        case R_X86_64_RELATIVE:
+            return "R_X86_64_RELATIVE";
+        case R_X86_64_GOTPCREL:
+            return "R_X86_64_GOTPCREL";
+        case R_X86_64_32:
+            return "R_X86_64_32";
+        case R_X86_64_32S:
+            return "R_X86_64_32S";
+        case R_X86_64_16:
+            return "R_X86_64_16";
+        case R_X86_64_PC16:
+            return "R_X86_64_PC16";
+        case R_X86_64_8:
+            return "R_X86_64_8";
+        case R_X86_64_PC8:
+            return "R_X86_64_PC8";
+        case R_X86_64_DTPMOD64:
+            return "R_X86_64_DTPMOD64";
+        case R_X86_64_DTPOFF64:
+            return "R_X86_64_DTPOFF64";
+        case R_X86_64_TPOFF64:
+            return "R_X86_64_TPOFF64";
+        case R_X86_64_TLSGD:
+            return "R_X86_64_TLSGD";
+        case R_X86_64_TLSLD:
+            return "R_X86_64_TLSLD";
+        case R_X86_64_DTPOFF32:
+            return "R_X86_64_DTPOFF32";
+        case R_X86_64_GOTTPOFF:
+            return "R_X86_64_GOTTPOFF";
+        case R_X86_64_TPOFF32:
+            return "R_X86_64_TPOFF32";
+        case R_X86_64_PC64:
+            return "R_X86_64_PC64";
+        case R_X86_64_GOTOFF64:
+            return "R_X86_64_GOTOFF64";
+        case R_X86_64_GOTPC32:
+            return "R_X86_64_GOTPC32";
+        case R_X86_64_GOT64:
+            return "R_X86_64_GOT64";
+        case R_X86_64_GOTPCREL64:
+            return "R_X86_64_GOTPCREL64";
+        case R_X86_64_GOTPC64:
+            return "R_X86_64_GOTPC64";
+        case R_X86_64_GOTPLT64:
+            return "R_X86_64_GOTPLT64";
+        case R_X86_64_PLTOFF64:
+            return "R_X86_64_PLTOFF64";
+        case R_X86_64_SIZE32:
+            return "R_X86_64_SIZE32";
+        case R_X86_64_SIZE64:
+            return "R_X86_64_SIZE64";
+        case R_X86_64_GOTPC32_TLSDESC:
+            return "R_X86_64_GOTPC32_TLSDESC";
+        case R_X86_64_TLSDESC_CALL:
+            return "R_X86_64_TLSDESC_CALL";
+        case R_X86_64_TLSDESC:
+            return "R_X86_64_TLSDESC";
+        case R_X86_64_IRELATIVE:
+            return "R_X86_64_IRELATIVE";
+        case R_X86_64_RELATIVE64:
+            return "R_X86_64_RELATIVE64";
+        case R_X86_64_GOTPCRELX:
+            return "R_X86_64_GOTPCRELX";
+        case R_X86_64_REX_GOTPCRELX:
+            return "R_X86_64_REX_GOTPCRELX";
+        // 其他架构的重定位类型
+        // ...
+        default:
+            return "UNKNOWN";
+    }
+}
+
+char *RELF_segment_type(uint32_t p_type) {
+    switch (p_type) {
+        case PT_NULL:
+            return "NULL";
+        case PT_LOAD:
+            return "LOAD";
+        case PT_DYNAMIC:
+            return "DYNAMIC";
+        case PT_INTERP:
+            return "INTERP";
+        case PT_NOTE:
+            return "NOTE";
+        case PT_SHLIB:
+            return "SHLIB";
+        case PT_TLS:
+            return "TLS";
+        case PT_PHDR:
+            return "PHDR";
+        case PT_GNU_STACK:
+            return "GNU_STACK";
+        case PT_LOPROC:
+            return "LOPROC";
+        case PT_HIPROC:
+            return "HIPROC";
+        case PT_GNU_RELRO:
+            return "GNU_RELRO";
+        case PT_GNU_EH_FRAME:
+            return "GNU_EH_FRAME";
+        case PT_GNU_PROPERTY:
+            return "GNU_PROPERTY";
+        default:
+            return "";
+    }
+}
+
+
+/**
+ * @brief 符号所在的段, 特殊段使用缩写
+ *
+ * @param st_shndx
+ * @param buffer 至少 RELF_SYMBOL_NDX_SIZE 字节
+ * @return char*
+ */
+char *RELF_symbol_ndx(Elf64_Section st_shndx, char *buffer) {
+    switch (st_shndx) {
+        case SHN_ABS:
+            return "ABS";
+        case SHN_COMMON:
+            return "COM";
+        case SHN_UNDEF:
+            return "UND";
+        default:
+            // 正常情况
+            snprintf(buffer, RELF_SYMBOL_NDX_SIZE, "%u", st_shndx);
+            return buffer;
+    }
+}
+
+/**
+ * @brief 程序头的标记位
+ *
+ * @param p_flags
+ * @param buffer 至少 RELF_SEGMENT_FLAGS_SIZE 字节
+ * @return char*
+ */
+char *RELF_segment_flags(uint32_t p_flags, char *buffer) {
+    buffer[0] = (p_flags & PF_R) ? 'R' : ' ';
+    buffer[1] = (p_flags & PF_W) ? 'W' : ' ';
+    buffer[2] = (p_flags & PF_X) ? 'E' : ' ';
+    buffer[3] = 0;
+    return buffer;
+}
+
+/**
+ * @brief 遍历 verdef/verneed 链
+ *
+ * @param file
+ * @param table
+ * @param fill 为 0 时只统计最大的版本索引, 为 1 时填写 table->names
+ */
+static void relf_scan_versions(RELF_file *file, RELF_versions *table, int fill) {
+    for (int i = 0; i < file->ehdr.e_shnum; i++) {
+        Elf64_Shdr *shdr = &file->shdr[i];
+        char *data = (char *)file->addr + shdr->sh_offset;
+        uint64_t offset = 0;
+        if (shdr->sh_type == SHT_GNU_verdef) {
+            table->has_verdef = 1;
+            for (Elf64_Word cnt = 0; cnt < shdr->sh_info && offset + sizeof(Elf64_Verdef) <= shdr->sh_size; cnt++) {
+                Elf64_Verdef *verdef = (Elf64_Verdef *)(data + offset);
+                int index = verdef->vd_ndx & VERSYM_VERSION;
+                if (!fill) {
+                    table->name_number = RELF_MAX(table->name_number, index + 1);
+                } else if (!table->names[index].has_def) {
+                    table->names[index].has_def = 1;
+                    table->names[index].def_flags = verdef->vd_flags;
+                    if (offset + verdef->vd_aux + sizeof(Elf64_Verdaux) <= shdr->sh_size) {
+                        Elf64_Verdaux *verdaux = (Elf64_Verdaux *)(data + offset + verdef->vd_aux);
+                        table->names[index].def_name = RELF_string(file, shdr->sh_link, verdaux->vda_name);
+                    }
+                }
+                if (!verdef->vd_next) {
+                    break;
+                }
+                offset += verdef->vd_next;
+            }
+        } else if (shdr->sh_type == SHT_GNU_verneed) {
+            table->has_verneed = 1;
+            for (Elf64_Word cnt = 0; cnt < shdr->sh_info && offset + sizeof(Elf64_Verneed) <= shdr->sh_size; cnt++) {
+                Elf64_Verneed *verneed = (Elf64_Verneed *)(data + offset);
+                uint64_t aux_offset = offset + verneed->vn_aux;
+                for (int j = 0; j < verneed->vn_cnt && aux_offset + sizeof(Elf64_Vernaux) <= shdr->sh_size; j++) {
+                    Elf64_Vernaux *vernaux = (Elf64_Vernaux *)(data + aux_offset);
+                    int index = vernaux->vna_other & VERSYM_VERSION;
+                    if (!fill) {
+                        table->name_number = RELF_MAX(table->name_number, index + 1);
+                    } else if (!table->names[index].need_name) {
+                        table->names[index].need_name = RELF_string(file, shdr->sh_link, vernaux->vna_name);
+                    }
+                    if (!vernaux->vna_next) {
+                        break;
+                    }
+                    aux_offset += vernaux->vna_next;
+                }
+                if (!verneed->vn_next) {
+                    break;
+                }
+                offset += verneed->vn_next;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 解析符号版本信息, 构建 版本索引 -> 版本名 的数组
+ *
+ * @param file
+ * @param table 需要调用 RELF_free_versions 释放
+ */
+void RELF_build_versions(RELF_file *file, RELF_versions *table) {
+    memset(table, 0, sizeof(RELF_versions));
+    for (int i = 0; i < file->ehdr.e_shnum; i++) {
+        Elf64_Shdr *shdr = &file->shdr[i];
+        if (shdr->sh_type == SHT_GNU_versym) {
+            table->versym = (Elf64_Half *)((char *)file->addr + shdr->sh_offset);
+            table->versym_number = shdr->sh_size / sizeof(Elf64_Half);
+            break;
+        }
+    }
+    relf_scan_versions(file, table, 0);
+    if (table->name_number) {
+        table->names = calloc(table->name_number, sizeof(RELF_version_name));
+        if (table->names) {
+            relf_scan_versions(file, table, 1);
+        } else {
+            // 没有内存时按没有版本信息输出
+            table->name_number = 0;
+        }
+    }
+}
+
+void RELF_free_versions(RELF_versions *table) {
+    free(table->names);
+    table->names = NULL;
+}
+
+/**
+ * @brief 获取 .dynsym 中第 index 个符号的版本名
+ *
+ * @param table
+ * @param index 符号在 .dynsym 中的下标
+ * @param sym
+ * @param name 符号名, 和版本名相同的 SHN_ABS 符号是版本定义本身, 不输出版本
+ * @param kind 输出版本的类型: 定义(公开/隐藏) 或 引用
+ * @return const char* 没有版本时返回 NULL
+ */
+const char *RELF_symbol_version(RELF_versions *table, uint64_t index, Elf64_Sym *sym, const char *name, int *kind) {
+    if (index >= table->versym_number) {
+        return NULL;
+    }
+    Elf64_Half versym = table->versym[index];
+    if (versym == 0) {
+        return NULL;
+    }
+    int version_index = versym & VERSYM_VERSION;
+    if (version_index >= table->name_number) {
+        return NULL;
+    }
+    RELF_version_name *version = &table->names[version_index];
+    *kind = (versym & VERSYM_HIDDEN) ? RELF_VERSION_HIDDEN : RELF_VERSION_PUBLIC;
+    // 一般来说定义的符号对应 verdef, 未定义的符号对应 verneed
+    // 但是从共享库复制到 .dynbss 的变量虽然是定义的却对应 verneed, 所以两个都要查
+    if (sym->st_shndx != SHN_UNDEF && versym != (VERSYM_HIDDEN | VER_NDX_GLOBAL) && version->has_def) {
+        if (version_index == VER_NDX_GLOBAL && version->def_flags == VER_FLG_BASE) {
+            return NULL;
+        }
+        // 例如 libc 中的 GLIBC_2.10, 和 GNU readelf 一样只输出符号名
+        if (sym->st_shndx == SHN_ABS && version->def_name && !strcmp(name, version->def_name)) {
+            return NULL;
+        }
+        return version->def_name;
+    }
+    if (!(versym & VERSYM_HIDDEN) && version->need_name) {
+        *kind = RELF_VERSION_UNDEFINED;
+        return version->need_name;
+    }
+    return NULL;
+}
+// RELF_FORMAT_COLOR 使用的颜色, 控制序列预先拼好, 和字段一起在同一次格式化中写入缓冲区
+#define RELF_COLOR_RESET "\033[0m"
+#define RELF_COLOR_RED "\033[1;31m"
+#define RELF_COLOR_GREEN "\033[32m"
+#define RELF_COLOR_BOLD_GREEN "\033[1;32m"
+#define RELF_COLOR_YELLOW "\033[33m"
+#define RELF_COLOR_BLUE "\033[34m"
+#define RELF_COLOR_MAGENTA "\033[35m"
+#define RELF_COLOR_CYAN "\033[36m"
+
+static const char *relf_section_type_color(Elf64_Word section_type) {
+    switch (section_type) {
+        case SHT_PROGBITS:
+            return RELF_COLOR_GREEN;
+        case SHT_NOBITS:
+            return RELF_COLOR_BLUE;
+        case SHT_SYMTAB:
+        case SHT_DYNSYM:
+            return RELF_COLOR_MAGENTA;
+        case SHT_STRTAB:
+            return RELF_COLOR_CYAN;
+        case SHT_RELA:
+        case SHT_REL:
+        case SHT_RELR:
+            return RELF_COLOR_YELLOW;
+        case SHT_DYNAMIC:
+            return RELF_COLOR_RED;
+        default:
+            return "";
+    }
+}
+
+// 可执行的段最显眼, 其次是可写的段
+static const char *relf_section_flags_color(Elf64_Xword section_flag) {
+    if (section_flag & SHF_EXECINSTR) {
+        return RELF_COLOR_RED;
+    }
+    if (section_flag & SHF_WRITE) {
+        return RELF_COLOR_YELLOW;
+    }
+    if (section_flag & SHF_ALLOC) {
+        return RELF_COLOR_GREEN;
+    }
+    return "";
+}
+
+static const char *relf_symbol_bind_color(int bind) {
+    switch (bind) {
+        case STB_GLOBAL:
+            return RELF_COLOR_BOLD_GREEN;
+        case STB_WEAK:
+            return RELF_COLOR_MAGENTA;
+        case STB_GNU_UNIQUE:
+            return RELF_COLOR_CYAN;
+        default:
+            return "";
+    }
+}
+
+// 没有颜色时结尾也不输出 RELF_COLOR_RESET
+#define RELF_COLOR(flags, color) ((flags) & RELF_FORMAT_COLOR ? (color) : "")
+#define RELF_COLOR_END(flags, color) ((flags) & RELF_FORMAT_COLOR && *(color) ? RELF_COLOR_RESET : "")
+
+// 格式化函数和 snprintf 的语义相同, length 记录完整输出的长度, 缓冲区不足时截断写入的内容
+__attribute__((format(printf, 4, 5))) static void relf_append(
+    char *buffer, size_t size, int *length, const char *format, ...) {
+    size_t offset = (size_t)*length < size ? (size_t)*length : size;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + offset, size - offset, format, args);
+    va_end(args);
+    if (n > 0) {
+        *length += n;
+    }
+}
+
+/**
+ * @brief 按照宽度输出符号名, 过长的符号名截断并添加 [...]
+ *
+ * @param name
+ * @param width 为负数时表示不足的部分补空格
+ * @param flags RELF_FORMAT_WIDE 时不截断
+ */
+static void relf_append_name(char *buffer, size_t size, int *length, const char *name, int width, int flags) {
+    int extra_padding = 0;
+    if (flags & RELF_FORMAT_WIDE) {
+        relf_append(buffer, size, length, "%s", name);
+        return;
+    }
+    if (width < 0) {
+        width = -width;
+        extra_padding = 1;
+    } else if (width == 0) {
+        return;
+    }
+    int name_length = (int)strlen(name);
+    int printed = name_length;
+    if (name_length > width) {
+        printed = RELF_MAX(width - 5, 0);
+        relf_append(buffer, size, length, "%.*s[...]", printed, name);
+        printed += 5;
+    } else {
+        relf_append(buffer, size, length, "%s", name);
+    }
+    if (extra_padding && printed < width) {
+        relf_append(buffer, size, length, "%-*s", width - printed, " ");
+    }
+}
+
+int RELF_format_section(RELF_file *file, int index, int flags, char *buffer, size_t size) {
+    Elf64_Shdr *shdr = &file->shdr[index];
+    char section_flags[RELF_SECTION_FLAGS_SIZE];
+    // 段名的获取方式是通过 shstrtab + sh_name(偏移地址) 得到的
+    char *section_name = RELF_section_name(file, shdr);
+
+    // 过长的字符串输出截断
+    // readelf -S examples/SimpleSection.o
+    char short_section_name[18];
+    if (!(flags & RELF_FORMAT_WIDE) && strlen(section_name) > 16) {
+        snprintf(short_section_name, sizeof(short_section_name), "%.12s[...]", section_name);
+        section_name = short_section_name;
+    }
+    const char *type_color = relf_section_type_color(shdr->sh_type);
+    const char *flags_color = relf_section_flags_color(shdr->sh_flags);
+    int length = 0;
+    relf_append(buffer,
+                size,
+                &length,
+                "  [%2d] %-17s %s%-16s%s %016lx  %08lx\n",
+                index,
+                section_name,
+                RELF_COLOR(flags, type_color),
+                RELF_section_type(shdr->sh_type),
+                RELF_COLOR_END(flags, type_color),
+                shdr->sh_addr,
+                shdr->sh_offset);
+    relf_append(buffer,
+                size,
+                &length,
+                "       %016lx  %016lx %s%3s%s%8d%6d     %ld\n",
+                shdr->sh_size,     // 段的大小, 对于每一个段可以通过 sh_size 和 对应结构体大小计算表项数量
+                shdr->sh_entsize,  // 段条目的大小
+                RELF_COLOR(flags, flags_color),
+                RELF_section_flags(shdr->sh_flags, section_flags),
+                RELF_COLOR_END(flags, flags_color),
+                shdr->sh_link,  // 对于重定位表(.rela)和符号表(.symtab)
+                shdr->sh_info,  // sh_link 和 sh_info 这两个字段有意义, 其他无意义
+                shdr->sh_addralign);
+    return length;
+}
+
+int RELF_format_symbol(RELF_file *file,
+                       RELF_symbols *span,
+                       RELF_versions *versions,
+                       uint64_t index,
+                       int flags,
+                       char *buffer,
+                       size_t size) {
+    // st_info 的低4位用于符号类型 0-3      => ELF64_ST_TYPE
+    // st_info 的高4位用于符号绑定信息 4-7  => ELF64_ST_BIND
+    Elf64_Sym *sym = &span->symbols[index];
+    char symbol_ndx[RELF_SYMBOL_NDX_SIZE];
+    const char *bind_color = relf_symbol_bind_color(ELF64_ST_BIND(sym->st_info));
+    int length = 0;
+    relf_append(buffer,
+                size,
+                &length,
+                "%6lu: %016lx %5ld %-8s%s%-6s%s %-7s %4s ",
+                index,
+                sym->st_value,
+                sym->st_size,
+                RELF_symbol_type(ELF64_ST_TYPE(sym->st_info)),
+                RELF_COLOR(flags, bind_color),
+                RELF_symbol_bind(ELF64_ST_BIND(sym->st_info)),
+                RELF_COLOR_END(flags, bind_color),
+                RELF_symbol_vis(sym->st_other),  // 用于控制符号可见性
+                RELF_symbol_ndx(sym->st_shndx, symbol_ndx));
+
+    // 符号名 + 版本, 例如 puts@GLIBC_2.2.5 (3), 版本名也占用符号名的显示宽度
+    const char *symbol_name = RELF_symbol_name(file, span, sym);
+    int version_kind = RELF_VERSION_PUBLIC;
+    const char *version = versions ? RELF_symbol_version(versions, index, sym, symbol_name, &version_kind) : NULL;
+    int name_width = 21;
+    char version_index[16] = "";
+    if (version) {
+        if (version_kind == RELF_VERSION_UNDEFINED) {
+            snprintf(version_index, sizeof(version_index), " (%d)", versions->versym[index] & VERSYM_VERSION);
+        }
+        if (!(flags & RELF_FORMAT_WIDE)) {
+            name_width -= 1 + (int)strlen(version) + (int)strlen(version_index);
+            if (version_kind == RELF_VERSION_PUBLIC) {
+                name_width -= 1;
+            }
+        }
+    }
+    relf_append_name(buffer, size, &length, symbol_name, name_width, flags);
+    if (version) {
+        relf_append(buffer,
+                    size,
+                    &length,
+                    "%s%s%s",
+                    version_kind == RELF_VERSION_PUBLIC ? "@@" : "@",
+                    version,
+                    version_index);
+    }
+    relf_append(buffer, size, &length, "\n");
+    return length;
+}
+
+int RELF_format_relocation(RELF_file *file,
+                           RELF_relocations *span,
+                           RELF_versions *versions,
+                           uint64_t index,
+                           int flags,
+                           char *buffer,
+                           size_t size) {
+    Elf64_Addr r_offset;
+    Elf64_Xword r_info;
+    Elf64_Sxword r_addend = 0;
+    if (span->relas) {
+        r_offset = span->relas[index].r_offset;
+        r_info = span->relas[index].r_info;
+        r_addend = span->relas[index].r_addend;
+    } else {
+        r_offset = span->rels[index].r_offset;
+        r_info = span->rels[index].r_info;
+    }
+    int length = 0;
+    relf_append(
+        buffer, size, &length, "%012lx  %012lx %-17.17s", r_offset, r_info, RELF_relocation_type(ELF64_R_TYPE(r_info)));
+    uint64_t symbol_index = ELF64_R_SYM(r_info);
+    if (symbol_index == 0) {
+        // 没有符号, 例如 R_X86_64_RELATIVE, 只有加数
+        if (span->relas) {
+            relf_append(
+                buffer, size, &length, "%20s%s%lx", "", r_addend < 0 ? "-" : "", r_addend < 0 ? -r_addend : r_addend);
+        }
+        relf_append(buffer, size, &length, "\n");
+        return length;
+    }
+    // 通过 r_info 找到对应的符号表对应的符号
+    Elf64_Sym *sym = &span->symbols.symbols[symbol_index];
+    char *symbol_name = RELF_symbol_name(file, &span->symbols, sym);
+    int version_kind = RELF_VERSION_PUBLIC;
+    const char *version =
+        versions ? RELF_symbol_version(versions, symbol_index, sym, symbol_name, &version_kind) : NULL;
+    char short_symbol_name[23];
+    if (!(flags & RELF_FORMAT_WIDE) && strlen(symbol_name) > 22) {
+        // check_argparse_groups
+        // check_argparse_s[...]
+        snprintf(short_symbol_name, sizeof(short_symbol_name), "%.17s[...]", symbol_name);
+        symbol_name = short_symbol_name;
+    }
+    relf_append(buffer, size, &length, " %016lx %s", sym->st_value, symbol_name);
+    // 版本名不计入符号名的宽度, 例如 _ZTVN10__cxxabiv1[...]@@CXXABI_1.3
+    if (version) {
+        relf_append(buffer, size, &length, "%s%s", version_kind == RELF_VERSION_PUBLIC ? "@@" : "@", version);
+    }
+    if (span->relas) {
+        relf_append(buffer, size, &length, " %c %lx", r_addend < 0 ? '-' : '+', r_addend < 0 ? -r_addend : r_addend);
+    }
+    relf_append(buffer, size, &length, "\n");
+    return length;
+}
+
+int RELF_format_segment(RELF_file *file, int index, char *buffer, size_t size) {
+    Elf64_Phdr *phdr = &RELF_segments(file)[index];
+    char segment_flags[RELF_SEGMENT_FLAGS_SIZE];
+    int length = 0;
+    relf_append(buffer,
+                size,
+                &length,
+                "  %-15s0x%016lx 0x%016lx 0x%016lx\n",
+                RELF_segment_type(phdr->p_type),
+                phdr->p_offset,
+                phdr->p_vaddr,
+                phdr->p_paddr);
+    relf_append(buffer,
+                size,
+                &length,
+                "                 0x%016lx 0x%016lx  %-7s0x%lx\n",
+                phdr->p_filesz,
+                phdr->p_memsz,
+                RELF_segment_flags(phdr->p_flags, segment_flags),
+                phdr->p_align);
+    if (phdr->p_type == PT_INTERP) {
+        relf_append(buffer, size, &length, "      [Requesting program interpreter: %s]\n", RELF_interpreter(file));
+    }
+    return length;
+}
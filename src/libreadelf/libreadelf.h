@@ -0,0 +1,311 @@
+/*
+ *Copyright (c) 2023 All rights reserved
+ *@description: 可嵌入的 ELF64 解析库
+ *@author: Zhixing Lu
+ *@date: 2023-11-20
+ *@email: luzhixing12345@163.com
+ *@Github: luzhixing12345
+ */
+
+#ifndef LIBREADELF_H
+#define LIBREADELF_H
+
+#include <elf.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 所有状态都保存在调用者传入的 RELF_file 中, 没有全局变量和静态缓冲区
+// 不同线程可以同时处理不同的文件, 同一个文件只读访问时也可以在线程之间共享
+// 格式化函数和 snprintf 的语义相同: 写入调用者的缓冲区, 返回完整输出需要的长度(不含 '\0')
+
+// glibc 的 elf.h 中没有定义的符号版本相关的宏
+#define VERSYM_HIDDEN 0x8000
+#define VERSYM_VERSION 0x7fff
+#define VER_FLG_INFO 0x4
+
+// glibc 2.36 之前的 elf.h 中没有 RELR
+#ifndef SHT_RELR
+#define SHT_RELR 19
+typedef Elf64_Xword Elf64_Relr;
+#endif
+
+// 校验层: 显示之前把各个表的边界检查一次, 之后的访问函数直接访问校验过的表, 不再逐项检查
+// RELF_validate_headers 检查程序头表, 段表以及每个段描述的范围, 除了段表字符串表的最后一个字节不读取段的内容
+// RELF_validate_tables 检查需要遍历的表的内容, 例如符号名的偏移和重定位的符号索引
+
+#define RELF_CHECK_SYMBOLS 0x1      // 符号表: st_name 和 st_shndx
+#define RELF_CHECK_RELOCATIONS 0x2  // 重定位表(RELA/REL): ELF64_R_SYM 以及对应的符号表
+#define RELF_CHECK_INTERP 0x4       // .interp 以 '\0' 结尾
+#define RELF_CHECK_VERSIONS 0x8     // verdef/verneed 关联的字符串表
+#define RELF_CHECK_ALL (RELF_CHECK_SYMBOLS | RELF_CHECK_RELOCATIONS | RELF_CHECK_INTERP | RELF_CHECK_VERSIONS)
+
+#define RELF_FORMAT_WIDE 0x1   // 不截断过长的名字, 对应 readelf -W/-T
+#define RELF_FORMAT_COLOR 0x2  // 段类型, 段属性和符号绑定带有终端颜色, 对应 readelf --color
+
+#define RELF_ERROR_SIZE 256
+#define RELF_SECTION_FLAGS_SIZE 20  // RELF_section_flags 的缓冲区大小
+#define RELF_SEGMENT_FLAGS_SIZE 4   // RELF_segment_flags 的缓冲区大小
+#define RELF_SYMBOL_NDX_SIZE 10     // RELF_symbol_ndx 的缓冲区大小
+
+typedef struct {
+    void *addr;                   // 文件内容
+    uint64_t size;                // 文件大小, 0 表示未知(例如 --batch 只读入了部分内容)
+    Elf64_Ehdr ehdr;              // ELF头
+    Elf64_Shdr *shdr;             // 段表
+    Elf64_Off shstrtab_offset;    // 段表字符串表相对 addr 的偏移
+    int mapped;                   // addr 由 RELF_open 映射, RELF_close 时释放
+    char error[RELF_ERROR_SIZE];  // 最近一次失败的原因
+} RELF_file;
+
+// 校验之后的符号表
+typedef struct {
+    Elf64_Sym *symbols;
+    uint64_t symbol_number;
+    const char *strtab;  // 以 '\0' 结尾, 所有符号的 st_name 都在范围内
+} RELF_symbols;
+
+// 校验之后的重定位表
+typedef struct {
+    Elf64_Rela *relas;     // SHT_RELA, SHT_REL 时为 NULL
+    Elf64_Rel *rels;       // SHT_REL, 没有 r_addend, SHT_RELA 时为 NULL
+    uint64_t rela_number;  // relas 或 rels 的项数
+    RELF_symbols symbols;  // 所有 ELF64_R_SYM 都小于 symbols.symbol_number
+} RELF_relocations;
+
+// SHT_RELR (-z pack-relative-relocs) 只保存 R_*_RELATIVE 的位置, 加数在被重定位的字中
+// 最低位为 0 的项是一个地址, 之后从 地址 + 8 开始
+// 最低位为 1 的项是位图, 第 i 位 (1-63) 表示 起始地址 + (i - 1) * 8 需要重定位, 之后起始地址增加 63 * 8
+typedef struct {
+    Elf64_Relr *relrs;
+    uint64_t relr_number;
+} RELF_relr;
+
+typedef struct {
+    uint64_t address_number;   // 地址项
+    uint64_t bitmap_number;    // 位图项
+    uint64_t location_number;  // 展开之后的重定位数量
+} RELF_relr_summary;
+
+// 符号版本 (.gnu.version/.gnu.version_d/.gnu.version_r)
+// verdef/verneed 链只解析一次, 展开为 版本索引 -> 版本名 的数组, 之后每个符号只需要一次数组访问
+
+typedef struct {
+    const char *def_name;   // verdef 中 vd_ndx 对应的版本名
+    const char *need_name;  // verneed 中 vna_other 对应的版本名
+    Elf64_Half def_flags;
+    Elf64_Half has_def;
+} RELF_version_name;
+
+typedef struct {
+    Elf64_Half *versym;  // .gnu.version, 与 .dynsym 一一对应
+    uint64_t versym_number;
+    RELF_version_name *names;  // 版本索引 -> 版本名
+    int name_number;
+    int has_verdef;
+    int has_verneed;
+} RELF_versions;
+
+enum RELF_version_kind { RELF_VERSION_PUBLIC, RELF_VERSION_HIDDEN, RELF_VERSION_UNDEFINED };
+
+/**
+ * @brief 打开并映射 ELF64 文件, 检查 ELF 头, 段表以及 checks 指定的表
+ *
+ * @param file
+ * @param path
+ * @param checks RELF_CHECK_* 的组合
+ * @return int 成功返回 0, 失败时 file->error 中保存原因, 不需要调用 RELF_close
+ */
+int RELF_open(RELF_file *file, const char *path, int checks);
+
+/**
+ * @brief 使用调用者提供的一段内存, 例如静态库的成员, 段表直接指向这段内存
+ *
+ * @param file
+ * @param addr
+ * @param size
+ * @param checks RELF_CHECK_* 的组合
+ * @return int 成功返回 0, 失败时 file->error 中保存原因
+ */
+int RELF_open_memory(RELF_file *file, void *addr, uint64_t size, int checks);
+
+/**
+ * @brief 释放 RELF_open 映射的内存, RELF_open_memory 的内存由调用者管理
+ *
+ * @param file
+ */
+void RELF_close(RELF_file *file);
+
+/**
+ * @brief 检查 ELF 头描述的程序头表, 段表以及段的范围
+ *
+ * @param file shdr 为 NULL 时只检查程序头表
+ * @param file_size
+ * @return int 合法返回 0, 否则 file->error 中保存原因
+ */
+int RELF_validate_headers(RELF_file *file, uint64_t file_size);
+
+/**
+ * @brief 检查需要遍历的表的内容, 需要先通过 RELF_validate_headers
+ *
+ * @param file
+ * @param checks RELF_CHECK_* 的组合
+ * @return int 合法返回 0, 否则 file->error 中保存原因
+ */
+int RELF_validate_tables(RELF_file *file, int checks);
+
+/**
+ * @brief 段名, 需要先通过 RELF_validate_headers
+ */
+char *RELF_section_name(RELF_file *file, Elf64_Shdr *shdr);
+
+/**
+ * @brief 获取字符串表 strtab_index 中 offset 处的字符串
+ *
+ * @return const char* 越界返回 NULL
+ */
+const char *RELF_string(RELF_file *file, Elf64_Word strtab_index, Elf64_Word offset);
+
+/**
+ * @brief 程序头表, 需要先通过 RELF_validate_headers
+ *
+ * @return Elf64_Phdr* 共 ehdr.e_phnum 项, 没有程序头表时返回 NULL
+ */
+Elf64_Phdr *RELF_segments(RELF_file *file);
+
+/**
+ * @brief .interp 中的程序解释器, 需要先通过 RELF_validate_tables(RELF_CHECK_INTERP)
+ *
+ * @return const char* 没有 .interp 时返回 ""
+ */
+const char *RELF_interpreter(RELF_file *file);
+
+/**
+ * @brief 符号表, 需要先通过 RELF_validate_tables(RELF_CHECK_SYMBOLS)
+ */
+RELF_symbols RELF_symbol_span(RELF_file *file, Elf64_Shdr *shdr);
+
+/**
+ * @brief 符号名, st_name 为 0 的符号 (不包括 ABS) 使用 st_shndx 对应的段名
+ */
+char *RELF_symbol_name(RELF_file *file, RELF_symbols *span, Elf64_Sym *sym);
+
+/**
+ * @brief 重定位表, 需要先通过 RELF_validate_tables(RELF_CHECK_RELOCATIONS)
+ */
+RELF_relocations RELF_rela_span(RELF_file *file, Elf64_Shdr *shdr);
+
+/**
+ * @brief RELR 表, 只需要 RELF_validate_headers
+ */
+RELF_relr RELF_relr_span(RELF_file *file, Elf64_Shdr *shdr);
+
+/**
+ * @brief 统计 RELR 表的项和展开之后的重定位数量, 不展开
+ *
+ * @param span
+ * @param summary
+ */
+void RELF_relr_summarize(RELF_relr *span, RELF_relr_summary *summary);
+
+/**
+ * @brief 展开 RELR 表, 按照表中的顺序写入每一个需要重定位的地址
+ *
+ * @param span
+ * @param addresses 至少 RELF_relr_summarize 得到的 location_number 项
+ * @return uint64_t 写入的地址数量
+ */
+uint64_t RELF_relr_expand(RELF_relr *span, Elf64_Addr *addresses);
+
+/**
+ * @brief 解析符号版本信息, 需要先通过 RELF_validate_tables(RELF_CHECK_VERSIONS)
+ *
+ * @param file
+ * @param versions 需要调用 RELF_free_versions 释放
+ */
+void RELF_build_versions(RELF_file *file, RELF_versions *versions);
+
+void RELF_free_versions(RELF_versions *versions);
+
+/**
+ * @brief 获取 .dynsym 中第 index 个符号的版本名
+ *
+ * @param versions
+ * @param index 符号在 .dynsym 中的下标
+ * @param sym
+ * @param name 符号名, 和版本名相同的 SHN_ABS 符号是版本定义本身, 不输出版本
+ * @param kind 输出版本的类型: 定义(公开/隐藏) 或 引用
+ * @return const char* 没有版本时返回 NULL
+ */
+const char *RELF_symbol_version(
+    RELF_versions *versions, uint64_t index, Elf64_Sym *sym, const char *name, int *kind);
+
+// 各个字段的名字, 需要缓冲区的函数把结果写入 buffer 并返回 buffer
+
+char *RELF_section_type(Elf64_Word section_type);
+char *RELF_section_flags(Elf64_Xword section_flag, char *buffer);
+char *RELF_symbol_type(int st_info);
+char *RELF_symbol_bind(int st_info);
+char *RELF_symbol_vis(int st_other);
+char *RELF_symbol_ndx(Elf64_Section st_shndx, char *buffer);
+char *RELF_relocation_type(int type);
+char *RELF_segment_type(uint32_t p_type);
+char *RELF_segment_flags(uint32_t p_flags, char *buffer);
+
+/**
+ * @brief 格式化第 index 个段, 与 readelf -S 的一项相同(两行)
+ *
+ * @param file
+ * @param index
+ * @param flags RELF_FORMAT_* 的组合
+ * @param buffer
+ * @param size
+ * @return int 完整输出需要的长度
+ */
+int RELF_format_section(RELF_file *file, int index, int flags, char *buffer, size_t size);
+
+/**
+ * @brief 格式化符号表中第 index 个符号, 与 readelf -s 的一行相同
+ *
+ * @param file
+ * @param span
+ * @param versions 只用于 .dynsym, 为 NULL 时不输出版本
+ * @param index
+ * @param flags RELF_FORMAT_* 的组合
+ * @param buffer
+ * @param size
+ * @return int 完整输出需要的长度
+ */
+int RELF_format_symbol(RELF_file *file,
+                       RELF_symbols *span,
+                       RELF_versions *versions,
+                       uint64_t index,
+                       int flags,
+                       char *buffer,
+                       size_t size);
+
+/**
+ * @brief 格式化重定位表中第 index 项, 与 readelf -r 的一行相同
+ *
+ * @param file
+ * @param span
+ * @param versions 只用于关联 .dynsym 的重定位表, 为 NULL 时不输出版本
+ * @param index
+ * @param flags RELF_FORMAT_* 的组合
+ * @param buffer
+ * @param size
+ * @return int 完整输出需要的长度
+ */
+int RELF_format_relocation(RELF_file *file,
+                           RELF_relocations *span,
+                           RELF_versions *versions,
+                           uint64_t index,
+                           int flags,
+                           char *buffer,
+                           size_t size);
+
+/**
+ * @brief 格式化第 index 个程序头, 与 readelf -l 的一项相同, PT_INTERP 带有程序解释器
+ */
+int RELF_format_segment(RELF_file *file, int index, char *buffer, size_t size);
+
+#endif  // LIBREADELF_H
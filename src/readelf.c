@@ -10,30 +10,132 @@
 // GNU binutils-readelf:
 // https://sourceware.org/git/?p=binutils-gdb.git;a=blob;f=binutils/readelf.c;h=a05c75fc1c8e1ae7b49236e10ddbf16c626c51d9;hb=HEAD
 
+#include <ar.h>
 #include <elf.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <fnmatch.h>
+#include <pthread.h>
+#include <regex.h>
+#include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <sys/inotify.h>
 #include <sys/mman.h>
+#include <sys/procfs.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <sys/types.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <linux/stat.h>
+
+#include "libreadelf/libreadelf.h"
 #include "xbox/xargparse.h"
+#include "xbox/xstring.h"
+#include "xbox/xterm.h"
+#include "xbox/xuring.h"
+#include "xbox/xutils.h"
+#include "xbox/xwriter.h"
 
 static const char *VERSION = "v0.0.1";
 
 #define ELF_PRINT_FORMAT "  %-35s%s\n"
 
-static char error_info[1024];
-static int display_header = 0;
-static int display_section_table = 0;
-static int display_symbol_table = 0;
-static int display_relocations = 0;
-static int display_program_header = 0;
-static int truncated = 0;
+#define SYMBOL_FILTER_MAX_NDX 16  // --filter ndx= 最多列出的段索引数量
+
+// --filter 编译之后的符号过滤条件, 所有条件都满足的符号才会输出
+// type/bind/vis 是位掩码, 判断时直接使用 Elf64_Sym 的字段, 只有存在名字条件时才查找符号名
+typedef struct {
+    uint16_t type_mask;  // 1 << STT_*
+    uint16_t bind_mask;  // 1 << STB_*
+    uint8_t vis_mask;    // 1 << STV_*
+    int ndx_number;      // 0 表示不限制段索引
+    Elf64_Section ndx[SYMBOL_FILTER_MAX_NDX];
+    uint64_t size_min;
+    uint64_t size_max;
+    const char *name_glob;  // 指向 argv
+    int has_name_regex;
+    regex_t name_regex;
+} SymbolFilter;
+
+// --sort 的排序方式
+enum symbol_sort_kind { SYMBOL_SORT_NONE, SYMBOL_SORT_ADDR, SYMBOL_SORT_SIZE, SYMBOL_SORT_NAME };
+
+// --io 读取输入文件的方式
+enum io_strategy { IO_MMAP, IO_POPULATE, IO_SEQUENTIAL, IO_HUGEPAGE, IO_PREAD, IO_STRATEGY_NUMBER };
+
+static const char *io_strategy_names[IO_STRATEGY_NUMBER] = {"mmap", "populate", "sequential", "hugepage", "pread"};
+
+// 命令行选项, 由 main 解析之后以指针的形式传给需要的函数
+typedef struct {
+    int display_header;
+    int display_section_table;
+    int display_symbol_table;
+    int display_relocations;
+    int relr_summary;  // -r 只统计 RELR 表, 不展开
+    int display_reloc_stats;
+    int display_program_header;
+    int truncated;
+    int display_dynamic_symbol_table;
+    int display_version_info;
+    int display_build_id;
+    int display_io_stats;
+    int display_batch;
+    int batch_queue_depth;
+    char *build_id_index_dir;
+    char *build_id_index_file;
+    char *build_id_lookup;
+    char *diff_old_file;
+    int display_bloat;
+    int jobs;
+    char *lookup_symbol;
+    int display_core;
+    char *files_from;
+    char *watch_dir;
+    int no_dedup;
+    char *io_name;
+    int io_strategy;  // enum io_strategy
+    int io_bench;
+    char *color_when;
+    int color;  // 解析 --color 之后是否输出颜色
+    char **filters;
+    SymbolFilter *symbol_filter;  // 解析 --filter 之后的过滤条件, NULL 表示输出所有符号
+    char *sort_key;
+    int symbol_sort;  // enum symbol_sort_kind
+    int top_number;   // --top, 0 表示输出所有的项
+} ReadelfOptions;
+
+// libreadelf 的格式化函数按 snprintf 的语义返回需要的长度, 行太长时分配足够的空间重新格式化
+#define PRINT_FORMATTED(format_function, ...)                        \
+    do {                                                             \
+        char row[1024];                                              \
+        int length = format_function(__VA_ARGS__, row, sizeof(row)); \
+        if (length < (int)sizeof(row)) {                             \
+            fputs(row, stdout);                                      \
+        } else {                                                     \
+            char *long_row = malloc(length + 1);                     \
+            format_function(__VA_ARGS__, long_row, length + 1);      \
+            fputs(long_row, stdout);                                 \
+            free(long_row);                                          \
+        }                                                            \
+    } while (0)
+
+#define BUILD_ID_MAX_SIZE 32                    // build-id 一般为 20 字节(sha1)
+#define BUILD_ID_NOTE_MAX_SIZE (1024 * 1024)    // PT_NOTE 段的最大读取长度
+#define BUILD_ID_INDEX_DEFAULT_FILE "build-id.idx"
+#define BATCH_DEFAULT_QUEUE_DEPTH 256
+#ifndef AT_EMPTY_PATH
+#define AT_EMPTY_PATH 0x1000  // <fcntl.h> 只在 _GNU_SOURCE 下定义, statx 对 fd 本身取属性
+#endif
+#define BLOAT_TOP_NUMBER 20  // --bloat 每张表默认输出的条数
+#define FILE_LIST_BUFFER_SIZE (64 * 1024)  // @listfile 和 --files-from 每次读取的大小
 
 // 下面是一些奇奇怪怪的宏, 用于判断 program header 中最后的 Segment Sections
 
@@ -110,12 +212,127 @@ static int is_pie() {
     return 1;
 }
 
-typedef struct ELF {
-    void *addr;
-    Elf64_Ehdr ehdr;   // ELF头
-    Elf64_Shdr *shdr;  // 段表
-    Elf64_Off shstrtab_offset;
-} ELF;
+typedef RELF_file ELF;
+
+// stdout 不是终端时, 输出先写入 XBOX_writer 的缓冲区, 由写线程写到 fd, 格式化和 write 并行
+// stdout 被替换为写入 output_writer 的 FILE, 所有 printf 都不需要修改
+static XBOX_writer output_writer;
+static int output_writer_active;
+static FILE *output_original_stdout;
+
+/**
+ * @brief 结束异步输出, 写出剩余的数据
+ *
+ * @return int 写失败返回 1
+ */
+static int output_finish(void) {
+    if (!output_writer_active) {
+        return 0;
+    }
+    output_writer_active = 0;
+    fclose(stdout);
+    stdout = output_original_stdout;
+    int error = XBOX_writer_close(&output_writer);
+    if (error) {
+        fprintf(stderr, "readelf Error: write fail: %s\n", strerror(-error));
+        return 1;
+    }
+    return 0;
+}
+
+static void output_finish_at_exit(void) {
+    output_finish();
+}
+
+/**
+ * @brief stdout 不是终端时启动异步输出, 失败时继续使用原来的 stdout
+ *        只有一个 CPU 时写线程无法和格式化并行, 只会多一次复制, 不启用
+ */
+static void output_start(void) {
+    if (isatty(STDOUT_FILENO) || sysconf(_SC_NPROCESSORS_ONLN) < 2 ||
+        XBOX_writer_init(&output_writer, STDOUT_FILENO)) {
+        return;
+    }
+    FILE *stream = XBOX_writer_stream(&output_writer);
+    if (!stream) {
+        XBOX_writer_close(&output_writer);
+        return;
+    }
+    fflush(stdout);
+    output_original_stdout = stdout;
+    stdout = stream;
+    output_writer_active = 1;
+    // exit 时先执行 atexit 再刷新 stdio, 这里把剩余的数据写出
+    atexit(output_finish_at_exit);
+}
+
+/**
+ * @brief 等待之前的输出全部写到 fd, 例如 fork 之前
+ */
+static void output_flush(void) {
+    fflush(stdout);
+    if (output_writer_active) {
+        XBOX_writer_flush(&output_writer);
+    }
+}
+
+/**
+ * @brief fork 之后的子进程中没有写线程, 之后的输出直接写到 fd
+ */
+static void output_detach(void) {
+    if (output_writer_active) {
+        XBOX_writer_detach(&output_writer);
+    }
+}
+
+/**
+ * @brief -W/-T 和 --color 对应的 RELF_FORMAT_* 组合
+ */
+static int format_flags(ReadelfOptions *options) {
+    return (options->truncated ? RELF_FORMAT_WIDE : 0) | (options->color ? RELF_FORMAT_COLOR : 0);
+}
+
+/**
+ * @brief 解析 --color 的参数, 与 ls --color 相同
+ *
+ * @param when
+ * @return int 输出颜色返回 1, 不输出返回 0, 参数不合法返回 -1
+ */
+static int parse_color_option(const char *when) {
+    if (!strcmp(when, "always") || !strcmp(when, "yes") || !strcmp(when, "force")) {
+        return 1;
+    }
+    if (!strcmp(when, "never") || !strcmp(when, "no") || !strcmp(when, "none")) {
+        return 0;
+    }
+    if (!strcmp(when, "auto") || !strcmp(when, "tty") || !strcmp(when, "if-tty")) {
+        return isatty(STDOUT_FILENO);
+    }
+    return -1;
+}
+
+/**
+ * @brief 当前选项需要的 RELF_CHECK_* 组合
+ */
+static int elf_display_checks(ReadelfOptions *options) {
+    int checks = 0;
+    if (options->display_symbol_table || options->display_dynamic_symbol_table) {
+        checks |= RELF_CHECK_SYMBOLS;
+    }
+    if (options->display_relocations) {
+        checks |= RELF_CHECK_RELOCATIONS | RELF_CHECK_VERSIONS;
+    }
+    if (options->display_reloc_stats) {
+        checks |= RELF_CHECK_RELOCATIONS;
+    }
+    if (options->display_program_header) {
+        checks |= RELF_CHECK_INTERP;
+    }
+    if (options->display_version_info || options->display_dynamic_symbol_table || options->display_symbol_table) {
+        checks |= RELF_CHECK_VERSIONS;
+    }
+    return checks;
+}
 
 /**
  * @brief readelf -h 读取并输出 ELF 文件头信息
@@ -404,127 +621,15 @@ int display_elf_header(ELF *ELF_file_data) {
 }
 
 /**
- * @brief 获取段类型
- *
- * @param section_type
- * @return char*
+ * @brief --top 的顺序: 大小从大到小, 大小相同时按段表中的顺序
  */
-char *getSectionType(Elf64_Word section_type) {
-    switch (section_type) {
-        case SHT_NULL:
-            return "NULL";
-        case SHT_PROGBITS:
-            // 该部分保存由程序定义的信息,其格式和含义完全由程序决定.
-            // 其格式和含义完全由程序决定
-            return "PROGBITS";
-        case SHT_SYMTAB:
-            // 符号表
-            return "SYMTAB";
-        case SHT_STRTAB:
-            // 字符串表
-            return "STRTAB";
-        case SHT_RELA:
-            // 有明确后缀的重定位条目
-            return "RELA";
-        case SHT_HASH:
-            // hash 表
-            return "HASH";
-        case SHT_DYNAMIC:
-            // 动态链接
-            return "DYNAMIC";
-        case SHT_NOTE:
-            // 包含以某种方式标记文件的信息
-            // 比如 .note.gnu.propert
-            return "NOTE";
-        case SHT_NOBITS:
-            // 文件中不占空间
-            // bss
-            return "NOBITS";
-        case SHT_REL:
-            // 没有明确后缀的重定位条目
-            return "REL";
-        case SHT_DYNSYM:
-            // 符号表
-            return "DYNSYM";
-        case SHT_SHLIB:
-            // 保留
-            return "";
-            // 这里其实有一大堆 GNU 的扩展符号
-            // https://sourceware.org/git/?p=binutils-gdb.git;a=blob;f=binutils/readelf.c;h=b872876a8b660be19e1ffc66ee300d0bbfaed345;hb=HEAD#l4942
-        case SHT_INIT_ARRAY:
-            return "INIT_ARRAY";
-        case SHT_FINI_ARRAY:
-            return "FINI_ARRAY";
-        case SHT_PREINIT_ARRAY:
-            return "PREINIT_ARRAY";
-        case SHT_GNU_HASH:
-            return "GNU_HASH";
-        case SHT_GROUP:
-            return "GROUP";
-        case SHT_SYMTAB_SHNDX:
-            return "SYMTAB SECTION INDICES";
-        case SHT_GNU_verdef:
-            return "VERDEF";
-        case SHT_GNU_verneed:
-            return "VERNEED";
-        case SHT_GNU_versym:
-            return "VERSYM";
-        case 0x6ffffff0:
-            return "VERSYM";
-        case 0x6ffffffc:
-            return "VERDEF";
-        case 0x7ffffffd:
-            return "AUXILIARY";
-        case 0x7fffffff:
-            return "FILTER";
-        case SHT_GNU_LIBLIST:
-            return "GNU_LIBLIST";
-        default:
-            return "";
+static int section_size_cmp(const void *a, const void *b) {
+    const Elf64_Shdr *x = (const Elf64_Shdr *)a;
+    const Elf64_Shdr *y = (const Elf64_Shdr *)b;
+    if (x->sh_size != y->sh_size) {
+        return x->sh_size > y->sh_size ? -1 : 1;
     }
-}
-
-/**
- * @brief 获取段标记位信息
- *
- * @param section_flag
- * @return char*
- */
-char *getSectionFlag(Elf64_Xword section_flag) {
-    // https://sourceware.org/git?p=binutils-gdb.git;a=blob;f=binutils/readelf.c;h=b872876a8b660be19e1ffc66ee300d0bbfaed345;hb=HEAD#l6812
-
-    // SHF_WRITE:段内容可以被写入.
-    // SHF_ALLOC:段在程序执行时被分配内存.
-    // SHF_EXECINSTR:段包含可执行指令.
-    // SHF_MASKPROC:该位由处理器架构定义.
-    static char flags[20];
-    char *p = flags;
-    if (section_flag & SHF_WRITE)
-        *p++ = 'W';
-    if (section_flag & SHF_ALLOC)
-        *p++ = 'A';
-    if (section_flag & SHF_EXECINSTR)
-        *p++ = 'X';
-    if (section_flag & SHF_MERGE)
-        *p++ = 'M';
-    if (section_flag & SHF_STRINGS)
-        *p++ = 'S';
-    if (section_flag & SHF_INFO_LINK)
-        *p++ = 'I';
-    if (section_flag & SHF_LINK_ORDER)
-        *p++ = 'L';
-    if (section_flag & SHF_OS_NONCONFORMING)
-        *p++ = 'O';
-    if (section_flag & SHF_GROUP)
-        *p++ = 'G';
-    if (section_flag & SHF_TLS)
-        *p++ = 'T';
-    if (section_flag & SHF_EXCLUDE)
-        *p++ = 'E';
-    if (section_flag & SHF_COMPRESSED)
-        *p++ = 'C';
-    *p = 0;
-    return flags;
+    return x < y ? -1 : x > y;
 }
 
 /**
@@ -533,7 +638,7 @@ char *getSectionFlag(Elf64_Xword section_flag) {
  * @param ELF_file_data
  * @return int
  */
-int display_elf_section_table(ELF *ELF_file_data) {
+int display_elf_section_table(ELF *ELF_file_data, ReadelfOptions *options) {
     int section_number = ELF_file_data->ehdr.e_shnum;
     printf("There are %d section headers, starting at offset 0x%lx:\n", section_number, ELF_file_data->ehdr.e_shoff);
 
@@ -541,37 +646,24 @@ int display_elf_section_table(ELF *ELF_file_data) {
 
     printf("  [Nr] Name              Type             Address           Offset\n");
     printf("       Size              EntSize          Flags  Link  Info  Align\n");
-    for (int i = 0; i < section_number; i++) {
-        Elf64_Shdr *shdr = &ELF_file_data->shdr[i];
-        char number[3] = " x";
-        if (i / 10) {
-            number[0] = '0' + i / 10;
-        }
-        number[1] = '0' + i % 10;
-
-        char *section_type = getSectionType(shdr->sh_type);
-        char *section_flag = getSectionFlag(shdr->sh_flags);
-        // 段名的获取方式是通过 shstrtab + sh_name(偏移地址) 得到的
-        char *section_name = (char *)((char *)ELF_file_data->addr + ELF_file_data->shstrtab_offset + shdr->sh_name);
-
-        // 过长的字符串输出截断
-        // readelf -S examples/SimpleSection.o
-        if (!truncated && strlen(section_name) > 16) {
-            char short_section_name[18];
-            strncpy(short_section_name, section_name, 12);
-            strncpy(short_section_name + 12, "[...]", 6);
-            short_section_name[17] = 0;
-            section_name = short_section_name;
-        }
-        printf(
-            "  [%2s] %-17s %-16s %016lx  %08lx\n", number, section_name, section_type, shdr->sh_addr, shdr->sh_offset);
-        printf("       %016lx  %016lx %3s%8d%6d     %ld\n",
-               shdr->sh_size,  // 段的大小, 对于每一个段可以通过 sh_size 和 对应结构体大小计算表项数量
-               shdr->sh_entsize,  // 段条目的大小
-               section_flag,
-               shdr->sh_link,  // 对于重定位表(.rela)和符号表(.symtab)
-               shdr->sh_info,  // sh_link 和 sh_info 这两个字段有意义, 其他无意义
-               shdr->sh_addralign);
+    if (options->top_number) {
+        // 只输出最大的 N 个段, 按大小从大到小
+        XBOX_TopHeap heap;
+        int capacity = options->top_number < section_number ? options->top_number : section_number;
+        XBOX_top_init(&heap, (size_t)capacity, section_size_cmp);
+        for (int i = 0; i < section_number; i++) {
+            XBOX_top_push(&heap, &ELF_file_data->shdr[i]);
+        }
+        uint64_t number = XBOX_top_finish(&heap);
+        for (uint64_t i = 0; i < number; i++) {
+            int index = (int)((Elf64_Shdr *)heap.items[i] - ELF_file_data->shdr);
+            PRINT_FORMATTED(RELF_format_section, ELF_file_data, index, format_flags(options));
+        }
+        XBOX_top_free(&heap);
+    } else {
+        for (int i = 0; i < section_number; i++) {
+            PRINT_FORMATTED(RELF_format_section, ELF_file_data, i, format_flags(options));
+        }
     }
 
     printf("Key to Flags:\n");
@@ -583,96 +675,346 @@ int display_elf_section_table(ELF *ELF_file_data) {
 }
 
 /**
- * @brief 符号表中的符号类型
+ * @brief 解析十进制或 0x 开头的十六进制数
  *
- * @param st_info
- * @return char*
+ * @return int 成功返回 0
  */
-char *get_symbol_type(int st_info) {
-    switch (st_info) {
-        case STT_NOTYPE:
-            // 符号类型未指定, 未知的一些符号比如 printf
-            return "NOTYPE";
-        case STT_OBJECT:
-            // 符号与数据对象相关联,如变量、数组等等.
-            return "OBJECT";
-        case STT_FUNC:
-            // 符号与函数或其他可执行代码相关联
-            return "FUNC";
-        case STT_SECTION:
-            // 该符号与一个章节相关联.这种类型的符号表项主要用于重新定位,通常与 STB_LOCAL 绑定.
-            return "SECTION";
-        case STT_FILE:
-            // 文件符号具有 STB_LOCAL 绑定功能,其分区索引为 SHN_ABS,如果存在,则位于文件的其他 STB_LOCAL 符号之前.
-            // 如果存在,它位于文件的其他 STB_LOCAL 符号之前
-            return "FILE";
-        case STT_COMMON:
-            // 符号是一种常见的数据对象
-            return "COMMON";
-        case STT_TLS:
-            // 符号是线程本地数据对象
-            return "TLS";
-        default:
-            return "UNKNOWN";
-    }
-}
-
-char *get_symbol_bind(int st_info) {
-    switch (st_info) {
-        case STB_LOCAL:
-            // 本地符号在包含其定义的对象文件之外是不可见的.
-            // 定义的对象文件外是不可见的.同名的局部符号可存在于多个文件中
-            // 而不会相互干扰.
-            return "LOCAL";
-        case STB_GLOBAL:
-            // 全局符号对合并的所有对象文件都是可见的.一个文件的
-            // 全局符号的定义将满足另一个文件对同一全局符号的未定义引用.
-            // 对同一全局符号的未定义引用.
-            return "GLOBAL";
-        case STB_WEAK:
-            // 弱符号类似于全局符号,但其定义的优先级较低.
-            return "WEAK";
-        default:
-            return "UNKNOWN";
+static int symbol_filter_number(XBOX_str str, uint64_t *value) {
+    int base = 10;
+    size_t i = 0;
+    if (str.length > 2 && str.data[0] == '0' && (str.data[1] == 'x' || str.data[1] == 'X')) {
+        base = 16;
+        i = 2;
+    }
+    if (i == str.length) {
+        return -1;
+    }
+    *value = 0;
+    for (; i < str.length; i++) {
+        char c = str.data[i];
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (base == 16 && ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')) {
+            digit = (c | 0x20) - 'a' + 10;
+        } else {
+            return -1;
+        }
+        *value = *value * base + digit;
     }
+    return 0;
 }
 
-char *get_symbol_vis(int st_other) {
-    switch (st_other) {
-        case STV_DEFAULT:
-            return "DEFAULT";
-        case STV_INTERNAL:
-            return "INTERNAL";
-        case STV_HIDDEN:
-            return "HIDDEN";
-        case STV_PROTECTED:
-            return "PROTECTED";
-        default:
-            return "UNKNOWN";
+/**
+ * @brief 把 type/bind/vis 的名字列表转换为位掩码, 名字与 readelf -s 的输出相同, 不区分大小写
+ *
+ * @param values 逗号分隔的名字
+ * @param get_name RELF_symbol_type 等
+ * @param number 字段的取值范围
+ * @return int 成功返回位掩码, 有不认识的名字时返回 -1
+ */
+static int symbol_filter_mask(XBOX_str values, char *(*get_name)(int), int number) {
+    int mask = 0;
+    XBOX_str_split split;
+    XBOX_str token;
+    XBOX_str_split_init(&split, values, ',');
+    while (XBOX_str_split_next(&split, &token)) {
+        token = XBOX_str_trim(token);
+        int found = 0;
+        for (int i = 0; i < number; i++) {
+            const char *name = get_name(i);
+            if (strcmp(name, "UNKNOWN") && !strncasecmp(name, token.data, token.length) &&
+                name[token.length] == '\0') {
+                mask |= 1 << i;
+                found = 1;
+            }
+        }
+        if (!found) {
+            return -1;
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief 解析 ndx= 的段索引列表, UND/ABS/COM 或者数字
+ *
+ * @return int 成功返回 0
+ */
+static int symbol_filter_ndx(SymbolFilter *filter, XBOX_str values) {
+    XBOX_str_split split;
+    XBOX_str token;
+    XBOX_str_split_init(&split, values, ',');
+    while (XBOX_str_split_next(&split, &token)) {
+        token = XBOX_str_trim(token);
+        uint64_t ndx;
+        if (token.length == 3 && !strncasecmp(token.data, "UND", 3)) {
+            ndx = SHN_UNDEF;
+        } else if (token.length == 3 && !strncasecmp(token.data, "ABS", 3)) {
+            ndx = SHN_ABS;
+        } else if (token.length == 3 && !strncasecmp(token.data, "COM", 3)) {
+            ndx = SHN_COMMON;
+        } else if (symbol_filter_number(token, &ndx) || ndx > 0xffff) {
+            return -1;
+        }
+        if (filter->ndx_number == SYMBOL_FILTER_MAX_NDX) {
+            return -1;
+        }
+        filter->ndx[filter->ndx_number++] = (Elf64_Section)ndx;
+    }
+    return 0;
+}
+
+/**
+ * @brief 解析 size 的条件: size=N, size=MIN-MAX (两端都可以省略), size<N, size<=N, size>N, size>=N
+ *
+ * @return int 成功返回 0
+ */
+static int symbol_filter_size(SymbolFilter *filter, const char *op, XBOX_str value) {
+    uint64_t min = 0, max = UINT64_MAX;
+    if (op[0] == '=') {
+        long dash = XBOX_str_find(value, '-', 0);
+        XBOX_str low = dash < 0 ? value : XBOX_str_sub(value, 0, (size_t)dash);
+        XBOX_str high = dash < 0 ? value : XBOX_str_sub(value, (size_t)dash + 1, value.length);
+        if ((low.length && symbol_filter_number(low, &min)) || (high.length && symbol_filter_number(high, &max)) ||
+            (!low.length && !high.length)) {
+            return -1;
+        }
+    } else {
+        uint64_t n;
+        if (symbol_filter_number(value, &n)) {
+            return -1;
+        }
+        int equal = op[1] == '=';
+        if (op[0] == '<') {
+            if (!equal && n == 0) {
+                return -1;
+            }
+            max = equal ? n : n - 1;
+        } else {
+            if (!equal && n == UINT64_MAX) {
+                return -1;
+            }
+            min = equal ? n : n + 1;
+        }
+    }
+    // 多个 size 条件取交集
+    filter->size_min = MAX(filter->size_min, min);
+    filter->size_max = filter->size_max < max ? filter->size_max : max;
+    return 0;
+}
+
+/**
+ * @brief 编译一个 --filter 条件, 多个条件之间是 "并且" 的关系
+ *
+ * @param filter
+ * @param term 例如 type=FUNC,OBJECT bind=GLOBAL vis=DEFAULT ndx=UND size=16-64 name=str* name~^mem
+ * @return int 成功返回 0, 失败时输出原因
+ */
+static int symbol_filter_add(SymbolFilter *filter, const char *term) {
+    size_t field_length = strcspn(term, "=~<>");
+    XBOX_str field = XBOX_str_sub(XBOX_str_from(term), 0, field_length);
+    const char *op = term + field_length;
+    const char *value = op[0] && op[1] == '=' ? op + 2 : op + 1;
+    int result = -1;
+    if (op[0] == '\0') {
+        fprintf(stderr, "readelf Error: invalid filter '%s', expect FIELD=VALUE\n", term);
+        return -1;
+    }
+    if (op[0] == '=' && (XBOX_str_equal(field, "type") || XBOX_str_equal(field, "bind") ||
+                         XBOX_str_equal(field, "vis"))) {
+        int mask;
+        if (field.data[0] == 't') {
+            mask = symbol_filter_mask(XBOX_str_from(value), RELF_symbol_type, 16);
+            filter->type_mask &= mask;
+        } else if (field.data[0] == 'b') {
+            mask = symbol_filter_mask(XBOX_str_from(value), RELF_symbol_bind, 16);
+            filter->bind_mask &= mask;
+        } else {
+            mask = symbol_filter_mask(XBOX_str_from(value), RELF_symbol_vis, 4);
+            filter->vis_mask &= mask;
+        }
+        result = mask < 0 ? -1 : 0;
+    } else if (op[0] == '=' && XBOX_str_equal(field, "ndx")) {
+        result = symbol_filter_ndx(filter, XBOX_str_from(value));
+    } else if ((op[0] == '=' || op[0] == '<' || op[0] == '>') && op[1] != '~' && XBOX_str_equal(field, "size")) {
+        result = symbol_filter_size(filter, op, XBOX_str_from(value));
+    } else if (op[0] == '=' && XBOX_str_equal(field, "name") && !filter->name_glob) {
+        filter->name_glob = value;
+        result = 0;
+    } else if (op[0] == '~' && XBOX_str_equal(field, "name") && !filter->has_name_regex) {
+        int error = regcomp(&filter->name_regex, value, REG_EXTENDED | REG_NOSUB);
+        if (error) {
+            char message[256];
+            regerror(error, &filter->name_regex, message, sizeof(message));
+            fprintf(stderr, "readelf Error: invalid regular expression '%s': %s\n", value, message);
+            return -1;
+        }
+        filter->has_name_regex = 1;
+        result = 0;
+    }
+    if (result) {
+        fprintf(stderr,
+                "readelf Error: invalid filter '%s', expect type=, bind=, vis=, ndx=, size=, size<, size>, name= or "
+                "name~ (at most one name= and one name~)\n",
+                term);
+    }
+    return result;
+}
+
+static void symbol_filter_free(SymbolFilter *filter) {
+    if (filter->has_name_regex) {
+        regfree(&filter->name_regex);
+    }
+}
+
+/**
+ * @brief 编译所有 --filter 条件
+ *
+ * @return int 成功返回 0
+ */
+static int symbol_filter_compile(SymbolFilter *filter, char **terms, int term_number) {
+    memset(filter, 0, sizeof(SymbolFilter));
+    filter->type_mask = 0xffff;
+    filter->bind_mask = 0xffff;
+    filter->vis_mask = 0xff;
+    filter->size_max = UINT64_MAX;
+    for (int i = 0; i < term_number; i++) {
+        if (symbol_filter_add(filter, terms[i])) {
+            symbol_filter_free(filter);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 符号是否满足所有过滤条件, 先比较 Elf64_Sym 的字段, 最后才查找符号名
+ */
+static int symbol_filter_match(SymbolFilter *filter, ELF *ELF_file_data, RELF_symbols *span, Elf64_Sym *sym) {
+    if (!((filter->type_mask >> ELF64_ST_TYPE(sym->st_info)) & 1) ||
+        !((filter->bind_mask >> ELF64_ST_BIND(sym->st_info)) & 1) ||
+        !((filter->vis_mask >> ELF64_ST_VISIBILITY(sym->st_other)) & 1) || sym->st_size < filter->size_min ||
+        sym->st_size > filter->size_max) {
+        return 0;
+    }
+    if (filter->ndx_number) {
+        int found = 0;
+        for (int i = 0; i < filter->ndx_number && !found; i++) {
+            found = filter->ndx[i] == sym->st_shndx;
+        }
+        if (!found) {
+            return 0;
+        }
+    }
+    if (filter->name_glob || filter->has_name_regex) {
+        const char *name = RELF_symbol_name(ELF_file_data, span, sym);
+        if (filter->name_glob && fnmatch(filter->name_glob, name, 0)) {
+            return 0;
+        }
+        if (filter->has_name_regex && regexec(&filter->name_regex, name, 0, NULL, 0)) {
+            return 0;
+        }
     }
+    return 1;
+}
+
+/**
+ * @brief --top 的顺序: 大小从大到小, 大小相同时按符号表中的顺序
+ */
+static int symbol_size_cmp(const void *a, const void *b) {
+    const Elf64_Sym *x = (const Elf64_Sym *)a;
+    const Elf64_Sym *y = (const Elf64_Sym *)b;
+    if (x->st_size != y->st_size) {
+        return x->st_size > y->st_size ? -1 : 1;
+    }
+    return x < y ? -1 : x > y;
 }
 
-char *get_symbol_ndx(Elf64_Section st_shndx) {
-    static char buf[10];
-    memset(buf, 0, 10);
-    int i = 8;
-    buf[9] = 0;
-    switch (st_shndx) {
-        case SHN_ABS:
-            return "ABS";
-        case SHN_COMMON:
-            return "COM";
-        case SHN_UNDEF:
-            return "UND";
-        default: {
-            // 正常情况
-            while (st_shndx) {
-                buf[i--] = '0' + st_shndx % 10;
-                st_shndx /= 10;
+/**
+ * @brief 按 --top 和 --sort 输出通过 --filter 的符号, 只处理符号的下标, 不复制 Elf64_Sym
+ *        --top 使用有界堆选出最大的 N 个符号, 不指定 --sort 或者 --sort=size 时按大小从大到小输出
+ *        --sort 的地址和大小使用基数排序, 名字直接比较字符串表中的字符串
+ */
+static void display_sorted_symbols(ELF *ELF_file_data,
+                                   ReadelfOptions *options,
+                                   RELF_symbols *span,
+                                   RELF_versions *versions) {
+    uint64_t number = 0;
+    uint64_t *indexes = malloc(sizeof(uint64_t) * (span->symbol_number + 1));
+    if (options->top_number) {
+        uint64_t capacity = (uint64_t)options->top_number;
+        XBOX_TopHeap heap;
+        XBOX_top_init(&heap, capacity < span->symbol_number ? capacity : span->symbol_number, symbol_size_cmp);
+        for (uint64_t j = 0; j < span->symbol_number; j++) {
+            Elf64_Sym *sym = &span->symbols[j];
+            if (!options->symbol_filter || symbol_filter_match(options->symbol_filter, ELF_file_data, span, sym)) {
+                XBOX_top_push(&heap, sym);
             }
-            return buf + i + 1;
         }
+        number = XBOX_top_finish(&heap);
+        for (uint64_t i = 0; i < number; i++) {
+            indexes[i] = (uint64_t)((Elf64_Sym *)heap.items[i] - span->symbols);
+        }
+        XBOX_top_free(&heap);
+    } else {
+        for (uint64_t j = 0; j < span->symbol_number; j++) {
+            Elf64_Sym *sym = &span->symbols[j];
+            if (!options->symbol_filter || symbol_filter_match(options->symbol_filter, ELF_file_data, span, sym)) {
+                indexes[number++] = j;
+            }
+        }
+    }
+
+    if (options->symbol_sort == SYMBOL_SORT_NAME) {
+        XBOX_StringItem *items = malloc(sizeof(XBOX_StringItem) * (number + 1));
+        for (uint64_t i = 0; i < number; i++) {
+            items[i].str = RELF_symbol_name(ELF_file_data, span, &span->symbols[indexes[i]]);
+            items[i].index = indexes[i];
+        }
+        XBOX_string_sort(items, number);
+        for (uint64_t i = 0; i < number; i++) {
+            indexes[i] = items[i].index;
+        }
+        free(items);
+    } else if (options->symbol_sort && !(options->symbol_sort == SYMBOL_SORT_SIZE && options->top_number)) {
+        // 有界堆的结果已经按大小从大到小排列, --top 和 --sort=size 一起使用时保持这个顺序
+        XBOX_SortItem *items = malloc(sizeof(XBOX_SortItem) * (number + 1));
+        for (uint64_t i = 0; i < number; i++) {
+            Elf64_Sym *sym = &span->symbols[indexes[i]];
+            items[i].key = options->symbol_sort == SYMBOL_SORT_ADDR ? sym->st_value : sym->st_size;
+            items[i].index = indexes[i];
+        }
+        if (XBOX_radix_sort(items, number)) {
+            fprintf(stderr, "readelf Error: not enough memory to sort the symbols\n");
+            number = 0;
+        }
+        for (uint64_t i = 0; i < number; i++) {
+            indexes[i] = items[i].index;
+        }
+        free(items);
+    }
+
+    for (uint64_t i = 0; i < number; i++) {
+        PRINT_FORMATTED(RELF_format_symbol, ELF_file_data, span, versions, indexes[i], format_flags(options));
+    }
+    free(indexes);
+}
+
+/**
+ * @brief --sort 的参数
+ *
+ * @return int enum symbol_sort_kind, 不认识的参数返回 -1
+ */
+static int parse_sort_option(const char *key) {
+    if (!strcmp(key, "addr") || !strcmp(key, "address")) {
+        return SYMBOL_SORT_ADDR;
+    } else if (!strcmp(key, "size")) {
+        return SYMBOL_SORT_SIZE;
+    } else if (!strcmp(key, "name")) {
+        return SYMBOL_SORT_NAME;
     }
+    return -1;
 }
 
 /**
@@ -681,7 +1023,7 @@ char *get_symbol_ndx(Elf64_Section st_shndx) {
  * @param ELF_file_data
  * @return int
  */
-int display_elf_symbol_table(ELF *ELF_file_data) {
+int display_elf_symbol_table(ELF *ELF_file_data, ReadelfOptions *options) {
     // typedef struct {
     //     uint32_t      st_name;
     //     unsigned char st_info;
@@ -692,244 +1034,661 @@ int display_elf_symbol_table(ELF *ELF_file_data) {
     // } Elf64_Sym;
 
     int section_number = ELF_file_data->ehdr.e_shnum;
-    Elf64_Sym *symtab_addr;  // 符号表指针
-    int symtab_number;       // 符号表表项的个数
+    RELF_versions version_table;
+    RELF_build_versions(ELF_file_data, &version_table);
     for (int i = 0; i < section_number; i++) {
         Elf64_Shdr *shdr = &ELF_file_data->shdr[i];
-        // SHT_SYMTAB 和 SHT_DYNSYM 类型的段是符号表
-        if ((shdr->sh_type == SHT_SYMTAB) || (shdr->sh_type == SHT_DYNSYM)) {
+        // SHT_SYMTAB 和 SHT_DYNSYM 类型的段是符号表, --dyn-syms 只显示 SHT_DYNSYM
+        if ((shdr->sh_type == SHT_SYMTAB && options->display_symbol_table) || (shdr->sh_type == SHT_DYNSYM)) {
             // 符号表的段名
-            char *section_name = (char *)((char *)ELF_file_data->addr + ELF_file_data->shstrtab_offset + shdr->sh_name);
-            // sh_link 指向符号表对应的字符串表
-            Elf64_Shdr *strtab = &ELF_file_data->shdr[shdr->sh_link];
-
-            // 定位到当前段的起始地址
-            symtab_addr = (Elf64_Sym *)((char *)ELF_file_data->addr + shdr->sh_offset);
-            // 通过 sh_size 和 Elf64_Sym 结构体大小计算表项数量
-            symtab_number = shdr->sh_size / sizeof(Elf64_Sym);
+            char *section_name = RELF_section_name(ELF_file_data, shdr);
+            // 只有 .dynsym 带有符号版本
+            int is_dynsym = shdr->sh_type == SHT_DYNSYM && version_table.versym;
+
+            // 符号表及其 sh_link 指向的字符串表, 已经在 RELF_validate_tables 中检查过
+            RELF_symbols span = RELF_symbol_span(ELF_file_data, shdr);
+            int symtab_number = span.symbol_number;
             printf("\nSymbol table '%s' contains %d %s:\n",
                    section_name,
                    symtab_number,
                    symtab_number == 1 ? "entry" : "entries");
             printf("   Num:    Value          Size Type    Bind   Vis      Ndx Name\n");
+            if (options->symbol_sort || options->top_number) {
+                display_sorted_symbols(ELF_file_data, options, &span, is_dynsym ? &version_table : NULL);
+                continue;
+            }
             for (int j = 0; j < symtab_number; j++) {
-                // 对于每一个表项 symtab_addr[j] => Elf64_Sym
-                // st_info 的低4位用于符号类型 0-3      => ELF64_ST_TYPE
-                // st_info 的高4位用于符号绑定信息 4-7  => ELF64_ST_BIND
-                char *symbol_type = get_symbol_type(ELF64_ST_TYPE(symtab_addr[j].st_info));
-                char *symbol_bind = get_symbol_bind(ELF64_ST_BIND(symtab_addr[j].st_info));
-                char *symbol_visibility = get_symbol_vis(symtab_addr[j].st_other);  // 用于控制符号可见性
-                char *symbol_ndx = get_symbol_ndx(symtab_addr[j].st_shndx);
-                char *symbol_name;
-                // 对于 st_name 的值不为0的符号或者 ABS, 去对应的 .strtab 中找
-                if (symtab_addr[j].st_name || symtab_addr[j].st_shndx == SHN_ABS) {
-                    symbol_name = (char *)((char *)ELF_file_data->addr + strtab->sh_offset + symtab_addr[j].st_name);
+                if (options->symbol_filter &&
+                    !symbol_filter_match(options->symbol_filter, ELF_file_data, &span, &span.symbols[j])) {
+                    continue;
+                }
+                PRINT_FORMATTED(RELF_format_symbol,
+                                ELF_file_data,
+                                &span,
+                                is_dynsym ? &version_table : NULL,
+                                j,
+                                format_flags(options));
+            }
+        }
+    }
+    RELF_free_versions(&version_table);
+    return 0;
+}
+
+/**
+ * @brief 版本的标记位
+ *
+ * @param flags
+ * @return char*
+ */
+static char *get_version_flags(unsigned int flags) {
+    static char buf[64];
+    buf[0] = 0;
+    if (flags == 0) {
+        return "none";
+    }
+    if (flags & VER_FLG_BASE) {
+        strcat(buf, "BASE");
+    }
+    if (flags & VER_FLG_WEAK) {
+        if (flags & VER_FLG_BASE) {
+            strcat(buf, " | ");
+        }
+        strcat(buf, "WEAK");
+    }
+    if (flags & VER_FLG_INFO) {
+        if (flags & (VER_FLG_BASE | VER_FLG_WEAK)) {
+            strcat(buf, " | ");
+        }
+        strcat(buf, "INFO");
+    }
+    if (flags & ~(VER_FLG_BASE | VER_FLG_WEAK | VER_FLG_INFO)) {
+        if (flags & (VER_FLG_BASE | VER_FLG_WEAK | VER_FLG_INFO)) {
+            strcat(buf, " | ");
+        }
+        strcat(buf, "<unknown>");
+    }
+    return buf;
+}
+
+/**
+ * @brief 输出版本段的公共头部
+ *
+ * @param ELF_file_data
+ * @param shdr
+ * @param title
+ * @param entry_number
+ */
+static void print_version_section_header(ELF *ELF_file_data,
+                                         Elf64_Shdr *shdr,
+                                         const char *title,
+                                         uint64_t entry_number) {
+    char *section_name = RELF_section_name(ELF_file_data, shdr);
+    char *link_name = "";
+    if (shdr->sh_link < ELF_file_data->ehdr.e_shnum) {
+        link_name = RELF_section_name(ELF_file_data, &ELF_file_data->shdr[shdr->sh_link]);
+    }
+    printf("\n%s section '%s' contains %lu %s:\n",
+           title,
+           section_name,
+           entry_number,
+           entry_number == 1 ? "entry" : "entries");
+    printf(" Addr: 0x%016lx  Offset: 0x%08lx  Link: %u (%s)\n",
+           shdr->sh_addr,
+           shdr->sh_offset,
+           shdr->sh_link,
+           link_name);
+}
+
+/**
+ * @brief readelf -V 查看符号版本信息
+ *
+ * @param ELF_file_data
+ * @return int
+ */
+int display_elf_version_info(ELF *ELF_file_data) {
+    RELF_versions version_table;
+    RELF_build_versions(ELF_file_data, &version_table);
+    int has_version_section = 0;
+    for (int i = 0; i < ELF_file_data->ehdr.e_shnum; i++) {
+        Elf64_Shdr *shdr = &ELF_file_data->shdr[i];
+        char *data = (char *)ELF_file_data->addr + shdr->sh_offset;
+        if (shdr->sh_type == SHT_GNU_versym) {
+            // 每个 .dynsym 符号对应一个版本索引, 每行 4 个
+            has_version_section = 1;
+            uint64_t versym_number = shdr->sh_size / sizeof(Elf64_Half);
+            Elf64_Half *versym = (Elf64_Half *)data;
+            print_version_section_header(ELF_file_data, shdr, "Version symbols", versym_number);
+            for (uint64_t j = 0; j < versym_number; j += 4) {
+                printf("  %03lx:", j);
+                for (uint64_t k = j; k < j + 4 && k < versym_number; k++) {
+                    if (versym[k] == VER_NDX_LOCAL) {
+                        printf("   0 (*local*)    ");
+                        continue;
+                    } else if (versym[k] == VER_NDX_GLOBAL) {
+                        printf("   1 (*global*)   ");
+                        continue;
+                    }
+                    int length = printf("%4x%c", versym[k] & VERSYM_VERSION, versym[k] & VERSYM_HIDDEN ? 'h' : ' ');
+                    int version_index = versym[k] & VERSYM_VERSION;
+                    const char *name = NULL;
+                    if (version_index < version_table.name_number) {
+                        RELF_version_name *version_name = &version_table.names[version_index];
+                        // verneed 要求 vna_other 与 versym 完全相等(不含隐藏位)
+                        if (!(versym[k] & VERSYM_HIDDEN)) {
+                            name = version_name->need_name;
+                        }
+                        if (versym[k] != (VERSYM_HIDDEN | VER_NDX_GLOBAL) && version_name->has_def) {
+                            name = name ? "*both*" : version_name->def_name;
+                        }
+                    }
+                    if (name) {
+                        length += printf("(%s%-*s", name, 12 - (int)strlen(name), ")");
+                    }
+                    if (length < 18) {
+                        printf("%*c", 18 - length, ' ');
+                    }
+                }
+                printf("\n");
+            }
+        } else if (shdr->sh_type == SHT_GNU_verdef) {
+            has_version_section = 1;
+            print_version_section_header(ELF_file_data, shdr, "Version definition", shdr->sh_info);
+            uint64_t offset = 0;
+            for (Elf64_Word cnt = 0; cnt < shdr->sh_info && offset + sizeof(Elf64_Verdef) <= shdr->sh_size; cnt++) {
+                Elf64_Verdef *verdef = (Elf64_Verdef *)(data + offset);
+                printf("  %#06lx: Rev: %d  Flags: %s", offset, verdef->vd_version, get_version_flags(verdef->vd_flags));
+                printf("  Index: %d  Cnt: %d  ", verdef->vd_ndx, verdef->vd_cnt);
+                uint64_t aux_offset = offset + verdef->vd_aux;
+                for (int j = 0; j < verdef->vd_cnt && aux_offset + sizeof(Elf64_Verdaux) <= shdr->sh_size; j++) {
+                    Elf64_Verdaux *verdaux = (Elf64_Verdaux *)(data + aux_offset);
+                    const char *name = RELF_string(ELF_file_data, shdr->sh_link, verdaux->vda_name);
+                    // 第一个 verdaux 是版本本身的名字, 之后的是父版本
+                    if (j == 0) {
+                        printf(name ? "Name: %s\n" : "Name index: %s\n", name ? name : "");
+                    } else {
+                        printf("  %#06lx: Parent %d: %s\n", aux_offset, j, name ? name : "");
+                    }
+                    if (!verdaux->vda_next) {
+                        break;
+                    }
+                    aux_offset += verdaux->vda_next;
+                }
+                if (!verdef->vd_next) {
+                    break;
+                }
+                offset += verdef->vd_next;
+            }
+        } else if (shdr->sh_type == SHT_GNU_verneed) {
+            has_version_section = 1;
+            print_version_section_header(ELF_file_data, shdr, "Version needs", shdr->sh_info);
+            uint64_t offset = 0;
+            for (Elf64_Word cnt = 0; cnt < shdr->sh_info && offset + sizeof(Elf64_Verneed) <= shdr->sh_size; cnt++) {
+                Elf64_Verneed *verneed = (Elf64_Verneed *)(data + offset);
+                const char *file = RELF_string(ELF_file_data, shdr->sh_link, verneed->vn_file);
+                printf("  %#06lx: Version: %d", offset, verneed->vn_version);
+                if (file) {
+                    printf("  File: %s", file);
                 } else {
-                    // 为 0 说明是一个特殊符号, 用 symbol_ndx 去段表字符串表中找
-                    symbol_name = (char *)((char *)ELF_file_data->addr + ELF_file_data->shstrtab_offset +
-                                           ELF_file_data->shdr[symtab_addr[j].st_shndx].sh_name);
+                    printf("  File: %x", verneed->vn_file);
                 }
-                if (!truncated && strlen(symbol_name) > 21) {
-                    char short_symbol_name[22];
-                    strncpy(short_symbol_name, symbol_name, 16);
-                    strncpy(short_symbol_name + 16, "[...]", 6);
-                    short_symbol_name[21] = 0;
-                    symbol_name = short_symbol_name;
+                printf("  Cnt: %d\n", verneed->vn_cnt);
+                uint64_t aux_offset = offset + verneed->vn_aux;
+                for (int j = 0; j < verneed->vn_cnt && aux_offset + sizeof(Elf64_Vernaux) <= shdr->sh_size; j++) {
+                    Elf64_Vernaux *vernaux = (Elf64_Vernaux *)(data + aux_offset);
+                    const char *name = RELF_string(ELF_file_data, shdr->sh_link, vernaux->vna_name);
+                    if (name) {
+                        printf("  %#06lx:   Name: %s", aux_offset, name);
+                    } else {
+                        printf("  %#06lx:   Name index: %x", aux_offset, vernaux->vna_name);
+                    }
+                    printf("  Flags: %s  Version: %d\n", get_version_flags(vernaux->vna_flags), vernaux->vna_other);
+                    if (!vernaux->vna_next) {
+                        break;
+                    }
+                    aux_offset += vernaux->vna_next;
                 }
-                printf("%6d: %016lx %5ld %-8s%-6s %-7s %4s %s\n",
-                       j,
-                       symtab_addr[j].st_value,
-                       symtab_addr[j].st_size,
-                       symbol_type,
-                       symbol_bind,
-                       symbol_visibility,
-                       symbol_ndx,
-                       symbol_name);
+                if (!verneed->vn_next) {
+                    break;
+                }
+                offset += verneed->vn_next;
             }
         }
     }
+    if (!has_version_section) {
+        printf("\nNo version information found in this file.\n");
+    }
+    RELF_free_versions(&version_table);
     return 0;
 }
 
-char *get_elf_relocation_type_name(int type) {
-    switch (type) {
-        // x86_64 架构的重定位类型
-        case R_X86_64_NONE:
-            return "NONE";
-        case R_X86_64_64:
-            return "R_X86_64_64";
-        case R_X86_64_PC32:
-            return "R_X86_64_PC32";
-        case R_X86_64_PLT32:
-            return "R_X86_64_PLT32";
-        case R_X86_64_GOTPCREL:
-            return "R_X86_64_GOTPCREL";
-        case R_X86_64_GOTPCRELX:
-            return "R_X86_64_GOTPCRELX";
-        case R_X86_64_COPY:
-            return "R_X86_64_COPY";
-        case R_X86_64_JUMP_SLOT:
-            return "R_X86_64_JUMP_SLO";
-        case R_X86_64_RELATIVE:
-            return "R_X86_64_RELATIVE";
-        case R_X86_64_GLOB_DAT:
-            return "R_X86_64_GLOB_DAT";
-        // 其他架构的重定位类型
-        // ...
-        default:
-            return "UNKNOWN";
+/**
+ * @brief 输出一个 RELR 表, --relr-summary 时只统计不展开
+ */
+static void display_elf_relr_table(ELF *ELF_file_data, Elf64_Shdr *shdr, ReadelfOptions *options) {
+    RELF_relr span = RELF_relr_span(ELF_file_data, shdr);
+    RELF_relr_summary summary;
+    RELF_relr_summarize(&span, &summary);
+    printf("\nRelocation section '%s' at offset 0x%lx contains %lu %s:\n",
+           RELF_section_name(ELF_file_data, shdr),
+           shdr->sh_offset,
+           span.relr_number,
+           span.relr_number == 1 ? "entry" : "entries");
+    if (options->relr_summary) {
+        // 展开成 RELA 需要的大小, 用来衡量压缩的效果
+        uint64_t rela_size = summary.location_number * sizeof(Elf64_Rela);
+        printf("  %lu address %s, %lu bitmap %s, %lu %s\n",
+               summary.address_number,
+               summary.address_number == 1 ? "entry" : "entries",
+               summary.bitmap_number,
+               summary.bitmap_number == 1 ? "entry" : "entries",
+               summary.location_number,
+               summary.location_number == 1 ? "offset" : "offsets");
+        printf("  %lu bytes, %lu bytes as RELA (%.1fx)\n",
+               shdr->sh_size,
+               rela_size,
+               shdr->sh_size ? (double)rela_size / shdr->sh_size : 0.0);
+        return;
+    }
+    printf("  %lu %s\n", summary.location_number, summary.location_number == 1 ? "offset" : "offsets");
+    if (!summary.location_number) {
+        return;
+    }
+    Elf64_Addr *addresses = malloc(summary.location_number * sizeof(Elf64_Addr));
+    if (!addresses) {
+        fprintf(stderr, "readelf Error: failed to allocate %lu RELR offsets\n", summary.location_number);
+        return;
     }
+    uint64_t address_number = RELF_relr_expand(&span, addresses);
+    for (uint64_t i = 0; i < address_number; i++) {
+        printf("%016lx\n", addresses[i]);
+    }
+    free(addresses);
 }
 
-int display_elf_relocation_table(ELF *ELF_file_data) {
+int display_elf_relocation_table(ELF *ELF_file_data, ReadelfOptions *options) {
     // typedef struct {
     //     Elf64_Addr r_offset;
     //     uint64_t r_info;
     //     int64_t r_addend;
     // } Elf64_Rela;
+    // SHT_REL 的 Elf64_Rel 没有 r_addend, 加数保存在被重定位的位置
     int section_number = ELF_file_data->ehdr.e_shnum;
-    Elf64_Rela *relatab_addr;  // 重定位表
-    int relatab_item_number;   // 重定位表表项的数量
 
     int has_rela_section = 0;  // 是否有重定位段
+    RELF_versions version_table;
+    RELF_build_versions(ELF_file_data, &version_table);
     for (int i = 0; i < section_number; i++) {
         Elf64_Shdr *shdr = &ELF_file_data->shdr[i];
+        if (shdr->sh_type == SHT_RELR) {
+            has_rela_section = 1;
+            display_elf_relr_table(ELF_file_data, shdr, options);
+            continue;
+        }
         // 对于重定位表
-        if (shdr->sh_type == SHT_RELA) {
+        if (shdr->sh_type == SHT_RELA || shdr->sh_type == SHT_REL) {
             has_rela_section = 1;
             // 符号表的段名
-            char *section_name = (char *)((char *)ELF_file_data->addr + ELF_file_data->shstrtab_offset + shdr->sh_name);
-            // 重定位表的 sh_link 指向对应的符号表
-            Elf64_Shdr *symbol_table = &ELF_file_data->shdr[shdr->sh_link];
-            // 通过符号表的 sh_link 找到符号表的字符串表
-            Elf64_Shdr *strtab = &ELF_file_data->shdr[symbol_table->sh_link];
-            // Info 指向所重定位的段
-            // char *relocated_section_name = (char *)(ELF_file_data->addr + ELF_file_data->shstrtab_offset +
-            // ELF_file_data->shdr[shdr->sh_info].sh_name);
-
-            relatab_addr = (Elf64_Rela *)((char *)ELF_file_data->addr + shdr->sh_offset);
-            relatab_item_number = shdr->sh_size / sizeof(Elf64_Rela);
+            char *section_name = RELF_section_name(ELF_file_data, shdr);
+            // 重定位表的 sh_link 指向对应的符号表, 符号表的 sh_link 指向字符串表
+            // 符号索引已经在 RELF_validate_tables 中检查过
+            RELF_relocations span = RELF_rela_span(ELF_file_data, shdr);
+            // 只有引用 .dynsym 的重定位带有符号版本
+            RELF_versions *versions = NULL;
+            if (shdr->sh_link && ELF_file_data->shdr[shdr->sh_link].sh_type == SHT_DYNSYM && version_table.versym) {
+                versions = &version_table;
+            }
+            int relatab_item_number = span.rela_number;
             printf("\nRelocation section '%s' at offset 0x%lx contains %d %s:\n",
                    section_name,
                    shdr->sh_offset,
                    relatab_item_number,
                    relatab_item_number == 1 ? "entry" : "entries");
-            printf("  Offset          Info           Type           Sym. Value    Sym. Name + Addend\n");
+            if (span.relas) {
+                printf("  Offset          Info           Type           Sym. Value    Sym. Name + Addend\n");
+            } else {
+                printf("  Offset          Info           Type           Sym. Value    Sym. Name\n");
+            }
             for (int j = 0; j < relatab_item_number; j++) {
-                // 重定位类型
-                char *relocation_type_name = get_elf_relocation_type_name(ELF64_R_TYPE(relatab_addr[j].r_info));
-                // 通过 r_info 找到对应的符号表对应的符号
-                Elf64_Sym symtab_item = ((Elf64_Sym *)((char *)ELF_file_data->addr +
-                                                       symbol_table->sh_offset))[ELF64_R_SYM(relatab_addr[j].r_info)];
-                char *symbol_name;
-                // 对于 st_name 的值不为0的符号或者 ABS, 去对应的 .strtab 中找
-                if (symtab_item.st_name || symtab_item.st_shndx == SHN_ABS) {
-                    symbol_name = (char *)((char *)ELF_file_data->addr + strtab->sh_offset + symtab_item.st_name);
-                } else {
-                    // 为 0 说明是一个特殊符号, 用 symbol_ndx 去段表字符串表中找
-                    symbol_name = (char *)((char *)ELF_file_data->addr + ELF_file_data->shstrtab_offset +
-                                           ELF_file_data->shdr[symtab_item.st_shndx].sh_name);
-                }
-                if (!truncated && strlen(symbol_name) > 22) {
-                    // check_argparse_groups
-                    // check_argparse_s[...]
-                    char short_symbol_name[23];
-                    strncpy(short_symbol_name, symbol_name, 17);
-                    strncpy(short_symbol_name + 17, "[...]", 6);
-                    short_symbol_name[22] = 0;
-                    symbol_name = short_symbol_name;
-                }
-
-                printf("%012lx  %012lx %-18s%016ld %s ",
-                       relatab_addr[j].r_offset,
-                       relatab_addr[j].r_info,
-                       relocation_type_name,
-                       symtab_item.st_value,
-                       symbol_name);
-                if (relatab_addr[j].r_addend >= 0) {
-                    printf("+ %lx\n", relatab_addr[j].r_addend);
-                } else {
-                    printf("- %lx\n", -relatab_addr[j].r_addend);
-                }
+                PRINT_FORMATTED(RELF_format_relocation, ELF_file_data, &span, versions, j, format_flags(options));
             }
         }
     }
     if (!has_rela_section) {
         printf("\nThere are no relocations in this file.\n");
     }
+    RELF_free_versions(&version_table);
     return 0;
 }
 
-char *get_phdr_type(uint32_t p_type) {
-    switch (p_type) {
-        case PT_NULL:
-            return "NULL";
-        case PT_LOAD:
-            return "LOAD";
-        case PT_DYNAMIC:
-            return "DYNAMIC";
-        case PT_INTERP:
-            return "INTERP";
-        case PT_NOTE:
-            return "NOTE";
-        case PT_SHLIB:
-            return "SHLIB";
-        case PT_PHDR:
-            return "PHDR";
-        case PT_GNU_STACK:
-            return "GNU_STACK";
-        case PT_LOPROC:
-            return "LOPROC";
-        case PT_HIPROC:
-            return "HIPROC";
-        case PT_GNU_RELRO:
-            return "GNU_RELRO";
-        case PT_GNU_EH_FRAME:
-            return "GNU_EH_FRAME";
-        case PT_GNU_PROPERTY:
-            return "GNU_PROPERTY";
-        default:
-            return "";
-    }
-}
+// --reloc-stats: 一次遍历所有重定位表, 按类型和目标段统计, 不输出每一项
+// 动态重定位的 r_offset 是虚拟地址, 按地址排序的段表二分查找所在的段, 并缓存上一次命中的段
+// 链接器输出的重定位基本按地址有序, 绝大多数查找只需要和缓存的段比较一次
 
-char *get_phdr_flag(uint32_t p_flags) {
-    static char flags[3] = "   ";
-    memset(flags, ' ', 3);
-    if (p_flags & PF_R) {
-        flags[0] = 'R';
-    }
-    if (p_flags & PF_W) {
-        flags[1] = 'W';
-    }
-    if (p_flags & PF_X) {
-        flags[2] = 'E';
-    }
-    return flags;
-}
+#define RELOC_STATS_TYPE_NUMBER 64  // x86_64 的重定位类型都小于 64, 更大的类型合并为一项
+#define RELOC_STATS_OTHER_TYPE RELOC_STATS_TYPE_NUMBER
+#define RELOC_STATS_RELR_TYPE (RELOC_STATS_TYPE_NUMBER + 1)  // RELR 没有类型字段, 单独计数
+
+typedef struct {
+    uint64_t relocation_number;
+    uint64_t section_number;   // 重定位表的数量
+    uint64_t relative_number;  // R_X86_64_RELATIVE 和 RELR, 只需要加上装载基址
+    uint64_t symbolic_number;  // 需要查找符号
+    uint64_t other_number;     // 没有符号的其他类型, 例如 R_X86_64_IRELATIVE 和 TLS
+    uint64_t unique_symbol_number;
+    uint64_t type_counts[RELOC_STATS_TYPE_NUMBER + 2];
+    uint64_t relr_number;      // RELR 展开之后的数量
+    uint64_t relr_size;        // RELR 表的字节数
+    uint64_t *target_counts;   // 按段下标, 最后一项是不属于任何段的重定位
+    uint64_t **symbol_seen;    // 按符号表的段下标, 被引用过的符号的位图
+    int *sorted_sections;      // 有地址的 SHF_ALLOC 段, 按 sh_addr 排序, 地址相同时按段下标
+    int sorted_number;
+    int last_section;          // 上一次命中的段在 sorted_sections 中的下标, -1 表示没有
+    Elf64_Addr *packable;      // 可以改用 RELR 的相对重定位的地址
+    uint64_t packable_number;
+    uint64_t packable_size;  // 这些重定位现在占用的字节数
+} RelocStats;
 
 /**
- * @brief 查所有 section 找到段名为 .interp 的地址
-          虽然一定不是正确的做法, 但是暂时有效, 至少...
+ * @brief 地址 addr 所在的段
  *
- * @param ELF_file_data
- * @return char*
+ * @return int 段下标, 不属于任何段时返回 e_shnum
  */
-char *get_program_interpreter(ELF *ELF_file_data) {
-    int section_number = ELF_file_data->ehdr.e_shnum;
-    for (int i = 0; i < section_number; i++) {
-        Elf64_Shdr *shdr = &ELF_file_data->shdr[i];
-        if (shdr->sh_type == SHT_PROGBITS) {
-            char *section_name = (char *)((char *)ELF_file_data->addr + ELF_file_data->shstrtab_offset + shdr->sh_name);
-            if (!strcmp(section_name, ".interp")) {
-                return (char *)((char *)ELF_file_data->addr + shdr->sh_addr);
-            }
+static int reloc_stats_find_section(RelocStats *stats, ELF *ELF_file_data, Elf64_Addr addr) {
+    if (stats->last_section >= 0) {
+        Elf64_Shdr *shdr = &ELF_file_data->shdr[stats->sorted_sections[stats->last_section]];
+        if (addr >= shdr->sh_addr && addr - shdr->sh_addr < shdr->sh_size) {
+            return stats->sorted_sections[stats->last_section];
+        }
+    }
+    // 最后一个 sh_addr <= addr 的段
+    int low = 0;
+    int high = stats->sorted_number;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (ELF_file_data->shdr[stats->sorted_sections[middle]].sh_addr <= addr) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low > 0) {
+        Elf64_Shdr *shdr = &ELF_file_data->shdr[stats->sorted_sections[low - 1]];
+        if (addr - shdr->sh_addr < shdr->sh_size) {
+            stats->last_section = low - 1;
+            return stats->sorted_sections[low - 1];
         }
     }
-    return "";
+    return ELF_file_data->ehdr.e_shnum;
 }
 
-void display_elf_program_header(ELF *ELF_file_data) {
+static void reloc_stats_add_symbol(RelocStats *stats, Elf64_Shdr *symtab_shdr, Elf64_Word symtab, uint64_t index) {
+    if (!stats->symbol_seen[symtab]) {
+        uint64_t word_number = (symtab_shdr->sh_size / sizeof(Elf64_Sym) + 63) / 64;
+        stats->symbol_seen[symtab] = calloc(word_number, sizeof(uint64_t));
+        if (!stats->symbol_seen[symtab]) {
+            return;
+        }
+    }
+    uint64_t bit = 1ULL << (index % 64);
+    uint64_t *word = &stats->symbol_seen[symtab][index / 64];
+    stats->unique_symbol_number += !(*word & bit);
+    *word |= bit;
+}
+
+static void reloc_stats_add_relocations(RelocStats *stats, ELF *ELF_file_data, Elf64_Shdr *shdr) {
+    RELF_relocations span = RELF_rela_span(ELF_file_data, shdr);
+    uint64_t entry_size = span.relas ? sizeof(Elf64_Rela) : sizeof(Elf64_Rel);
+    // 可重定位文件的 sh_info 是被重定位的段, r_offset 是段内偏移
+    int is_object = ELF_file_data->ehdr.e_type == ET_REL;
+    int object_target = shdr->sh_info < ELF_file_data->ehdr.e_shnum ? (int)shdr->sh_info : ELF_file_data->ehdr.e_shnum;
+    for (uint64_t i = 0; i < span.rela_number; i++) {
+        Elf64_Addr r_offset = span.relas ? span.relas[i].r_offset : span.rels[i].r_offset;
+        Elf64_Xword r_info = span.relas ? span.relas[i].r_info : span.rels[i].r_info;
+        uint64_t type = ELF64_R_TYPE(r_info);
+        uint64_t symbol_index = ELF64_R_SYM(r_info);
+        stats->type_counts[type < RELOC_STATS_TYPE_NUMBER ? type : RELOC_STATS_OTHER_TYPE]++;
+        stats->target_counts[is_object ? object_target : reloc_stats_find_section(stats, ELF_file_data, r_offset)]++;
+        if (symbol_index) {
+            stats->symbolic_number++;
+            reloc_stats_add_symbol(stats, &ELF_file_data->shdr[shdr->sh_link], shdr->sh_link, symbol_index);
+        } else if (type == R_X86_64_RELATIVE) {
+            stats->relative_number++;
+            // RELR 只能表示按字对齐的位置
+            if (!is_object && r_offset % sizeof(Elf64_Addr) == 0) {
+                stats->packable[stats->packable_number++] = r_offset;
+                stats->packable_size += entry_size;
+            }
+        } else {
+            stats->other_number++;
+        }
+    }
+    stats->relocation_number += span.rela_number;
+}
+
+static void reloc_stats_add_relr(RelocStats *stats, ELF *ELF_file_data, Elf64_Shdr *shdr) {
+    RELF_relr span = RELF_relr_span(ELF_file_data, shdr);
+    RELF_relr_summary summary;
+    RELF_relr_summarize(&span, &summary);
+    Elf64_Addr base = 0;
+    for (uint64_t i = 0; i < span.relr_number; i++) {
+        Elf64_Relr entry = span.relrs[i];
+        if (!(entry & 1)) {
+            stats->target_counts[reloc_stats_find_section(stats, ELF_file_data, entry)]++;
+            base = entry + sizeof(Elf64_Addr);
+            continue;
+        }
+        // 位图覆盖的 63 个字都在同一个段中时整体计数, 否则逐个查找
+        int section = reloc_stats_find_section(stats, ELF_file_data, base);
+        Elf64_Addr end = base + 62 * sizeof(Elf64_Addr);
+        if (section < ELF_file_data->ehdr.e_shnum && reloc_stats_find_section(stats, ELF_file_data, end) == section) {
+            stats->target_counts[section] += __builtin_popcountll(entry >> 1);
+        } else {
+            for (uint64_t bits = entry >> 1; bits; bits &= bits - 1) {
+                Elf64_Addr addr = base + (Elf64_Addr)__builtin_ctzll(bits) * sizeof(Elf64_Addr);
+                stats->target_counts[reloc_stats_find_section(stats, ELF_file_data, addr)]++;
+            }
+        }
+        base += 63 * sizeof(Elf64_Addr);
+    }
+    stats->type_counts[RELOC_STATS_RELR_TYPE] += summary.location_number;
+    stats->relr_number += summary.location_number;
+    stats->relr_size += shdr->sh_size;
+    stats->relative_number += summary.location_number;
+    stats->relocation_number += summary.location_number;
+}
+
+/**
+ * @brief 把地址编码为 RELR 需要的项数, 与 lld 的编码相同
+ *
+ * @param addresses 按地址排序
+ * @param number
+ * @return uint64_t
+ */
+static uint64_t reloc_stats_relr_entries(Elf64_Addr *addresses, uint64_t number) {
+    uint64_t entry_number = 0;
+    for (uint64_t i = 0; i < number;) {
+        // 一个地址项, 之后尽可能用位图覆盖
+        Elf64_Addr base = addresses[i++] + sizeof(Elf64_Addr);
+        entry_number++;
+        while (i < number) {
+            uint64_t bitmap = 0;
+            for (; i < number; i++) {
+                uint64_t delta = addresses[i] - base;
+                if (delta >= 63 * sizeof(Elf64_Addr) || delta % sizeof(Elf64_Addr)) {
+                    break;
+                }
+                bitmap |= 1ULL << (delta / sizeof(Elf64_Addr));
+            }
+            if (!bitmap) {
+                break;
+            }
+            entry_number++;
+            base += 63 * sizeof(Elf64_Addr);
+        }
+    }
+    return entry_number;
+}
+
+/**
+ * @brief 按数量从大到小排序 counts 中不为 0 的项
+ *
+ * @return uint64_t 写入 items 的项数, 数量相同的按下标排序
+ */
+static uint64_t reloc_stats_rank(uint64_t *counts, uint64_t number, XBOX_SortItem *items) {
+    uint64_t item_number = 0;
+    for (uint64_t i = 0; i < number; i++) {
+        if (counts[i]) {
+            items[item_number].key = UINT64_MAX - counts[i];
+            items[item_number].index = i;
+            item_number++;
+        }
+    }
+    // 内存不足时保持下标顺序
+    XBOX_radix_sort(items, item_number);
+    return item_number;
+}
+
+static void reloc_stats_print_row(const char *name, uint64_t count, uint64_t total) {
+    printf("  %-24s %10lu %7.1f%%\n", name, count, total ? 100.0 * count / total : 0.0);
+}
+
+/**
+ * @brief readelf --reloc-stats 按类型, 目标段统计所有重定位, 并估计改用 RELR 可以节省的字节数
+ *
+ * @param ELF_file_data
+ * @param options
+ */
+static void display_elf_reloc_stats(ELF *ELF_file_data, ReadelfOptions *options) {
+    int section_number = ELF_file_data->ehdr.e_shnum;
+    RelocStats stats;
+    memset(&stats, 0, sizeof(RelocStats));
+    stats.last_section = -1;
+    stats.target_counts = calloc(section_number + 1, sizeof(uint64_t));
+    stats.symbol_seen = calloc(section_number, sizeof(uint64_t *));
+    stats.sorted_sections = malloc(sizeof(int) * section_number);
+    // 段表和类型的排名共用, 取两者中较大的
+    XBOX_SortItem *items = malloc(sizeof(XBOX_SortItem) * (section_number + RELOC_STATS_TYPE_NUMBER + 2));
+    uint64_t item_number = 0;
+    uint64_t rela_number = 0;
+    for (int i = 0; i < section_number; i++) {
+        Elf64_Shdr *shdr = &ELF_file_data->shdr[i];
+        // .tbss 不占用地址空间, 和之后的段地址相同
+        int is_tbss = (shdr->sh_flags & SHF_TLS) && shdr->sh_type == SHT_NOBITS;
+        if ((shdr->sh_flags & SHF_ALLOC) && shdr->sh_addr && shdr->sh_size && !is_tbss) {
+            items[item_number].key = shdr->sh_addr;
+            items[item_number].index = i;
+            item_number++;
+        }
+        if (shdr->sh_type == SHT_RELA) {
+            rela_number += shdr->sh_size / sizeof(Elf64_Rela);
+        } else if (shdr->sh_type == SHT_REL) {
+            rela_number += shdr->sh_size / sizeof(Elf64_Rel);
+        }
+    }
+    XBOX_radix_sort(items, item_number);
+    for (uint64_t i = 0; i < item_number; i++) {
+        stats.sorted_sections[stats.sorted_number++] = items[i].index;
+    }
+    stats.packable = malloc(sizeof(Elf64_Addr) * (rela_number + 1));
+
+    for (int i = 0; i < section_number; i++) {
+        Elf64_Shdr *shdr = &ELF_file_data->shdr[i];
+        if (shdr->sh_type == SHT_RELA || shdr->sh_type == SHT_REL) {
+            reloc_stats_add_relocations(&stats, ELF_file_data, shdr);
+            stats.section_number++;
+        } else if (shdr->sh_type == SHT_RELR) {
+            reloc_stats_add_relr(&stats, ELF_file_data, shdr);
+            stats.section_number++;
+        }
+    }
+
+    if (!stats.section_number) {
+        printf("\nThere are no relocations in this file.\n");
+    } else {
+        uint64_t total = stats.relocation_number;
+        printf("\nRelocation statistics: %lu %s in %lu %s, %lu unique %s\n",
+               total,
+               total == 1 ? "relocation" : "relocations",
+               stats.section_number,
+               stats.section_number == 1 ? "section" : "sections",
+               stats.unique_symbol_number,
+               stats.unique_symbol_number == 1 ? "symbol" : "symbols");
+        printf("  %-24s %10s %8s\n", "Kind", "Count", "Percent");
+        reloc_stats_print_row("relative", stats.relative_number, total);
+        reloc_stats_print_row("symbolic", stats.symbolic_number, total);
+        reloc_stats_print_row("other", stats.other_number, total);
+
+        item_number = reloc_stats_rank(stats.type_counts, RELOC_STATS_TYPE_NUMBER + 2, items);
+        printf("\n  %-24s %10s %8s\n", "Type", "Count", "Percent");
+        for (uint64_t i = 0; i < item_number; i++) {
+            uint64_t type = items[i].index;
+            const char *name = type == RELOC_STATS_RELR_TYPE    ? "RELR"
+                               : type == RELOC_STATS_OTHER_TYPE ? "<other>"
+                                                                : RELF_relocation_type(type);
+            reloc_stats_print_row(name, stats.type_counts[type], total);
+        }
+
+        item_number = reloc_stats_rank(stats.target_counts, section_number + 1, items);
+        if (options->top_number && item_number > (uint64_t)options->top_number) {
+            item_number = options->top_number;
+        }
+        printf("\n  %-24s %10s %8s\n", "Target section", "Count", "Percent");
+        for (uint64_t i = 0; i < item_number; i++) {
+            int section = items[i].index;
+            const char *name = "<none>";
+            if (section < section_number) {
+                name = RELF_section_name(ELF_file_data, &ELF_file_data->shdr[section]);
+            }
+            reloc_stats_print_row(*name ? name : "<noname>", stats.target_counts[section], total);
+        }
+
+        // 链接器输出的相对重定位通常已经按地址排序, 只有无序时才排序
+        uint64_t sorted = 1;
+        for (uint64_t i = 1; i < stats.packable_number && sorted; i++) {
+            sorted = stats.packable[i - 1] <= stats.packable[i];
+        }
+        if (!sorted) {
+            XBOX_SortItem *addresses = malloc(sizeof(XBOX_SortItem) * stats.packable_number);
+            for (uint64_t i = 0; i < stats.packable_number; i++) {
+                addresses[i].key = stats.packable[i];
+                addresses[i].index = i;
+            }
+            if (!XBOX_radix_sort(addresses, stats.packable_number)) {
+                for (uint64_t i = 0; i < stats.packable_number; i++) {
+                    stats.packable[i] = addresses[i].key;
+                }
+            }
+            free(addresses);
+        }
+        uint64_t relr_size = reloc_stats_relr_entries(stats.packable, stats.packable_number) * sizeof(Elf64_Relr);
+        if (stats.relr_number || stats.packable_number) {
+            printf("\n");
+        }
+        if (stats.relr_number) {
+            printf(
+                "  RELR: %lu relative relocations already packed in %lu bytes\n", stats.relr_number, stats.relr_size);
+        }
+        if (stats.packable_number) {
+            printf("  RELR: %lu relative relocations in %lu bytes would pack into %lu bytes, saving %lu bytes\n",
+                   stats.packable_number,
+                   stats.packable_size,
+                   relr_size,
+                   stats.packable_size - relr_size);
+        }
+    }
+
+    for (int i = 0; i < section_number; i++) {
+        free(stats.symbol_seen[i]);
+    }
+    free(stats.symbol_seen);
+    free(items);
+    free(stats.target_counts);
+    free(stats.sorted_sections);
+    free(stats.packable);
+}
+
+void display_elf_program_header(ELF *ELF_file_data) {
     if (ELF_file_data->ehdr.e_phnum == 0) {
         printf("\nThere are no program headers in this file.\n");
         return;
@@ -978,25 +1737,13 @@ void display_elf_program_header(ELF *ELF_file_data) {
     printf("                 FileSiz            MemSiz              Flags  Align\n");
     // printf("  %-15s");
 
-    Elf64_Phdr *phdr = (Elf64_Phdr *)((char *)ELF_file_data->addr + ELF_file_data->ehdr.e_phoff);
     for (int i = 0; i < ph_entry_number; i++) {
-        char *phdr_type = get_phdr_type(phdr[i].p_type);
-        char *phdr_flag = get_phdr_flag(phdr[i].p_flags);
-        printf("  %-15s0x%016lx 0x%016lx 0x%016lx\n", phdr_type, phdr[i].p_offset, phdr[i].p_vaddr, phdr[i].p_paddr);
-        printf("                 0x%016lx 0x%016lx  %-7s0x%lx\n",
-               phdr[i].p_filesz,
-               phdr[i].p_memsz,
-               phdr_flag,
-               phdr[i].p_align);
-        if (phdr[i].p_type == PT_INTERP) {
-            char *program_interpreter_path = get_program_interpreter(ELF_file_data);
-            printf("      [Requesting program interpreter: %s]\n", program_interpreter_path);
-        }
+        PRINT_FORMATTED(RELF_format_segment, ELF_file_data, i);
     }
 
     printf("\n Section to Segment mapping:\n");
     printf("  Segment Sections...\n");
-    phdr = (Elf64_Phdr *)((char *)ELF_file_data->addr + ELF_file_data->ehdr.e_phoff);
+    Elf64_Phdr *phdr = RELF_segments(ELF_file_data);
     for (int i = 0; i < ph_entry_number; i++) {
         printf("   %02d     ", i);
         Elf64_Phdr *segment = &phdr[i];
@@ -1004,8 +1751,7 @@ void display_elf_program_header(ELF *ELF_file_data) {
         for (int j = 1; j < ELF_file_data->ehdr.e_shnum; j++) {
             Elf64_Shdr *section = &ELF_file_data->shdr[j];
             if (!ELF_TBSS_SPECIAL(section, segment) && ELF_SECTION_IN_SEGMENT_STRICT(section, segment)) {
-                char *section_name =
-                    (char *)((char *)ELF_file_data->addr + ELF_file_data->shstrtab_offset + section->sh_name);
+                char *section_name = RELF_section_name(ELF_file_data, section);
                 printf("%s ", section_name);
             }
         }
@@ -1013,129 +1759,4150 @@ void display_elf_program_header(ELF *ELF_file_data) {
     }
 }
 
-int main(int argc, const char **argv) {
+// 文件列表: @listfile 和 --files-from FILE|-
+// 按块读取, 每次只返回一个路径, 不把整个列表保存在内存中, 适合几十万个文件的输入
+// 分隔符由第一个遇到的 '\0' 或 '\n' 决定, 与 find -print0 的输出兼容
+
+typedef struct {
+    int fd;
+    char *buffer;
+    size_t start;  // 下一个路径的起始位置
+    size_t end;    // 已读入数据的结束位置
+    size_t capacity;
+    int delimiter;  // -1 表示还未确定
+    int eof;
+} FileList;
+
+// FILES 以及其中的 @listfile, 最后是 --files-from
+typedef struct {
     char **file_names;
-    argparse_option options[] = {
-        XBOX_ARG_BOOLEAN(NULL, "-H", "--help", "show help information", NULL, "help"),
-        XBOX_ARG_BOOLEAN(NULL, "-v", "--version", "show version", NULL, "version"),
-        XBOX_ARG_BOOLEAN(&display_header, "-h", "--file-header", "Display the ELF file header", NULL, NULL),
-        XBOX_ARG_BOOLEAN(&display_section_table, "-S", "--section-headers", "Display the sections' header", NULL, NULL),
-        XBOX_ARG_BOOLEAN(&display_section_table, NULL, "--sections", "An alias for --section-headers", NULL, NULL),
-        XBOX_ARG_BOOLEAN(&display_symbol_table, "-s", "--syms", "Display the symbol table", NULL, NULL),
-        XBOX_ARG_BOOLEAN(&display_symbol_table, NULL, "--symbols", "An alias for --syms", NULL, NULL),
-        XBOX_ARG_BOOLEAN(&display_relocations, "-r", "--relocs", "Display the relocations (if present)", NULL, NULL),
-        XBOX_ARG_BOOLEAN(&display_program_header, "-l", "--program-header", "Display the program headers", NULL, NULL),
-        XBOX_ARG_BOOLEAN(&display_program_header, NULL, "--segments", "An alias for --program-headers", NULL, NULL),
-        XBOX_ARG_BOOLEAN(&truncated,
-                         "-T",
-                         "--silent-truncation",
-                         "If a symbol name is truncated, do not add [...] suffix",
-                         NULL,
-                         NULL),
-        XBOX_ARG_BOOLEAN(&truncated,
-                         "-W",
-                         NULL,
-                         "Don't break output lines to fit into 80 columns",
-                         NULL,
-                         NULL),
-        XBOX_ARG_STRS_GROUP(&file_names, NULL, NULL, NULL, NULL, "FILES"),
-        XBOX_ARG_END()};
+    int file_number;
+    int index;
+    const char *files_from;
+    FileList list;
+    int list_open;
+    int status;  // 列表文件打开或读取失败时为 1
+} FileSource;
 
-    XBOX_argparse parser;
-    XBOX_argparse_init(&parser, options, XBOX_ARGPARSE_ENABLE_ARG_STICK);
-    XBOX_argparse_describe(&parser, "readelf", "Display information about the contents of ELF format files", "");
-    XBOX_argparse_parse(&parser, argc, argv);
+/**
+ * @brief 打开文件列表
+ *
+ * @param list
+ * @param file_name 为 "-" 时读取标准输入
+ * @return int 成功返回 0
+ */
+static int file_list_open(FileList *list, const char *file_name) {
+    memset(list, 0, sizeof(FileList));
+    list->delimiter = -1;
+    list->fd = strcmp(file_name, "-") ? open(file_name, O_RDONLY) : STDIN_FILENO;
+    if (list->fd < 0) {
+        return 1;
+    }
+    list->capacity = FILE_LIST_BUFFER_SIZE;
+    list->buffer = malloc(list->capacity);
+    return 0;
+}
 
-    if (XBOX_ismatch(&parser, "help")) {
-        XBOX_argparse_info(&parser);
-        XBOX_free_argparse(&parser);
-        return 0;
+static void file_list_close(FileList *list) {
+    if (list->fd > STDIN_FILENO) {
+        close(list->fd);
     }
+    free(list->buffer);
+    list->buffer = NULL;
+}
 
-    if (XBOX_ismatch(&parser, "version")) {
-        printf("%s\n", VERSION);
-        XBOX_free_argparse(&parser);
-        return 0;
+/**
+ * @brief 读取下一个路径, 忽略空行
+ *
+ * @param list
+ * @return char* 指向内部缓冲区, 下一次调用之前有效; 读完或出错时返回 NULL
+ */
+static char *file_list_next(FileList *list) {
+    for (;;) {
+        char *begin = list->buffer + list->start;
+        size_t size = list->end - list->start;
+        char *delimiter = NULL;
+        if (list->delimiter < 0) {
+            // 还未确定分隔符, 第一个出现的 '\0' 或 '\n' 决定整个列表的格式
+            for (size_t i = 0; i < size; i++) {
+                if (begin[i] == '\0' || begin[i] == '\n') {
+                    list->delimiter = begin[i];
+                    delimiter = begin + i;
+                    break;
+                }
+            }
+        } else {
+            delimiter = memchr(begin, list->delimiter, size);
+        }
+        if (delimiter || (list->eof && size)) {
+            // 最后一个路径可以没有分隔符, 缓冲区总是保留一个字节的空间
+            char *next = delimiter ? delimiter : begin + size;
+            *next = '\0';
+            list->start = next - list->buffer + (delimiter ? 1 : 0);
+            if (list->start > list->end) {
+                list->start = list->end;
+            }
+            if (next == begin) {
+                continue;
+            }
+            return begin;
+        }
+        if (list->eof) {
+            return NULL;
+        }
+        // 剩余的半个路径移动到缓冲区开头, 放不下时扩大缓冲区
+        memmove(list->buffer, begin, size);
+        list->start = 0;
+        list->end = size;
+        if (list->end + 1 >= list->capacity) {
+            list->capacity *= 2;
+            list->buffer = realloc(list->buffer, list->capacity);
+        }
+        ssize_t n = read(list->fd, list->buffer + list->end, list->capacity - list->end - 1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return NULL;
+        }
+        list->end += n;
+        list->eof = n == 0;
     }
+}
 
-    int n = XBOX_ismatch(&parser, "FILES");
-    if (!n) {
-        printf("readelf Warning: Nothing to do.\n");
-        XBOX_argparse_info(&parser);
+static void file_source_init(FileSource *source, char **file_names, int file_number, const char *files_from) {
+    memset(source, 0, sizeof(FileSource));
+    source->file_names = file_names;
+    source->file_number = file_number;
+    source->files_from = files_from;
+}
+
+/**
+ * @brief 打开 @listfile 或 --files-from 指定的列表, 失败时输出错误信息
+ */
+static int file_source_open_list(FileSource *source, const char *file_name) {
+    if (file_list_open(&source->list, file_name)) {
+        fprintf(stderr, "readelf Error: %s: %s\n", file_name, strerror(errno));
+        source->status = 1;
+        return 1;
     }
-    for (int i = 0; i < n; i++) {
-        ELF ELF_file_data;
-        int fd = open(file_names[i], O_RDONLY);
-        if (fd < 0) {
-            snprintf(error_info, 1024, "open fail: %s", file_names[i]);
-            perror(error_info);
-            XBOX_free_argparse(&parser);
-            return 1;
+    source->list_open = 1;
+    return 0;
+}
+
+/**
+ * @brief 是否可能有多个文件, 文件列表按一个以上的文件处理
+ *        此时每个文件都输出 File: 标题, 内容相同的文件输出的 identical to 才能对应到文件
+ */
+static int file_source_multiple(FileSource *source) {
+    return source->file_number > 1 || source->files_from || (source->file_number && source->file_names[0][0] == '@');
+}
+
+/**
+ * @brief 下一个需要处理的文件
+ *        FILES 中以 @ 开头并且存在的文件作为文件列表展开, 不存在时和 GNU readelf 一样作为普通文件名
+ *
+ * @param source
+ * @return const char* 没有更多文件时返回 NULL
+ */
+static const char *file_source_next(FileSource *source) {
+    for (;;) {
+        if (source->list_open) {
+            char *file_name = file_list_next(&source->list);
+            if (file_name) {
+                return file_name;
+            }
+            if (!source->list.eof) {
+                perror("readelf Error: read file list");
+                source->status = 1;
+            }
+            file_list_close(&source->list);
+            source->list_open = 0;
         }
+        if (source->index < source->file_number) {
+            const char *file_name = source->file_names[source->index++];
+            if (file_name[0] == '@' && file_name[1] && !access(file_name + 1, F_OK)) {
+                file_source_open_list(source, file_name + 1);
+                continue;
+            }
+            return file_name;
+        }
+        if (source->files_from) {
+            const char *files_from = source->files_from;
+            source->files_from = NULL;
+            file_source_open_list(source, files_from);
+            continue;
+        }
+        return NULL;
+    }
+}
 
-        // 对 ELF 文件做完整的内存映射, 保存在 ELF_file_data.addr 中, 方便后面寻址
-        off_t size = lseek(fd, 0, SEEK_END);
-        void *addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
-        if (addr == MAP_FAILED) {
-            snprintf(error_info, 1024, "mmap fail: %s", file_names[i]);
-            perror(error_info);
-            close(fd);
-            XBOX_free_argparse(&parser);
-            exit(1);
+/**
+ * @brief 递归遍历目录, 对每一个普通文件调用 callback
+ *        不跟随符号链接, 避免循环和重复
+ *
+ * @param path
+ * @param callback
+ * @param data 传给 callback 的参数
+ */
+static void walk_directory(const char *path, void (*callback)(const char *full_path, void *data), void *data) {
+    // 先读完整个目录再递归, 同一时刻只打开一个目录的 fd
+    XBOX_DirList list;
+    if (XBOX_dir_read(&list, path, XBOX_DIR_IGNORE_CURRENT) < 0) {
+        fprintf(stderr, "readelf Warning: skip unreadable directory %s\n", path);
+        return;
+    }
+    char full_path[PATH_MAX];
+    for (int i = 0; i < list.count; i++) {
+        const char *name = XBOX_DIR_LIST_NAME(&list, i);
+        if (snprintf(full_path, sizeof(full_path), "%s/%s", path, name) >= (int)sizeof(full_path)) {
+            fprintf(stderr, "readelf Warning: skip too long path %s/%s\n", path, name);
+            continue;
+        }
+        unsigned char type = list.entries[i].type;
+        if (type == DT_UNKNOWN) {
+            struct stat st;
+            if (!lstat(full_path, &st)) {
+                type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+            }
+        }
+        if (type == DT_DIR) {
+            walk_directory(full_path, callback, data);
+        } else if (type == DT_REG) {
+            callback(full_path, data);
         }
-        ELF_file_data.addr = addr;
+    }
+    XBOX_dir_list_free(&list);
+}
 
-        // 读取 ELF 头, 保存在 ELF_file_data.ehdr 中
-        lseek(fd, 0, SEEK_SET);
-        if (read(fd, &ELF_file_data.ehdr, sizeof(Elf64_Ehdr)) < 0) {
-            snprintf(error_info, 1024, "read fail: %s", file_names[i]);
-            perror(error_info);
-            munmap(addr, size);
-            close(fd);
-            XBOX_free_argparse(&parser);
-            exit(1);
+// --batch 和 --bloat 的文件迭代器: 每次从 FileSource 取一个文件, 目录在遇到时才用一个栈逐层展开
+// 不保存完整的文件列表, 只保存从根到当前目录每一层的目录项, 和 walk_directory 的顺序相同
+
+typedef struct {
+    char *path;
+    XBOX_DirList list;
+    int index;  // 下一个要处理的目录项
+} FileWalkerFrame;
+
+typedef struct {
+    FileSource *source;
+    FileWalkerFrame *frames;
+    int frame_number;
+    int frame_capacity;
+    char path[PATH_MAX];  // file_walker_next 返回的目录中的文件
+} FileWalker;
+
+static void file_walker_init(FileWalker *walker, FileSource *source) {
+    memset(walker, 0, sizeof(FileWalker));
+    walker->source = source;
+}
+
+/**
+ * @brief 读取目录并压栈, 无法读取的目录输出警告后跳过
+ */
+static void file_walker_push(FileWalker *walker, const char *path) {
+    if (walker->frame_number == walker->frame_capacity) {
+        walker->frame_capacity = walker->frame_capacity ? walker->frame_capacity * 2 : 16;
+        walker->frames = realloc(walker->frames, sizeof(FileWalkerFrame) * walker->frame_capacity);
+    }
+    FileWalkerFrame *frame = &walker->frames[walker->frame_number];
+    if (XBOX_dir_read(&frame->list, path, XBOX_DIR_IGNORE_CURRENT) < 0) {
+        fprintf(stderr, "readelf Warning: skip unreadable directory %s\n", path);
+        return;
+    }
+    frame->path = strdup(path);
+    frame->index = 0;
+    walker->frame_number++;
+}
+
+static void file_walker_pop(FileWalker *walker) {
+    FileWalkerFrame *frame = &walker->frames[--walker->frame_number];
+    XBOX_dir_list_free(&frame->list);
+    free(frame->path);
+}
+
+/**
+ * @brief 下一个需要处理的文件, 目录会被递归展开, 不跟随符号链接
+ *
+ * @param walker
+ * @param from_directory 输出是否是目录展开得到的文件
+ * @return const char* 下一次调用之前有效, 没有更多文件时返回 NULL
+ */
+static const char *file_walker_next(FileWalker *walker, int *from_directory) {
+    for (;;) {
+        if (walker->frame_number) {
+            FileWalkerFrame *frame = &walker->frames[walker->frame_number - 1];
+            if (frame->index == frame->list.count) {
+                file_walker_pop(walker);
+                continue;
+            }
+            int i = frame->index++;
+            const char *name = XBOX_DIR_LIST_NAME(&frame->list, i);
+            if (snprintf(walker->path, sizeof(walker->path), "%s/%s", frame->path, name) >=
+                (int)sizeof(walker->path)) {
+                fprintf(stderr, "readelf Warning: skip too long path %s/%s\n", frame->path, name);
+                continue;
+            }
+            unsigned char type = frame->list.entries[i].type;
+            if (type == DT_UNKNOWN) {
+                struct stat st;
+                if (!lstat(walker->path, &st)) {
+                    type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+                }
+            }
+            if (type == DT_DIR) {
+                // frame 可能因为 realloc 失效, 压栈之后不再使用
+                file_walker_push(walker, walker->path);
+            } else if (type == DT_REG) {
+                *from_directory = 1;
+                return walker->path;
+            }
+            continue;
+        }
+        const char *file_name = file_source_next(walker->source);
+        if (!file_name) {
+            return NULL;
+        }
+        struct stat st;
+        if (!stat(file_name, &st) && S_ISDIR(st.st_mode)) {
+            file_walker_push(walker, file_name);
+            continue;
         }
+        *from_directory = 0;
+        return file_name;
+    }
+}
 
-        int section_number = ELF_file_data.ehdr.e_shnum;                       // 段的数量
-        unsigned long long section_table_offset = ELF_file_data.ehdr.e_shoff;  // 段表的偏移量
-        lseek(fd, section_table_offset, SEEK_SET);
+static void file_walker_free(FileWalker *walker) {
+    while (walker->frame_number) {
+        file_walker_pop(walker);
+    }
+    free(walker->frames);
+}
 
-        // 读取段表的所有信息, 保存在 shdr 中
-        ELF_file_data.shdr = malloc(sizeof(Elf64_Shdr) * section_number);
-        if (read(fd, ELF_file_data.shdr, sizeof(Elf64_Shdr) * section_number) < 0) {
-            perror("read");
-            munmap(addr, size);
+// 多个文件或目录中内容相同的文件只显示第一个, 之后的文件只输出 identical to <path>
+// 只有大小相同的文件才读取开头和结尾的一块比较, 这些也相同时才计算整个文件的哈希, 大多数文件只需要一次 stat
+// 哈希也相同时最后逐字节比较确认
+
+#define DEDUP_BLOCK_SIZE 4096
+
+enum dedup_state { DEDUP_INVALID = -1, DEDUP_STAT, DEDUP_HEAD_TAIL, DEDUP_CONTENT };
+
+typedef struct {
+    char *path;  // NULL 表示空槽
+    uint64_t size;
+    dev_t dev;
+    ino_t ino;
+    int state;                // enum dedup_state, 读取失败或者不是 ELF/普通静态库时为 DEDUP_INVALID
+    uint64_t head_tail_hash;  // 开头和结尾各 DEDUP_BLOCK_SIZE 字节
+    uint64_t content_hash;
+} DedupFile;
+
+// 以文件大小为键的开放寻址表, 大小相同的文件都在同一段探测序列中
+typedef struct {
+    DedupFile *files;
+    uint64_t file_number;
+    uint64_t capacity;  // 2 的幂
+} DedupTable;
+
+static uint64_t dedup_slot(DedupTable *table, uint64_t size) {
+    return ((size * 0x9E3779B97F4A7C15ULL) >> 32) & (table->capacity - 1);
+}
+
+static void dedup_grow(DedupTable *table) {
+    DedupFile *old_files = table->files;
+    uint64_t old_capacity = table->capacity;
+    table->capacity = old_capacity ? old_capacity * 2 : 256;
+    table->files = calloc(table->capacity, sizeof(DedupFile));
+    for (uint64_t i = 0; i < old_capacity; i++) {
+        if (old_files[i].path) {
+            uint64_t slot = dedup_slot(table, old_files[i].size);
+            while (table->files[slot].path) {
+                slot = (slot + 1) & (table->capacity - 1);
+            }
+            table->files[slot] = old_files[i];
+        }
+    }
+    free(old_files);
+}
+
+/**
+ * @brief 按需读取文件, 计算到 state 为止的哈希
+ *
+ * @return int 成功返回 0, 文件无法读取或者不是 ELF/普通静态库返回 -1
+ *             thin 静态库的成员路径相对于静态库所在的目录, 内容相同也不一定是同一个库
+ */
+static int dedup_load(DedupFile *file, int state) {
+    if (file->state == DEDUP_INVALID) {
+        return -1;
+    }
+    if (file->state >= state) {
+        return 0;
+    }
+    int fd = open(file->path, O_RDONLY);
+    if (fd < 0) {
+        file->state = DEDUP_INVALID;
+        return -1;
+    }
+    if (file->state < DEDUP_HEAD_TAIL) {
+        // 先检查魔数, 不是 ELF 的文件不再读取结尾
+        char blocks[DEDUP_BLOCK_SIZE * 2];
+        uint64_t block_size = file->size < DEDUP_BLOCK_SIZE ? file->size : DEDUP_BLOCK_SIZE;
+        if (pread(fd, blocks, block_size, 0) != (ssize_t)block_size ||
+            (memcmp(blocks, ELFMAG, block_size < SELFMAG ? block_size : SELFMAG) &&
+             memcmp(blocks, ARMAG, block_size < SARMAG ? block_size : SARMAG)) ||
+            pread(fd, blocks + block_size, block_size, file->size - block_size) != (ssize_t)block_size) {
+            file->state = DEDUP_INVALID;
             close(fd);
-            XBOX_free_argparse(&parser);
-            free(ELF_file_data.shdr);
-            exit(1);
+            return -1;
+        }
+        file->head_tail_hash = XBOX_hash64(blocks, block_size * 2, file->size);
+        file->state = DEDUP_HEAD_TAIL;
+    }
+    if (state == DEDUP_CONTENT) {
+        void *addr = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            file->state = DEDUP_INVALID;
+            close(fd);
+            return -1;
         }
+        madvise(addr, file->size, MADV_SEQUENTIAL);
+        file->content_hash = XBOX_hash64(addr, file->size, file->size);
+        file->state = DEDUP_CONTENT;
+        munmap(addr, file->size);
+    }
+    close(fd);
+    return 0;
+}
 
-        // 段表字符串表的索引
-        int section_string_index = ELF_file_data.ehdr.e_shstrndx;
+/**
+ * @brief 哈希相同之后逐字节比较两个文件, 避免哈希碰撞时错误地输出 identical to
+ *
+ * @return int 内容相同返回 1
+ */
+static int dedup_same_content(const DedupFile *file, const DedupFile *other) {
+    int same = 0;
+    int fd = open(file->path, O_RDONLY);
+    int other_fd = open(other->path, O_RDONLY);
+    void *addr = fd < 0 ? MAP_FAILED : mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    void *other_addr = other_fd < 0 ? MAP_FAILED : mmap(NULL, other->size, PROT_READ, MAP_PRIVATE, other_fd, 0);
+    if (addr != MAP_FAILED && other_addr != MAP_FAILED) {
+        madvise(addr, file->size, MADV_SEQUENTIAL);
+        madvise(other_addr, other->size, MADV_SEQUENTIAL);
+        same = !memcmp(addr, other_addr, file->size);
+    }
+    if (addr != MAP_FAILED) {
+        munmap(addr, file->size);
+    }
+    if (other_addr != MAP_FAILED) {
+        munmap(other_addr, other->size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (other_fd >= 0) {
+        close(other_fd);
+    }
+    return same;
+}
 
-        // 段表字符串表的偏移量
-        Elf64_Off shstrtab_offset = ELF_file_data.shdr[section_string_index].sh_offset;
-        ELF_file_data.shstrtab_offset = shstrtab_offset;
-        if (display_header) {
-            display_elf_header(&ELF_file_data);
+/**
+ * @brief 查找之前记录的内容相同的文件
+ *
+ * @param table
+ * @param file_name
+ * @param st 调用者已经有的 fstat 结果, 为 NULL 时 stat file_name
+ * @param file 输出这个文件的记录, 成功显示之后交给 dedup_add; 不参与查找的文件 path 为 NULL
+ * @return const char* 内容相同的文件名, 在 dedup_free 之前有效, 没有找到返回 NULL
+ */
+static const char *dedup_find(DedupTable *table, const char *file_name, const struct stat *st, DedupFile *file) {
+    memset(file, 0, sizeof(DedupFile));
+    struct stat file_stat;
+    if (!st) {
+        if (stat(file_name, &file_stat)) {
+            return NULL;
         }
-        if (display_section_table) {
-            display_elf_section_table(&ELF_file_data);
+        st = &file_stat;
+    }
+    if (!S_ISREG(st->st_mode) || st->st_size == 0) {
+        return NULL;
+    }
+    file->path = (char *)file_name;
+    file->size = st->st_size;
+    file->dev = st->st_dev;
+    file->ino = st->st_ino;
+    file->state = DEDUP_STAT;
+    if (!table->capacity) {
+        return NULL;
+    }
+    uint64_t slot = dedup_slot(table, file->size);
+    for (; table->files[slot].path; slot = (slot + 1) & (table->capacity - 1)) {
+        DedupFile *other = &table->files[slot];
+        if (other->size != file->size) {
+            continue;
         }
-        if (display_symbol_table) {
-            display_elf_symbol_table(&ELF_file_data);
+        if (other->dev == file->dev && other->ino == file->ino) {
+            // 同一个文件, 例如硬链接或者重复的参数
+            return other->path;
         }
-        if (display_relocations) {
-            display_elf_relocation_table(&ELF_file_data);
+        if (dedup_load(file, DEDUP_HEAD_TAIL) || dedup_load(other, DEDUP_HEAD_TAIL) ||
+            other->head_tail_hash != file->head_tail_hash) {
+            continue;
         }
-        if (display_program_header) {
-            display_elf_program_header(&ELF_file_data);
+        if (dedup_load(file, DEDUP_CONTENT) || dedup_load(other, DEDUP_CONTENT)) {
+            continue;
+        }
+        if (other->content_hash == file->content_hash && dedup_same_content(file, other)) {
+            return other->path;
         }
-        munmap(addr, size);
-        close(fd);
-        free(ELF_file_data.shdr);
     }
-    XBOX_free_argparse(&parser);
-    return 0;
+    return NULL;
+}
+
+/**
+ * @brief 记录一个成功显示的文件, 之后内容相同的文件只输出 identical to
+ *        显示失败的文件不记录, 它的副本会再显示一次并报告同样的错误
+ *
+ * @param table
+ * @param file dedup_find 输出的记录
+ */
+static void dedup_add(DedupTable *table, DedupFile *file) {
+    if (!file->path) {
+        return;
+    }
+    // 负载因子不超过 0.5
+    if ((table->file_number + 1) * 2 > table->capacity) {
+        dedup_grow(table);
+    }
+    uint64_t slot = dedup_slot(table, file->size);
+    while (table->files[slot].path) {
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    table->files[slot] = *file;
+    table->files[slot].path = strdup(file->path);
+    table->file_number++;
+}
+
+static void dedup_free(DedupTable *table) {
+    for (uint64_t i = 0; i < table->capacity; i++) {
+        free(table->files[i].path);
+    }
+    free(table->files);
+}
+
+static void dedup_print(const char *file_name, const char *original) {
+    printf("\nFile: %s\nidentical to %s\n", file_name, original);
+}
+
+/**
+ * @brief 在一段 note 数据中查找 NT_GNU_BUILD_ID
+ *
+ * @param notes note 数据
+ * @param size note 数据的长度
+ * @param align note 的对齐方式(4 或 8)
+ * @param build_id 输出 build-id 的原始字节
+ * @return int build-id 的长度, 未找到返回 0
+ */
+static int find_build_id_note(const char *notes, uint64_t size, uint64_t align, unsigned char *build_id) {
+    // typedef struct {
+    //     Elf64_Word n_namesz;
+    //     Elf64_Word n_descsz;
+    //     Elf64_Word n_type;
+    // } Elf64_Nhdr;
+    uint64_t offset = 0;
+    align = align == 8 ? 8 : 4;
+    while (offset + sizeof(Elf64_Nhdr) <= size) {
+        Elf64_Nhdr *nhdr = (Elf64_Nhdr *)(notes + offset);
+        uint64_t name_offset = offset + sizeof(Elf64_Nhdr);
+        uint64_t desc_offset = name_offset + ((nhdr->n_namesz + align - 1) & ~(align - 1));
+        uint64_t next_offset = desc_offset + ((nhdr->n_descsz + align - 1) & ~(align - 1));
+        if (desc_offset + nhdr->n_descsz > size) {
+            break;
+        }
+        if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == 4 && !memcmp(notes + name_offset, "GNU", 4)) {
+            if (nhdr->n_descsz == 0 || nhdr->n_descsz > BUILD_ID_MAX_SIZE) {
+                return 0;
+            }
+            memcpy(build_id, notes + desc_offset, nhdr->n_descsz);
+            return (int)nhdr->n_descsz;
+        }
+        offset = next_offset;
+    }
+    return 0;
+}
+
+/**
+ * @brief 读取文件中 [offset, offset + size) 的内容并查找 build-id
+ *
+ * @param fd
+ * @param offset
+ * @param size
+ * @param align
+ * @param build_id
+ * @return int build-id 的长度, 未找到返回 0
+ */
+static int read_build_id_note(int fd, uint64_t offset, uint64_t size, uint64_t align, unsigned char *build_id) {
+    // note 段一般只有几十个字节, 过大的认为是损坏的文件
+    if (size == 0 || size > BUILD_ID_NOTE_MAX_SIZE) {
+        return 0;
+    }
+    char *notes = malloc(size);
+    int length = 0;
+    if (pread(fd, notes, size, offset) == (ssize_t)size) {
+        length = find_build_id_note(notes, size, align, build_id);
+    }
+    free(notes);
+    return length;
+}
+
+/**
+ * @brief 获取 ELF 文件的 build-id
+ *        只读取 ELF 头, 程序头表和 PT_NOTE 段, 不对整个文件做内存映射;
+ *        没有程序头表的可重定位文件退而读取段表中的 SHT_NOTE 段
+ *
+ * @param fd
+ * @param build_id 输出 build-id 的原始字节, 至少 BUILD_ID_MAX_SIZE 字节
+ * @return int build-id 的长度, 未找到返回 0, 不是 ELF64 文件返回 -1
+ */
+static int read_elf_build_id(int fd, unsigned char *build_id) {
+    Elf64_Ehdr ehdr;
+    if (pread(fd, &ehdr, sizeof(Elf64_Ehdr), 0) != sizeof(Elf64_Ehdr) || memcmp(ehdr.e_ident, ELFMAG, SELFMAG) ||
+        ehdr.e_ident[EI_CLASS] != ELFCLASS64) {
+        return -1;
+    }
+
+    int length = 0;
+    if (ehdr.e_phnum && ehdr.e_phnum != PN_XNUM && ehdr.e_phentsize == sizeof(Elf64_Phdr)) {
+        size_t phdr_size = sizeof(Elf64_Phdr) * ehdr.e_phnum;
+        Elf64_Phdr *phdr = malloc(phdr_size);
+        if (pread(fd, phdr, phdr_size, ehdr.e_phoff) == (ssize_t)phdr_size) {
+            for (int i = 0; i < ehdr.e_phnum && !length; i++) {
+                if (phdr[i].p_type == PT_NOTE) {
+                    length = read_build_id_note(fd, phdr[i].p_offset, phdr[i].p_filesz, phdr[i].p_align, build_id);
+                }
+            }
+        }
+        free(phdr);
+        return length;
+    }
+
+    if (ehdr.e_shnum && ehdr.e_shentsize == sizeof(Elf64_Shdr)) {
+        size_t shdr_size = sizeof(Elf64_Shdr) * ehdr.e_shnum;
+        Elf64_Shdr *shdr = malloc(shdr_size);
+        if (pread(fd, shdr, shdr_size, ehdr.e_shoff) == (ssize_t)shdr_size) {
+            for (int i = 0; i < ehdr.e_shnum && !length; i++) {
+                if (shdr[i].sh_type == SHT_NOTE) {
+                    length =
+                        read_build_id_note(fd, shdr[i].sh_offset, shdr[i].sh_size, shdr[i].sh_addralign, build_id);
+                }
+            }
+        }
+        free(shdr);
+    }
+    return length;
+}
+
+/**
+ * @brief build-id 转为十六进制字符串
+ *
+ * @param build_id
+ * @param length
+ * @return char* 静态缓冲区
+ */
+static char *build_id_to_hex(const unsigned char *build_id, int length) {
+    static char hex[BUILD_ID_MAX_SIZE * 2 + 1];
+    for (int i = 0; i < length; i++) {
+        snprintf(hex + i * 2, 3, "%02x", build_id[i]);
+    }
+    hex[length * 2] = 0;
+    return hex;
+}
+
+/**
+ * @brief 十六进制字符串转为 build-id
+ *
+ * @param hex
+ * @param build_id
+ * @return int build-id 的长度, 格式错误返回 -1
+ */
+static int hex_to_build_id(const char *hex, unsigned char *build_id) {
+    int n = (int)strlen(hex);
+    if (n == 0 || n % 2 || n > BUILD_ID_MAX_SIZE * 2) {
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        int c = hex[i];
+        int value;
+        if (c >= '0' && c <= '9') {
+            value = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            value = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            value = c - 'A' + 10;
+        } else {
+            return -1;
+        }
+        if (i % 2) {
+            build_id[i / 2] |= value;
+        } else {
+            build_id[i / 2] = value << 4;
+        }
+    }
+    return n / 2;
+}
+
+/**
+ * @brief readelf --build-id 输出文件的 build-id
+ *
+ * @param file_name
+ * @return int 成功返回 0
+ */
+int display_elf_build_id(const char *file_name) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "open fail: %s: %s\n", file_name, strerror(errno));
+        return 1;
+    }
+    unsigned char build_id[BUILD_ID_MAX_SIZE];
+    int length = read_elf_build_id(fd, build_id);
+    close(fd);
+    if (length < 0) {
+        fprintf(stderr, "readelf Error: Not an ELF64 file: %s\n", file_name);
+        return 1;
+    }
+    if (length == 0) {
+        fprintf(stderr, "readelf Warning: No build-id found in %s\n", file_name);
+        return 1;
+    }
+    printf("%s  %s\n", build_id_to_hex(build_id, length), file_name);
+    return 0;
+}
+
+// build-id 索引文件格式:
+//
+// +-------------------+
+// | BuildIdIndexHeader|
+// +-------------------+
+// | BuildIdIndexEntry | 按 build_id 排序, 查询时直接 mmap 后二分查找
+// | ...               |
+// +-------------------+
+// | path 字符串表      | 以 \0 结尾的路径
+// +-------------------+
+
+#define BUILD_ID_INDEX_MAGIC "BUILDIDX"
+#define BUILD_ID_INDEX_VERSION 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint64_t entry_number;
+    uint64_t strtab_offset;
+    uint64_t strtab_size;
+} BuildIdIndexHeader;
+
+typedef struct {
+    unsigned char build_id[BUILD_ID_MAX_SIZE];  // 不足的部分补 0
+    uint64_t path_offset;                       // 路径在字符串表中的偏移
+    uint32_t build_id_size;
+    uint32_t reserved;
+} BuildIdIndexEntry;
+
+typedef struct {
+    BuildIdIndexEntry *entries;
+    uint64_t entry_number;
+    uint64_t entry_capacity;
+    char *strtab;
+    uint64_t strtab_size;
+    uint64_t strtab_capacity;
+} BuildIdIndex;
+
+static int build_id_entry_cmp(const void *a, const void *b) {
+    const BuildIdIndexEntry *e1 = (const BuildIdIndexEntry *)a;
+    const BuildIdIndexEntry *e2 = (const BuildIdIndexEntry *)b;
+    int result = memcmp(e1->build_id, e2->build_id, BUILD_ID_MAX_SIZE);
+    if (result) {
+        return result;
+    }
+    return (int)e1->build_id_size - (int)e2->build_id_size;
+}
+
+static void build_id_index_add(BuildIdIndex *index, const unsigned char *build_id, int length, const char *path) {
+    if (index->entry_number == index->entry_capacity) {
+        index->entry_capacity = index->entry_capacity ? index->entry_capacity * 2 : 1024;
+        index->entries = realloc(index->entries, sizeof(BuildIdIndexEntry) * index->entry_capacity);
+    }
+    uint64_t path_length = strlen(path) + 1;
+    while (index->strtab_size + path_length > index->strtab_capacity) {
+        index->strtab_capacity = index->strtab_capacity ? index->strtab_capacity * 2 : 64 * 1024;
+        index->strtab = realloc(index->strtab, index->strtab_capacity);
+    }
+    BuildIdIndexEntry *entry = &index->entries[index->entry_number++];
+    memset(entry, 0, sizeof(BuildIdIndexEntry));
+    memcpy(entry->build_id, build_id, length);
+    entry->build_id_size = length;
+    entry->path_offset = index->strtab_size;
+    memcpy(index->strtab + index->strtab_size, path, path_length);
+    index->strtab_size += path_length;
+}
+
+/**
+ * @brief 收集一个文件的 build-id
+ *
+ * @param full_path
+ * @param data BuildIdIndex
+ */
+static void build_id_index_add_file(const char *full_path, void *data) {
+    int fd = open(full_path, O_RDONLY);
+    if (fd >= 0) {
+        unsigned char build_id[BUILD_ID_MAX_SIZE];
+        int length = read_elf_build_id(fd, build_id);
+        if (length > 0) {
+            build_id_index_add((BuildIdIndex *)data, build_id, length, full_path);
+        }
+        close(fd);
+    }
+}
+
+/**
+ * @brief readelf --build-id-index DIR 扫描目录并写入排序后的 build-id 索引文件
+ *
+ * @param dir_name
+ * @param index_file_name
+ * @return int 成功返回 0
+ */
+int create_build_id_index(const char *dir_name, const char *index_file_name) {
+    BuildIdIndex index;
+    memset(&index, 0, sizeof(BuildIdIndex));
+    walk_directory(dir_name, build_id_index_add_file, &index);
+    qsort(index.entries, index.entry_number, sizeof(BuildIdIndexEntry), build_id_entry_cmp);
+
+    BuildIdIndexHeader header;
+    memset(&header, 0, sizeof(BuildIdIndexHeader));
+    memcpy(header.magic, BUILD_ID_INDEX_MAGIC, 8);
+    header.version = BUILD_ID_INDEX_VERSION;
+    header.entry_size = sizeof(BuildIdIndexEntry);
+    header.entry_number = index.entry_number;
+    header.strtab_offset = sizeof(BuildIdIndexHeader) + sizeof(BuildIdIndexEntry) * index.entry_number;
+    header.strtab_size = index.strtab_size;
+
+    int result = 0;
+    FILE *fp = fopen(index_file_name, "wb");
+    if (!fp) {
+        fprintf(stderr, "open fail: %s: %s\n", index_file_name, strerror(errno));
+        result = 1;
+    } else {
+        if (fwrite(&header, sizeof(BuildIdIndexHeader), 1, fp) != 1 ||
+            fwrite(index.entries, sizeof(BuildIdIndexEntry), index.entry_number, fp) != index.entry_number ||
+            fwrite(index.strtab, 1, index.strtab_size, fp) != index.strtab_size) {
+            fprintf(stderr, "write fail: %s: %s\n", index_file_name, strerror(errno));
+            result = 1;
+        }
+        fclose(fp);
+    }
+    if (!result) {
+        printf("%lu build-ids indexed in %s\n", index.entry_number, index_file_name);
+    }
+    free(index.entries);
+    free(index.strtab);
+    return result;
+}
+
+/**
+ * @brief readelf --build-id-lookup ID 在索引文件中二分查找 build-id 对应的路径
+ *
+ * @param index_file_name
+ * @param hex
+ * @return int 找到返回 0
+ */
+int lookup_build_id_index(const char *index_file_name, const char *hex) {
+    BuildIdIndexEntry key;
+    memset(&key, 0, sizeof(BuildIdIndexEntry));
+    int length = hex_to_build_id(hex, key.build_id);
+    if (length < 0) {
+        fprintf(stderr, "readelf Error: invalid build-id %s\n", hex);
+        return 1;
+    }
+    key.build_id_size = length;
+
+    int fd = open(index_file_name, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "open fail: %s: %s\n", index_file_name, strerror(errno));
+        return 1;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < (off_t)sizeof(BuildIdIndexHeader)) {
+        fprintf(stderr, "readelf Error: invalid build-id index %s\n", index_file_name);
+        close(fd);
+        return 1;
+    }
+    void *addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        fprintf(stderr, "mmap fail: %s: %s\n", index_file_name, strerror(errno));
+        return 1;
+    }
+
+    BuildIdIndexHeader *header = (BuildIdIndexHeader *)addr;
+    if (memcmp(header->magic, BUILD_ID_INDEX_MAGIC, 8) || header->version != BUILD_ID_INDEX_VERSION ||
+        header->entry_size != sizeof(BuildIdIndexEntry) ||
+        header->strtab_offset + header->strtab_size > (uint64_t)size ||
+        sizeof(BuildIdIndexHeader) + header->entry_number * sizeof(BuildIdIndexEntry) > header->strtab_offset) {
+        fprintf(stderr, "readelf Error: invalid build-id index %s\n", index_file_name);
+        munmap(addr, size);
+        return 1;
+    }
+    BuildIdIndexEntry *entries = (BuildIdIndexEntry *)((char *)addr + sizeof(BuildIdIndexHeader));
+    char *strtab = (char *)addr + header->strtab_offset;
+
+    // 二分查找第一个匹配的位置, 同一个 build-id 可能对应多个路径
+    uint64_t left = 0, right = header->entry_number;
+    while (left < right) {
+        uint64_t mid = left + (right - left) / 2;
+        if (build_id_entry_cmp(&entries[mid], &key) < 0) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    int found = 0;
+    for (uint64_t i = left; i < header->entry_number && !build_id_entry_cmp(&entries[i], &key); i++) {
+        if (entries[i].path_offset < header->strtab_size) {
+            printf("%s\n", strtab + entries[i].path_offset);
+            found = 1;
+        }
+    }
+    munmap(addr, size);
+    if (!found) {
+        fprintf(stderr, "readelf Warning: build-id %s not found in %s\n", hex, index_file_name);
+        return 1;
+    }
+    return 0;
+}
+
+// 除了 -h 以外都需要段表
+#define IO_NEED_SECTION_TABLE(options)                                                                           \
+    ((options)->display_section_table || (options)->display_symbol_table ||                                      \
+     (options)->display_dynamic_symbol_table || (options)->display_relocations || (options)->display_program_header || \
+     (options)->display_version_info || (options)->display_reloc_stats)
+
+typedef struct {
+    uint64_t offset;
+    uint64_t size;
+} IORange;
+
+typedef struct {
+    IORange *ranges;
+    int range_number;
+    int range_capacity;
+    uint64_t fetched_size;  // 页对齐后实际需要读取的字节数
+} IOPlan;
+
+static void io_plan_add(IOPlan *plan, uint64_t offset, uint64_t size, uint64_t file_size) {
+    // 超出文件范围的部分不读取
+    if (size == 0 || offset >= file_size) {
+        return;
+    }
+    if (size > file_size - offset) {
+        size = file_size - offset;
+    }
+    if (plan->range_number == plan->range_capacity) {
+        plan->range_capacity = plan->range_capacity ? plan->range_capacity * 2 : 16;
+        plan->ranges = realloc(plan->ranges, sizeof(IORange) * plan->range_capacity);
+    }
+    plan->ranges[plan->range_number].offset = offset;
+    plan->ranges[plan->range_number].size = size;
+    plan->range_number++;
+}
+
+static void io_plan_add_section(IOPlan *plan, ELF *ELF_file_data, uint64_t index, uint64_t file_size) {
+    if (index >= ELF_file_data->ehdr.e_shnum) {
+        return;
+    }
+    Elf64_Shdr *shdr = &ELF_file_data->shdr[index];
+    if (shdr->sh_type != SHT_NOBITS) {
+        io_plan_add(plan, shdr->sh_offset, shdr->sh_size, file_size);
+    }
+}
+
+static int io_range_cmp(const void *a, const void *b) {
+    const IORange *r1 = (const IORange *)a;
+    const IORange *r2 = (const IORange *)b;
+    if (r1->offset == r2->offset) {
+        return 0;
+    }
+    return r1->offset < r2->offset ? -1 : 1;
+}
+
+/**
+ * @brief 根据需要显示的内容计算需要读取的文件范围
+ *        ELF 头(-h), 程序头表(-l), 段表和段表字符串表(-S -s -r -l),
+ *        以及 -s/-r 用到的符号表, 字符串表和重定位表
+ *        结果按偏移排序并以页为单位合并
+ *
+ * @param plan
+ * @param ELF_file_data
+ * @param file_size
+ */
+static void io_plan_build(IOPlan *plan, ELF *ELF_file_data, uint64_t file_size, ReadelfOptions *options) {
+    memset(plan, 0, sizeof(IOPlan));
+    Elf64_Ehdr *ehdr = &ELF_file_data->ehdr;
+    io_plan_add(plan, 0, sizeof(Elf64_Ehdr), file_size);
+
+    if (IO_NEED_SECTION_TABLE(options)) {
+        io_plan_add(plan, ehdr->e_shoff, (uint64_t)ehdr->e_shnum * sizeof(Elf64_Shdr), file_size);
+        io_plan_add_section(plan, ELF_file_data, ehdr->e_shstrndx, file_size);
+    }
+    if (options->display_program_header) {
+        io_plan_add(plan, ehdr->e_phoff, (uint64_t)ehdr->e_phnum * sizeof(Elf64_Phdr), file_size);
+        for (int i = 0; i < ehdr->e_shnum; i++) {
+            Elf64_Shdr *shdr = &ELF_file_data->shdr[i];
+            // RELF_interpreter 读取的 .interp 段
+            if (shdr->sh_type == SHT_PROGBITS) {
+                char *section_name = RELF_section_name(ELF_file_data, shdr);
+                if (!strcmp(section_name, ".interp")) {
+                    io_plan_add_section(plan, ELF_file_data, i, file_size);
+                }
+            }
+        }
+    }
+    int need_version = options->display_symbol_table || options->display_dynamic_symbol_table ||
+                       options->display_version_info || options->display_relocations;
+    int need_relocation = options->display_relocations || options->display_reloc_stats;
+    for (int i = 0; i < ehdr->e_shnum && (need_version || need_relocation); i++) {
+        Elf64_Shdr *shdr = &ELF_file_data->shdr[i];
+        if ((options->display_symbol_table && shdr->sh_type == SHT_SYMTAB) ||
+            ((options->display_symbol_table || options->display_dynamic_symbol_table) && shdr->sh_type == SHT_DYNSYM) ||
+            (need_version && (shdr->sh_type == SHT_GNU_versym || shdr->sh_type == SHT_GNU_verdef ||
+                              shdr->sh_type == SHT_GNU_verneed))) {
+            // 符号表和对应的字符串表, 符号版本段和对应的字符串表
+            io_plan_add_section(plan, ELF_file_data, i, file_size);
+            io_plan_add_section(plan, ELF_file_data, shdr->sh_link, file_size);
+        } else if (need_relocation &&
+                   (shdr->sh_type == SHT_RELA || shdr->sh_type == SHT_REL || shdr->sh_type == SHT_RELR)) {
+            // 重定位表, 对应的符号表和符号表的字符串表
+            io_plan_add_section(plan, ELF_file_data, i, file_size);
+            if (shdr->sh_link < ehdr->e_shnum) {
+                io_plan_add_section(plan, ELF_file_data, shdr->sh_link, file_size);
+                io_plan_add_section(plan, ELF_file_data, ELF_file_data->shdr[shdr->sh_link].sh_link, file_size);
+            }
+        }
+    }
+
+    // 页对齐后排序合并
+    uint64_t page_size = sysconf(_SC_PAGESIZE);
+    for (int i = 0; i < plan->range_number; i++) {
+        IORange *range = &plan->ranges[i];
+        uint64_t end = range->offset + range->size;
+        range->offset &= ~(page_size - 1);
+        range->size = ((end + page_size - 1) & ~(page_size - 1)) - range->offset;
+    }
+    qsort(plan->ranges, plan->range_number, sizeof(IORange), io_range_cmp);
+    int n = 0;
+    for (int i = 0; i < plan->range_number; i++) {
+        if (n && plan->ranges[i].offset <= plan->ranges[n - 1].offset + plan->ranges[n - 1].size) {
+            uint64_t end = plan->ranges[i].offset + plan->ranges[i].size;
+            if (end > plan->ranges[n - 1].offset + plan->ranges[n - 1].size) {
+                plan->ranges[n - 1].size = end - plan->ranges[n - 1].offset;
+            }
+        } else {
+            plan->ranges[n++] = plan->ranges[i];
+        }
+    }
+    plan->range_number = n;
+    for (int i = 0; i < n; i++) {
+        uint64_t end = plan->ranges[i].offset + plan->ranges[i].size;
+        // 最后一页可能超出文件末尾
+        plan->fetched_size += (end > file_size ? file_size : end) - plan->ranges[i].offset;
+    }
+}
+
+/**
+ * @brief 对需要的范围发起 MADV_WILLNEED 异步预读, 之后访问时不再逐页等待
+ *
+ * @param plan
+ * @param addr
+ */
+static void io_plan_prefetch(IOPlan *plan, void *addr) {
+    for (int i = 0; i < plan->range_number; i++) {
+        madvise((char *)addr + plan->ranges[i].offset, plan->ranges[i].size, MADV_WILLNEED);
+    }
+}
+
+/**
+ * @brief readelf --io-stats 输出读取的字节数与文件大小
+ *
+ * @param plan
+ * @param file_name
+ * @param file_size
+ */
+static void io_plan_report(IOPlan *plan, const char *file_name, uint64_t file_size) {
+    fprintf(stderr,
+            "readelf: %s: fetched %lu of %lu bytes (%.2f%%) in %d %s\n",
+            file_name,
+            plan->fetched_size,
+            file_size,
+            file_size ? plan->fetched_size * 100.0 / file_size : 0.0,
+            plan->range_number,
+            plan->range_number == 1 ? "range" : "ranges");
+}
+
+static void io_plan_free(IOPlan *plan) {
+    free(plan->ranges);
+    plan->ranges = NULL;
+}
+
+// --batch 批量读取: 每个文件按 open -> statx -> ELF 头 -> 段表 -> 段表字符串表 -> close 的依赖顺序发起请求
+// 同时保持 queue depth 个文件在飞, io_uring 不可用时退回同步的 fstat 和 pread
+
+enum batch_stage { BATCH_OPEN, BATCH_STAT, BATCH_EHDR, BATCH_SHDR, BATCH_SHSTRTAB, BATCH_CLOSE, BATCH_DONE };
+
+typedef struct {
+    char *file_name;
+    int from_directory;  // 目录展开得到的文件, 不是 ELF 时不报错
+} BatchFile;
+
+typedef struct {
+    BatchFile *files;
+    int file_number;
+    int file_capacity;
+} BatchFileList;
+
+typedef struct {
+    BatchFile file;  // file_name 由 slot 持有, 输出之后释放
+    int stage;
+    int fd;
+    int error;           // 0 或者 errno, -1 表示不是 ELF64 文件
+    struct stat st;      // 文件大小用于检查段表字符串表的范围, dev/ino 用于查找内容相同的文件
+    struct statx statx;  // io_uring 的 statx 结果, 完成之后转换到 st
+    ELF ELF_file_data;
+    char *shstrtab;
+    uint64_t shstrtab_size;
+    ReadelfOptions *options;
+} BatchSlot;
+
+static void batch_add_file(BatchFileList *list, const char *file_name, int from_directory) {
+    if (list->file_number == list->file_capacity) {
+        list->file_capacity = list->file_capacity ? list->file_capacity * 2 : 1024;
+        list->files = realloc(list->files, sizeof(BatchFile) * list->file_capacity);
+    }
+    list->files[list->file_number].file_name = strdup(file_name);
+    list->files[list->file_number].from_directory = from_directory;
+    list->file_number++;
+}
+
+/**
+ * @brief 收集 --io-bench 需要处理的文件, 目录会被递归展开
+ *        --io-bench 对同一组文件运行多轮, 需要完整的列表; --batch 和 --bloat 使用 FileWalker
+ *
+ * @param list
+ * @param source
+ */
+static void batch_collect_files(BatchFileList *list, FileSource *source) {
+    memset(list, 0, sizeof(BatchFileList));
+    FileWalker walker;
+    file_walker_init(&walker, source);
+    const char *file_name;
+    int from_directory;
+    while ((file_name = file_walker_next(&walker, &from_directory))) {
+        batch_add_file(list, file_name, from_directory);
+    }
+    file_walker_free(&walker);
+}
+
+static void batch_free_files(BatchFileList *list) {
+    for (int i = 0; i < list->file_number; i++) {
+        free(list->files[i].file_name);
+    }
+    free(list->files);
+}
+
+static void batch_slot_init(BatchSlot *slot, BatchFile file, ReadelfOptions *options) {
+    memset(slot, 0, sizeof(BatchSlot));
+    slot->file = file;
+    slot->options = options;
+    slot->fd = -1;
+    slot->stage = BATCH_OPEN;
+}
+
+/**
+ * @brief 段的内容是否在文件范围内, 避免按照损坏的 sh_size 分配内存
+ */
+static int batch_section_in_file(Elf64_Shdr *shdr, struct stat *st) {
+    uint64_t file_size = st->st_size;
+    return shdr->sh_offset <= file_size && shdr->sh_size <= file_size - shdr->sh_offset;
+}
+
+/**
+ * @brief 只填写段范围检查和 dedup_find 用到的字段
+ */
+static void batch_stat_from_statx(struct stat *st, struct statx *stx) {
+    memset(st, 0, sizeof(struct stat));
+    st->st_dev = makedev(stx->stx_dev_major, stx->stx_dev_minor);
+    st->st_ino = stx->stx_ino;
+    st->st_mode = stx->stx_mode;
+    st->st_size = stx->stx_size;
+}
+
+/**
+ * @brief 处理当前阶段请求的结果, 进入下一个阶段
+ *
+ * @param slot
+ * @param result 系统调用的返回值, 失败为 -errno
+ */
+static void batch_slot_complete(BatchSlot *slot, int result) {
+    Elf64_Ehdr *ehdr = &slot->ELF_file_data.ehdr;
+    if (result < 0 && slot->stage != BATCH_CLOSE) {
+        slot->error = -result;
+        slot->stage = slot->fd >= 0 ? BATCH_CLOSE : BATCH_DONE;
+        return;
+    }
+    switch (slot->stage) {
+        case BATCH_OPEN:
+            slot->fd = result;
+            slot->stage = BATCH_STAT;
+            break;
+        case BATCH_STAT:
+            // 同步执行时 fstat 直接写入 st, statx 保持为 0
+            if (slot->statx.stx_mask) {
+                batch_stat_from_statx(&slot->st, &slot->statx);
+            }
+            slot->stage = BATCH_EHDR;
+            break;
+        case BATCH_EHDR:
+            if (result != sizeof(Elf64_Ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) ||
+                ehdr->e_ident[EI_CLASS] != ELFCLASS64) {
+                slot->error = -1;
+                slot->stage = BATCH_CLOSE;
+            } else if (slot->options->display_section_table && ehdr->e_shnum) {
+                slot->ELF_file_data.shdr = malloc(sizeof(Elf64_Shdr) * ehdr->e_shnum);
+                slot->stage = BATCH_SHDR;
+            } else {
+                slot->stage = BATCH_CLOSE;
+            }
+            break;
+        case BATCH_SHDR:
+            if (result != (int)(sizeof(Elf64_Shdr) * ehdr->e_shnum) || ehdr->e_shstrndx >= ehdr->e_shnum ||
+                !batch_section_in_file(&slot->ELF_file_data.shdr[ehdr->e_shstrndx], &slot->st)) {
+                slot->error = -1;
+                slot->stage = BATCH_CLOSE;
+            } else {
+                // 段表字符串表单独读入一块内存, 下面的 ELF.addr 指向它且 shstrtab_offset 为 0
+                // display_elf_section_table 只通过 addr + shstrtab_offset 访问段名
+                slot->shstrtab_size = slot->ELF_file_data.shdr[ehdr->e_shstrndx].sh_size;
+                slot->shstrtab = calloc(1, slot->shstrtab_size + 1);
+                if (slot->shstrtab) {
+                    slot->stage = BATCH_SHSTRTAB;
+                } else {
+                    slot->error = ENOMEM;
+                    slot->stage = BATCH_CLOSE;
+                }
+            }
+            break;
+        case BATCH_SHSTRTAB:
+            slot->ELF_file_data.addr = slot->shstrtab;
+            slot->ELF_file_data.shstrtab_offset = 0;
+            slot->stage = BATCH_CLOSE;
+            break;
+        case BATCH_CLOSE:
+            slot->fd = -1;
+            slot->stage = BATCH_DONE;
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 同步执行一个文件的所有阶段, io_uring 不可用时使用
+ *
+ * @param slot
+ */
+static void batch_slot_run_sync(BatchSlot *slot) {
+    Elf64_Ehdr *ehdr = &slot->ELF_file_data.ehdr;
+    while (slot->stage != BATCH_DONE) {
+        int result = 0;
+        switch (slot->stage) {
+            case BATCH_OPEN:
+                result = open(slot->file.file_name, O_RDONLY);
+                break;
+            case BATCH_STAT:
+                result = fstat(slot->fd, &slot->st);
+                break;
+            case BATCH_EHDR:
+                result = (int)pread(slot->fd, ehdr, sizeof(Elf64_Ehdr), 0);
+                break;
+            case BATCH_SHDR:
+                result = (int)pread(
+                    slot->fd, slot->ELF_file_data.shdr, sizeof(Elf64_Shdr) * ehdr->e_shnum, ehdr->e_shoff);
+                break;
+            case BATCH_SHSTRTAB:
+                result = (int)pread(slot->fd,
+                                    slot->shstrtab,
+                                    slot->shstrtab_size,
+                                    slot->ELF_file_data.shdr[ehdr->e_shstrndx].sh_offset);
+                break;
+            case BATCH_CLOSE:
+                result = close(slot->fd);
+                break;
+        }
+        batch_slot_complete(slot, result < 0 ? -errno : result);
+    }
+}
+
+/**
+ * @brief 为当前阶段填写一个 io_uring 请求
+ *
+ * @param ring
+ * @param slot
+ * @param slot_index 作为 user_data
+ * @return int 成功返回 0, 提交队列已满并且提交失败时返回 -errno
+ */
+static int batch_slot_queue(XBOX_uring *ring, BatchSlot *slot, uint64_t slot_index) {
+    Elf64_Ehdr *ehdr = &slot->ELF_file_data.ehdr;
+    // 每个 slot 同时最多只有一个请求在飞, 提交队列长度不小于 slot 数量时总能取到 sqe
+    // 队列满时先把已填写的 sqe 提交给内核, 腾出位置
+    struct io_uring_sqe *sqe;
+    while (!(sqe = XBOX_uring_get_sqe(ring))) {
+        int error = XBOX_uring_submit_and_wait(ring, 0);
+        if (error < 0) {
+            return error;
+        }
+    }
+    switch (slot->stage) {
+        case BATCH_OPEN:
+            XBOX_uring_prep_openat(sqe, AT_FDCWD, slot->file.file_name, O_RDONLY, slot_index);
+            break;
+        case BATCH_STAT:
+            XBOX_uring_prep_statx(sqe, slot->fd, "", AT_EMPTY_PATH, STATX_BASIC_STATS, &slot->statx, slot_index);
+            break;
+        case BATCH_EHDR:
+            XBOX_uring_prep_read(sqe, slot->fd, ehdr, sizeof(Elf64_Ehdr), 0, slot_index);
+            break;
+        case BATCH_SHDR:
+            XBOX_uring_prep_read(
+                sqe, slot->fd, slot->ELF_file_data.shdr, sizeof(Elf64_Shdr) * ehdr->e_shnum, ehdr->e_shoff, slot_index);
+            break;
+        case BATCH_SHSTRTAB:
+            XBOX_uring_prep_read(sqe,
+                                 slot->fd,
+                                 slot->shstrtab,
+                                 slot->shstrtab_size,
+                                 slot->ELF_file_data.shdr[ehdr->e_shstrndx].sh_offset,
+                                 slot_index);
+            break;
+        case BATCH_CLOSE:
+            XBOX_uring_prep_close(sqe, slot->fd, slot_index);
+            break;
+    }
+    return 0;
+}
+
+/**
+ * @brief io_uring 提交失败之后放弃 ring, 未完成的文件从头同步执行
+ *        先尽量等待已提交的请求完成; 仍有请求在飞时它们可能还会写入 slots 中的缓冲区,
+ *        这时把 slots 复制到新的数组, 旧的数组和其中的缓冲区不再使用也不释放
+ *
+ * @return BatchSlot* 之后使用的 slots
+ */
+static BatchSlot *batch_abandon_uring(
+    XBOX_uring *ring, BatchSlot *slots, int depth, int next_display, int next_admit, int in_flight) {
+    while (in_flight > 0) {
+        struct io_uring_cqe *cqe;
+        while ((cqe = XBOX_uring_peek_cqe(ring))) {
+            BatchSlot *slot = &slots[cqe->user_data];
+            int result = cqe->res;
+            XBOX_uring_cqe_seen(ring);
+            in_flight--;
+            batch_slot_complete(slot, result);
+        }
+        if (in_flight > 0 && XBOX_uring_submit_and_wait(ring, 1) < 0) {
+            break;
+        }
+    }
+    BatchSlot *current = slots;
+    if (in_flight > 0) {
+        current = malloc(sizeof(BatchSlot) * depth);
+        memcpy(current, slots, sizeof(BatchSlot) * depth);
+    }
+    XBOX_uring_exit(ring);
+    for (int i = next_display; i < next_admit; i++) {
+        BatchSlot *slot = &current[i % depth];
+        if (slot->stage == BATCH_DONE) {
+            continue;
+        }
+        if (!in_flight) {
+            if (slot->fd >= 0) {
+                close(slot->fd);
+            }
+            free(slot->ELF_file_data.shdr);
+            free(slot->shstrtab);
+        }
+        BatchFile file = slot->file;
+        batch_slot_init(slot, file, slot->options);
+        batch_slot_run_sync(slot);
+    }
+    return current;
+}
+
+/**
+ * @brief 按输入顺序输出一个已完成的文件, 并释放内存
+ *
+ * @param slot
+ * @param multiple_files
+ * @param dedup 为 NULL 时不查找内容相同的文件
+ * @return int 成功返回 0
+ */
+static int batch_slot_display(BatchSlot *slot, int multiple_files, DedupTable *dedup) {
+    int status = 0;
+    const char *original = NULL;
+    DedupFile dedup_file;
+    if (!slot->error && dedup) {
+        // 按输入顺序查找, 内容相同的文件只有第一个会被解析和格式化
+        original = dedup_find(dedup, slot->file.file_name, &slot->st, &dedup_file);
+    }
+    if (original) {
+        dedup_print(slot->file.file_name, original);
+    } else if (slot->error > 0) {
+        if (!slot->file.from_directory || slot->error != EACCES) {
+            fprintf(stderr, "readelf Error: %s: %s\n", slot->file.file_name, strerror(slot->error));
+        }
+        status = 1;
+    } else if (slot->error < 0) {
+        if (!slot->file.from_directory) {
+            fprintf(stderr, "readelf Error: Not an ELF64 file: %s\n", slot->file.file_name);
+            status = 1;
+        }
+    } else if (slot->ELF_file_data.shdr && RELF_validate_headers(&slot->ELF_file_data, UINT64_MAX)) {
+        // --batch 不读取段的内容, 只需要检查段表和段名, 不检查段的范围
+        fprintf(stderr, "readelf Error: %s: %s\n", slot->file.file_name, slot->ELF_file_data.error);
+        status = 1;
+    } else {
+        if (multiple_files || slot->file.from_directory) {
+            printf("\nFile: %s\n", slot->file.file_name);
+        }
+        if (slot->options->display_header) {
+            display_elf_header(&slot->ELF_file_data);
+        }
+        if (slot->options->display_section_table) {
+            display_elf_section_table(&slot->ELF_file_data, slot->options);
+        }
+        if (dedup) {
+            dedup_add(dedup, &dedup_file);
+        }
+    }
+    free(slot->ELF_file_data.shdr);
+    free(slot->shstrtab);
+    free(slot->file.file_name);
+    return status;
+}
+
+/**
+ * @brief readelf --batch 批量读取 ELF 头和段表
+ *        FILES 中的目录会被递归展开, 文件在进入队列时才从 FileWalker 中取出, 同时只保存 depth 个文件名
+ *
+ * @param source
+ * @param options
+ * @return int 全部成功返回 0
+ */
+int display_elf_batch(FileSource *source, ReadelfOptions *options) {
+    FileWalker walker;
+    file_walker_init(&walker, source);
+    int multiple_files = file_source_multiple(source);
+    DedupTable dedup;
+    memset(&dedup, 0, sizeof(DedupTable));
+    DedupTable *dedup_table = options->no_dedup ? NULL : &dedup;
+
+    int depth = options->batch_queue_depth > 0 ? options->batch_queue_depth : BATCH_DEFAULT_QUEUE_DEPTH;
+    XBOX_uring ring;
+    int use_uring = XBOX_uring_init(&ring, depth) == 0;
+    // 能创建 ring 的内核不一定支持这些操作, 否则每个文件都会失败
+    static const int batch_opcodes[] = {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE};
+    if (use_uring && !XBOX_uring_supports(&ring, batch_opcodes, sizeof(batch_opcodes) / sizeof(int))) {
+        XBOX_uring_exit(&ring);
+        use_uring = 0;
+    }
+    if (use_uring && (int)ring.entries < depth) {
+        depth = ring.entries;
+    }
+    BatchSlot *slots = malloc(sizeof(BatchSlot) * depth);
+    int status = 0;
+
+    // 文件 i 使用 slots[i % depth], 只有当 i < next_display + depth 时才开始处理
+    // 保证按输入顺序输出的同时, 在飞的请求数不超过 depth
+    int next_admit = 0, next_display = 0, in_flight = 0;
+    int walker_done = 0;
+    while (next_display < next_admit || !walker_done) {
+        int error = 0;
+        while (!walker_done && next_admit < next_display + depth) {
+            BatchFile file;
+            const char *file_name = file_walker_next(&walker, &file.from_directory);
+            if (!file_name) {
+                walker_done = 1;
+                break;
+            }
+            file.file_name = strdup(file_name);
+            BatchSlot *slot = &slots[next_admit % depth];
+            batch_slot_init(slot, file, options);
+            next_admit++;
+            if (!use_uring) {
+                batch_slot_run_sync(slot);
+            } else if (!error) {
+                // 提交失败的文件留在 OPEN 阶段, 之后和其他未完成的文件一起同步执行
+                error = batch_slot_queue(&ring, slot, (next_admit - 1) % depth);
+                in_flight += !error;
+            }
+        }
+        if (use_uring && in_flight && !error) {
+            error = XBOX_uring_submit_and_wait(&ring, 1);
+            struct io_uring_cqe *cqe;
+            while (error >= 0 && (cqe = XBOX_uring_peek_cqe(&ring))) {
+                uint64_t slot_index = cqe->user_data;
+                BatchSlot *slot = &slots[slot_index];
+                int result = cqe->res;
+                XBOX_uring_cqe_seen(&ring);
+                in_flight--;
+                batch_slot_complete(slot, result);
+                if (slot->stage != BATCH_DONE) {
+                    error = batch_slot_queue(&ring, slot, slot_index);
+                    in_flight += error >= 0;
+                }
+            }
+        }
+        if (use_uring && error < 0) {
+            // 不退出整个程序, 已经输出的内容和剩下的文件都不受影响
+            slots = batch_abandon_uring(&ring, slots, depth, next_display, next_admit, in_flight);
+            use_uring = 0;
+            in_flight = 0;
+        }
+        while (next_display < next_admit && slots[next_display % depth].stage == BATCH_DONE) {
+            status |= batch_slot_display(&slots[next_display % depth], multiple_files, dedup_table);
+            next_display++;
+        }
+    }
+
+    if (use_uring) {
+        XBOX_uring_exit(&ring);
+    }
+    free(slots);
+    dedup_free(&dedup);
+    file_walker_free(&walker);
+    return status;
+}
+
+/**
+ * @brief 打开 ELF 文件并做完整的内存映射, 检查 --diff 和 --bloat 需要遍历的段表和符号表
+ *
+ * @param file_name
+ * @param ELF_file_data 使用 RELF_close 释放
+ * @param report_error 失败时是否输出错误信息
+ * @return int 成功返回 0
+ */
+static int map_elf_file(const char *file_name, ELF *ELF_file_data, int report_error) {
+    // 可能在多个线程中同时调用, 错误信息保存在各自的 ELF_file_data 中
+    if (RELF_open(ELF_file_data, file_name, RELF_CHECK_SYMBOLS | RELF_CHECK_VERSIONS)) {
+        if (report_error) {
+            fprintf(stderr, "readelf Error: %s: %s\n", file_name, ELF_file_data->error);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+#define FNV1A_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV1A_PRIME 0x100000001b3ULL
+
+static uint64_t fnv1a_hash(uint64_t hash, const char *str) {
+    for (const char *p = str; *p; p++) {
+        hash = (hash ^ (unsigned char)*p) * FNV1A_PRIME;
+    }
+    return hash;
+}
+
+// --diff OLD NEW: 以 (符号名, 版本) 为键对两个符号表做 hash join
+// OLD 的符号建哈希表, NEW 的符号逐个探测, 整体是线性时间
+
+typedef struct {
+    uint64_t hash;  // 0 表示空槽
+    const char *name;
+    const char *version;
+    int version_kind;
+    Elf64_Sym *sym;
+    int matched;
+    uint64_t order;  // 在符号表中的下标, 用于按原顺序输出
+} DiffSymbol;
+
+typedef struct {
+    DiffSymbol *symbols;
+    uint64_t capacity;  // 2 的幂
+} DiffHashTable;
+
+static uint64_t diff_symbol_hash(const char *name, const char *version) {
+    uint64_t hash = fnv1a_hash(FNV1A_OFFSET_BASIS, name);
+    hash = fnv1a_hash(hash, "@");
+    hash = fnv1a_hash(hash, version);
+    return hash ? hash : 1;
+}
+
+/**
+ * @brief 获取用于比较的符号表, 优先使用 .dynsym (导出的符号), 没有时使用 .symtab
+ *
+ * @param ELF_file_data
+ * @return int 符号表的段索引, 没有符号表返回 -1
+ */
+static int diff_find_symbol_table(ELF *ELF_file_data) {
+    int symtab_index = -1;
+    for (int i = 0; i < ELF_file_data->ehdr.e_shnum; i++) {
+        if (ELF_file_data->shdr[i].sh_type == SHT_DYNSYM) {
+            return i;
+        }
+        if (ELF_file_data->shdr[i].sh_type == SHT_SYMTAB) {
+            symtab_index = i;
+        }
+    }
+    return symtab_index;
+}
+
+/**
+ * @brief 是否参与比较: 已定义的全局/弱符号, 不包括段和文件符号
+ */
+static int diff_symbol_is_exported(Elf64_Sym *sym) {
+    int bind = ELF64_ST_BIND(sym->st_info);
+    int type = ELF64_ST_TYPE(sym->st_info);
+    return sym->st_shndx != SHN_UNDEF && (bind == STB_GLOBAL || bind == STB_WEAK || bind == STB_GNU_UNIQUE) &&
+           type != STT_SECTION && type != STT_FILE;
+}
+
+/**
+ * @brief 遍历符号表中参与比较的符号
+ *
+ * @param ELF_file_data
+ * @param version_table
+ * @param callback 每个符号调用一次
+ * @param data 传给 callback 的参数
+ * @return uint64_t 参与比较的符号数量
+ */
+static uint64_t diff_walk_symbols(ELF *ELF_file_data,
+                                  RELF_versions *version_table,
+                                  void (*callback)(DiffSymbol *symbol, void *data),
+                                  void *data) {
+    int index = diff_find_symbol_table(ELF_file_data);
+    if (index < 0) {
+        return 0;
+    }
+    Elf64_Shdr *shdr = &ELF_file_data->shdr[index];
+    Elf64_Sym *symtab = (Elf64_Sym *)((char *)ELF_file_data->addr + shdr->sh_offset);
+    uint64_t symtab_number = shdr->sh_size / sizeof(Elf64_Sym);
+    int is_dynsym = shdr->sh_type == SHT_DYNSYM && version_table->versym;
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < symtab_number; i++) {
+        if (!diff_symbol_is_exported(&symtab[i])) {
+            continue;
+        }
+        const char *name = RELF_string(ELF_file_data, shdr->sh_link, symtab[i].st_name);
+        if (!name || !*name) {
+            continue;
+        }
+        DiffSymbol symbol;
+        memset(&symbol, 0, sizeof(DiffSymbol));
+        symbol.name = name;
+        symbol.version_kind = RELF_VERSION_PUBLIC;
+        symbol.version =
+            is_dynsym ? RELF_symbol_version(version_table, i, &symtab[i], name, &symbol.version_kind) : NULL;
+        if (!symbol.version) {
+            symbol.version = "";
+        }
+        symbol.hash = diff_symbol_hash(symbol.name, symbol.version);
+        symbol.sym = &symtab[i];
+        symbol.order = i;
+        callback(&symbol, data);
+        count++;
+    }
+    return count;
+}
+
+static void diff_count_symbol(DiffSymbol *symbol, void *data) {
+    (void)symbol;
+    (*(uint64_t *)data)++;
+}
+
+static DiffSymbol *diff_hash_find(DiffHashTable *table, DiffSymbol *symbol) {
+    uint64_t mask = table->capacity - 1;
+    for (uint64_t i = symbol->hash & mask;; i = (i + 1) & mask) {
+        DiffSymbol *slot = &table->symbols[i];
+        if (!slot->hash) {
+            return slot;
+        }
+        if (slot->hash == symbol->hash && !strcmp(slot->name, symbol->name) &&
+            !strcmp(slot->version, symbol->version)) {
+            return slot;
+        }
+    }
+}
+
+static void diff_hash_insert(DiffSymbol *symbol, void *data) {
+    DiffSymbol *slot = diff_hash_find((DiffHashTable *)data, symbol);
+    // 同名同版本的符号只保留第一个
+    if (!slot->hash) {
+        *slot = *symbol;
+    }
+}
+
+typedef struct {
+    DiffHashTable *table;
+    uint64_t added;
+    uint64_t resized;
+    uint64_t changed;
+    uint64_t unchanged;
+} DiffResult;
+
+static void diff_print_symbol(char mark, DiffSymbol *symbol) {
+    const char *at = "";
+    if (*symbol->version) {
+        at = symbol->version_kind == RELF_VERSION_PUBLIC ? "@@" : "@";
+    }
+    printf("%c %-8s%-6s %-9s %8lu %s%s%s",
+           mark,
+           RELF_symbol_type(ELF64_ST_TYPE(symbol->sym->st_info)),
+           RELF_symbol_bind(ELF64_ST_BIND(symbol->sym->st_info)),
+           RELF_symbol_vis(ELF64_ST_VISIBILITY(symbol->sym->st_other)),
+           symbol->sym->st_size,
+           symbol->name,
+           at,
+           symbol->version);
+}
+
+static void diff_probe_symbol(DiffSymbol *symbol, void *data) {
+    DiffResult *result = (DiffResult *)data;
+    DiffSymbol *old_symbol = diff_hash_find(result->table, symbol);
+    if (!old_symbol->hash) {
+        result->added++;
+        diff_print_symbol('+', symbol);
+        printf("\n");
+        return;
+    }
+    if (old_symbol->matched) {
+        return;
+    }
+    old_symbol->matched = 1;
+    Elf64_Sym *old_sym = old_symbol->sym;
+    Elf64_Sym *new_sym = symbol->sym;
+    int resized = old_sym->st_size != new_sym->st_size;
+    int bind_changed = ELF64_ST_BIND(old_sym->st_info) != ELF64_ST_BIND(new_sym->st_info);
+    int vis_changed = ELF64_ST_VISIBILITY(old_sym->st_other) != ELF64_ST_VISIBILITY(new_sym->st_other);
+    int type_changed = ELF64_ST_TYPE(old_sym->st_info) != ELF64_ST_TYPE(new_sym->st_info);
+    if (!resized && !bind_changed && !vis_changed && !type_changed) {
+        result->unchanged++;
+        return;
+    }
+    result->resized += resized;
+    result->changed += bind_changed || vis_changed || type_changed;
+    diff_print_symbol('~', symbol);
+    printf(" (");
+    const char *separator = "";
+    if (resized) {
+        printf("size %lu -> %lu", old_sym->st_size, new_sym->st_size);
+        separator = ", ";
+    }
+    if (type_changed) {
+        printf("%stype %s -> %s",
+               separator,
+               RELF_symbol_type(ELF64_ST_TYPE(old_sym->st_info)),
+               RELF_symbol_type(ELF64_ST_TYPE(new_sym->st_info)));
+        separator = ", ";
+    }
+    if (bind_changed) {
+        printf("%sbind %s -> %s",
+               separator,
+               RELF_symbol_bind(ELF64_ST_BIND(old_sym->st_info)),
+               RELF_symbol_bind(ELF64_ST_BIND(new_sym->st_info)));
+        separator = ", ";
+    }
+    if (vis_changed) {
+        printf("%svis %s -> %s",
+               separator,
+               RELF_symbol_vis(ELF64_ST_VISIBILITY(old_sym->st_other)),
+               RELF_symbol_vis(ELF64_ST_VISIBILITY(new_sym->st_other)));
+    }
+    printf(")\n");
+}
+
+static int diff_order_cmp(const void *a, const void *b) {
+    const DiffSymbol *s1 = *(const DiffSymbol **)a;
+    const DiffSymbol *s2 = *(const DiffSymbol **)b;
+    if (s1->order == s2->order) {
+        return 0;
+    }
+    return s1->order < s2->order ? -1 : 1;
+}
+
+/**
+ * @brief readelf --diff OLD NEW 比较两个 ELF 文件导出的符号
+ *        + 新增, - 删除, ~ 大小/类型/绑定/可见性发生变化
+ *
+ * @param old_file_name
+ * @param new_file_name
+ * @return int 没有差异返回 0, 有差异返回 1, 出错返回 2
+ */
+int display_elf_symbol_diff(const char *old_file_name, const char *new_file_name) {
+    ELF old_elf, new_elf;
+    if (map_elf_file(old_file_name, &old_elf, 1)) {
+        return 2;
+    }
+    if (map_elf_file(new_file_name, &new_elf, 1)) {
+        RELF_close(&old_elf);
+        return 2;
+    }
+    RELF_versions old_versions, new_versions;
+    RELF_build_versions(&old_elf, &old_versions);
+    RELF_build_versions(&new_elf, &new_versions);
+
+    // 负载因子不超过 0.5
+    uint64_t old_number = 0;
+    diff_walk_symbols(&old_elf, &old_versions, diff_count_symbol, &old_number);
+    DiffHashTable table;
+    table.capacity = 16;
+    while (table.capacity < old_number * 2) {
+        table.capacity <<= 1;
+    }
+    table.symbols = calloc(table.capacity, sizeof(DiffSymbol));
+    diff_walk_symbols(&old_elf, &old_versions, diff_hash_insert, &table);
+
+    printf("--- %s\n+++ %s\n", old_file_name, new_file_name);
+    DiffResult result;
+    memset(&result, 0, sizeof(DiffResult));
+    result.table = &table;
+    diff_walk_symbols(&new_elf, &new_versions, diff_probe_symbol, &result);
+
+    // OLD 中没有被匹配的符号是被删除的, 按照原符号表顺序输出
+    DiffSymbol **removed = malloc(sizeof(DiffSymbol *) * (old_number + 1));
+    uint64_t removed_number = 0;
+    for (uint64_t i = 0; i < table.capacity; i++) {
+        if (table.symbols[i].hash && !table.symbols[i].matched) {
+            removed[removed_number++] = &table.symbols[i];
+        }
+    }
+    qsort(removed, removed_number, sizeof(DiffSymbol *), diff_order_cmp);
+    for (uint64_t i = 0; i < removed_number; i++) {
+        diff_print_symbol('-', removed[i]);
+        printf("\n");
+    }
+    printf("\n%lu added, %lu removed, %lu resized, %lu changed, %lu unchanged\n",
+           result.added,
+           removed_number,
+           result.resized,
+           result.changed,
+           result.unchanged);
+
+    int status = (result.added || removed_number || result.resized || result.changed) ? 1 : 0;
+    free(removed);
+    free(table.symbols);
+    RELF_free_versions(&old_versions);
+    RELF_free_versions(&new_versions);
+    RELF_close(&old_elf);
+    RELF_close(&new_elf);
+    return status;
+}
+
+// --bloat: 把文件字节和内存字节归属到段, 段(segment)以及符号上
+// 多个线程各自统计一部分文件, 最后合并每个线程的部分和
+
+typedef struct {
+    char *name;  // NULL 表示空槽
+    uint64_t hash;
+    uint64_t file_size;
+    uint64_t memory_size;
+    uint64_t count;
+} BloatEntry;
+
+typedef struct {
+    BloatEntry *entries;
+    uint64_t entry_number;
+    uint64_t capacity;  // 2 的幂
+} BloatTable;
+
+typedef struct {
+    BloatTable sections;
+    BloatTable segments;
+    BloatTable symbols;
+    uint64_t file_number;
+    uint64_t total_file_size;
+    uint64_t total_memory_size;
+    uint64_t unattributed_size;  // 不属于任何段和头部的文件字节 (对齐填充等)
+} BloatStat;
+
+// 所有线程共享的文件队列, 在锁内从 FileWalker 取下一个文件
+typedef struct {
+    FileWalker walker;
+    pthread_mutex_t lock;
+} BloatQueue;
+
+typedef struct {
+    BloatQueue *queue;
+    BloatStat stat;
+    int error;
+} BloatWorker;
+
+static BloatEntry *bloat_table_find(BloatTable *table, const char *name, uint64_t hash) {
+    uint64_t mask = table->capacity - 1;
+    for (uint64_t i = hash & mask;; i = (i + 1) & mask) {
+        BloatEntry *entry = &table->entries[i];
+        if (!entry->name || (entry->hash == hash && !strcmp(entry->name, name))) {
+            return entry;
+        }
+    }
+}
+
+static void bloat_table_grow(BloatTable *table) {
+    BloatEntry *old_entries = table->entries;
+    uint64_t old_capacity = table->capacity;
+    table->capacity = old_capacity ? old_capacity * 2 : 256;
+    table->entries = calloc(table->capacity, sizeof(BloatEntry));
+    for (uint64_t i = 0; i < old_capacity; i++) {
+        if (old_entries[i].name) {
+            *bloat_table_find(table, old_entries[i].name, old_entries[i].hash) = old_entries[i];
+        }
+    }
+    free(old_entries);
+}
+
+/**
+ * @brief 累加一条记录, name 不存在时复制一份
+ *
+ * @param table
+ * @param name
+ * @param file_size
+ * @param memory_size
+ * @param count
+ * @return BloatEntry*
+ */
+static BloatEntry *bloat_table_add(
+    BloatTable *table, const char *name, uint64_t file_size, uint64_t memory_size, uint64_t count) {
+    // 负载因子不超过 0.5
+    if ((table->entry_number + 1) * 2 > table->capacity) {
+        bloat_table_grow(table);
+    }
+    uint64_t hash = fnv1a_hash(FNV1A_OFFSET_BASIS, name);
+    BloatEntry *entry = bloat_table_find(table, name, hash);
+    if (!entry->name) {
+        entry->name = strdup(name);
+        entry->hash = hash;
+        table->entry_number++;
+    }
+    entry->file_size += file_size;
+    entry->memory_size += memory_size;
+    entry->count += count;
+    return entry;
+}
+
+static void bloat_table_free(BloatTable *table) {
+    for (uint64_t i = 0; i < table->capacity; i++) {
+        free(table->entries[i].name);
+    }
+    free(table->entries);
+}
+
+/**
+ * @brief 把 from 中的记录合并到 to 中
+ */
+static void bloat_table_merge(BloatTable *to, BloatTable *from) {
+    for (uint64_t i = 0; i < from->capacity; i++) {
+        BloatEntry *entry = &from->entries[i];
+        if (entry->name) {
+            bloat_table_add(to, entry->name, entry->file_size, entry->memory_size, entry->count);
+        }
+    }
+}
+
+/**
+ * @brief 统计一个 ELF 文件
+ *
+ * @param stat
+ * @param ELF_file_data
+ * @param file_size
+ */
+static void bloat_collect(BloatStat *stat, ELF *ELF_file_data, uint64_t file_size) {
+    Elf64_Ehdr *ehdr = &ELF_file_data->ehdr;
+    stat->file_number++;
+    stat->total_file_size += file_size;
+
+    // ELF 头, 程序头表和段表本身
+    uint64_t header_size = sizeof(Elf64_Ehdr) + (uint64_t)ehdr->e_phnum * ehdr->e_phentsize +
+                           (uint64_t)ehdr->e_shnum * ehdr->e_shentsize;
+    bloat_table_add(&stat->sections, "<headers>", header_size, 0, 1);
+    uint64_t attributed_size = header_size;
+
+    for (int i = 1; i < ehdr->e_shnum; i++) {
+        Elf64_Shdr *shdr = &ELF_file_data->shdr[i];
+        const char *name = RELF_string(ELF_file_data, ehdr->e_shstrndx, shdr->sh_name);
+        uint64_t section_file_size = shdr->sh_type == SHT_NOBITS ? 0 : shdr->sh_size;
+        uint64_t section_memory_size = (shdr->sh_flags & SHF_ALLOC) ? shdr->sh_size : 0;
+        bloat_table_add(&stat->sections, name && *name ? name : "<noname>", section_file_size, section_memory_size, 1);
+        attributed_size += section_file_size;
+        stat->total_memory_size += section_memory_size;
+    }
+    stat->unattributed_size += file_size > attributed_size ? file_size - attributed_size : 0;
+
+    if (ehdr->e_phoff + (uint64_t)ehdr->e_phnum * sizeof(Elf64_Phdr) <= file_size) {
+        Elf64_Phdr *phdr = (Elf64_Phdr *)((char *)ELF_file_data->addr + ehdr->e_phoff);
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            char unknown_type[16];
+            const char *type = RELF_segment_type(phdr[i].p_type);
+            if (!*type) {
+                snprintf(unknown_type, sizeof(unknown_type), "0x%08x", phdr[i].p_type);
+                type = unknown_type;
+            }
+            bloat_table_add(&stat->segments, type, phdr[i].p_filesz, phdr[i].p_memsz, 1);
+        }
+    }
+
+    // 符号优先使用 .symtab, 被 strip 之后使用 .dynsym
+    int symtab_index = -1;
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        if (ELF_file_data->shdr[i].sh_type == SHT_SYMTAB ||
+            (symtab_index < 0 && ELF_file_data->shdr[i].sh_type == SHT_DYNSYM)) {
+            symtab_index = i;
+        }
+    }
+    if (symtab_index < 0) {
+        return;
+    }
+    Elf64_Shdr *symtab_shdr = &ELF_file_data->shdr[symtab_index];
+    if (symtab_shdr->sh_offset + symtab_shdr->sh_size > file_size) {
+        return;
+    }
+    Elf64_Sym *symtab = (Elf64_Sym *)((char *)ELF_file_data->addr + symtab_shdr->sh_offset);
+    uint64_t symtab_number = symtab_shdr->sh_size / sizeof(Elf64_Sym);
+    for (uint64_t i = 0; i < symtab_number; i++) {
+        Elf64_Sym *sym = &symtab[i];
+        int type = ELF64_ST_TYPE(sym->st_info);
+        if (sym->st_size == 0 || sym->st_shndx == SHN_UNDEF || sym->st_shndx >= ehdr->e_shnum ||
+            (type != STT_FUNC && type != STT_OBJECT && type != STT_TLS && type != STT_GNU_IFUNC)) {
+            continue;
+        }
+        const char *name = RELF_string(ELF_file_data, symtab_shdr->sh_link, sym->st_name);
+        if (!name || !*name) {
+            continue;
+        }
+        Elf64_Shdr *shdr = &ELF_file_data->shdr[sym->st_shndx];
+        bloat_table_add(&stat->symbols,
+                        name,
+                        shdr->sh_type == SHT_NOBITS ? 0 : sym->st_size,
+                        (shdr->sh_flags & SHF_ALLOC) ? sym->st_size : 0,
+                        1);
+    }
+}
+
+static void *bloat_worker_run(void *arg) {
+    BloatWorker *worker = (BloatWorker *)arg;
+    BloatQueue *queue = worker->queue;
+    while (1) {
+        BatchFile file;
+        pthread_mutex_lock(&queue->lock);
+        const char *file_name = file_walker_next(&queue->walker, &file.from_directory);
+        file.file_name = file_name ? strdup(file_name) : NULL;
+        pthread_mutex_unlock(&queue->lock);
+        if (!file_name) {
+            break;
+        }
+        ELF ELF_file_data;
+        // 目录中展开得到的非 ELF 文件直接跳过
+        if (map_elf_file(file.file_name, &ELF_file_data, !file.from_directory)) {
+            worker->error |= !file.from_directory;
+        } else {
+            bloat_collect(&worker->stat, &ELF_file_data, ELF_file_data.size);
+            RELF_close(&ELF_file_data);
+        }
+        free(file.file_name);
+    }
+    return NULL;
+}
+
+static int bloat_entry_cmp(const void *a, const void *b) {
+    const BloatEntry *e1 = (const BloatEntry *)a;
+    const BloatEntry *e2 = (const BloatEntry *)b;
+    if (e1->file_size != e2->file_size) {
+        return e1->file_size > e2->file_size ? -1 : 1;
+    }
+    if (e1->memory_size != e2->memory_size) {
+        return e1->memory_size > e2->memory_size ? -1 : 1;
+    }
+    return strcmp(e1->name, e2->name);
+}
+
+/**
+ * @brief 输出按文件字节排序的前 top_number 条记录
+ *
+ * @param title
+ * @param table
+ * @param top_number
+ */
+static void bloat_print_table(const char *title, BloatTable *table, int top_number) {
+    // 有界堆只保留前 top_number 项, 不需要复制和排序整张表
+    XBOX_TopHeap heap;
+    uint64_t capacity = table->entry_number < (uint64_t)top_number ? table->entry_number : (uint64_t)top_number;
+    XBOX_top_init(&heap, capacity, bloat_entry_cmp);
+    for (uint64_t i = 0; i < table->capacity; i++) {
+        if (table->entries[i].name) {
+            XBOX_top_push(&heap, &table->entries[i]);
+        }
+    }
+    uint64_t show_number = XBOX_top_finish(&heap);
+    printf("\nTop %lu %s (of %lu) by file size:\n", show_number, title, table->entry_number);
+    printf("  %12s %12s %8s  %s\n", "File Size", "Mem Size", "Count", "Name");
+    for (uint64_t i = 0; i < show_number; i++) {
+        BloatEntry *entry = (BloatEntry *)heap.items[i];
+        printf("  %12lu %12lu %8lu  %s\n", entry->file_size, entry->memory_size, entry->count, entry->name);
+    }
+    XBOX_top_free(&heap);
+}
+
+/**
+ * @brief readelf --bloat 统计所有文件的字节分布
+ *
+ * @param file_names 文件或目录, 目录会被递归展开
+ * @param n
+ * @return int
+ */
+int display_elf_bloat(FileSource *source, ReadelfOptions *options) {
+    BloatQueue queue;
+    file_walker_init(&queue.walker, source);
+    pthread_mutex_init(&queue.lock, NULL);
+
+    // 文件数量事先不知道, 文件比线程少时多余的线程取不到文件直接退出
+    int thread_number = options->jobs > 0 ? options->jobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    thread_number = MAX(thread_number, 1);
+    BloatWorker *workers = calloc(thread_number, sizeof(BloatWorker));
+    pthread_t *threads = malloc(sizeof(pthread_t) * thread_number);
+    for (int i = 0; i < thread_number; i++) {
+        workers[i].queue = &queue;
+    }
+    // 线程创建失败的部分由主线程补上, 任务是从共享的队列中领取的, 不会遗漏
+    int started_number = 0;
+    while (started_number < thread_number - 1 &&
+           !pthread_create(&threads[started_number], NULL, bloat_worker_run, &workers[started_number])) {
+        started_number++;
+    }
+    bloat_worker_run(&workers[thread_number - 1]);
+
+    BloatStat total;
+    memset(&total, 0, sizeof(BloatStat));
+    int status = 0;
+    for (int i = 0; i < thread_number; i++) {
+        if (i < started_number) {
+            pthread_join(threads[i], NULL);
+        }
+        BloatStat *stat = &workers[i].stat;
+        total.file_number += stat->file_number;
+        total.total_file_size += stat->total_file_size;
+        total.total_memory_size += stat->total_memory_size;
+        total.unattributed_size += stat->unattributed_size;
+        bloat_table_merge(&total.sections, &stat->sections);
+        bloat_table_merge(&total.segments, &stat->segments);
+        bloat_table_merge(&total.symbols, &stat->symbols);
+        bloat_table_free(&stat->sections);
+        bloat_table_free(&stat->segments);
+        bloat_table_free(&stat->symbols);
+        status |= workers[i].error;
+    }
+
+    printf("Files: %lu, file bytes: %lu, memory bytes: %lu, unattributed file bytes: %lu\n",
+           total.file_number,
+           total.total_file_size,
+           total.total_memory_size,
+           total.unattributed_size);
+    int top_number = options->top_number ? options->top_number : BLOAT_TOP_NUMBER;
+    bloat_print_table("sections", &total.sections, top_number);
+    bloat_print_table("segments", &total.segments, top_number);
+    bloat_print_table("symbols", &total.symbols, top_number);
+
+    bloat_table_free(&total.sections);
+    bloat_table_free(&total.segments);
+    bloat_table_free(&total.symbols);
+    free(threads);
+    free(workers);
+    pthread_mutex_destroy(&queue.lock);
+    file_walker_free(&queue.walker);
+    return status;
+}
+
+/**
+ * @brief 按照当前的选项输出一个已经在内存中的 ELF 文件
+ *
+ * @param ELF_file_data
+ */
+static void display_elf(ELF *ELF_file_data, ReadelfOptions *options) {
+    if (options->display_header) {
+        display_elf_header(ELF_file_data);
+    }
+    if (options->display_section_table) {
+        display_elf_section_table(ELF_file_data, options);
+    }
+    if (options->display_symbol_table || options->display_dynamic_symbol_table) {
+        display_elf_symbol_table(ELF_file_data, options);
+    }
+    if (options->display_relocations) {
+        display_elf_relocation_table(ELF_file_data, options);
+    }
+    if (options->display_reloc_stats) {
+        display_elf_reloc_stats(ELF_file_data, options);
+    }
+    if (options->display_program_header) {
+        display_elf_program_header(ELF_file_data);
+    }
+    if (options->display_version_info) {
+        display_elf_version_info(ELF_file_data);
+    }
+}
+
+// --watch DIR: 通过 inotify 等待 DIR 中写完 (IN_CLOSE_WRITE) 或移入 (IN_MOVED_TO) 的 ELF 文件
+// 每个文件第一次出现时按选项完整显示, 之后只输出与上一次结果相比段和符号的增加, 删除和大小变化
+// 上一次的结果使用 --bloat 的统计表保存在内存中, 不需要保留旧文件
+
+#define WATCH_EVENT_BUFFER_SIZE (64 * 1024)
+
+typedef struct {
+    char *path;  // NULL 表示空槽
+    uint64_t hash;
+    BloatStat stat;
+} WatchFile;
+
+typedef struct {
+    int fd;  // inotify
+    char **directories;  // 下标是 inotify 的 wd
+    int directory_capacity;
+    WatchFile *files;
+    uint64_t file_number;
+    uint64_t capacity;  // 2 的幂
+} Watch;
+
+typedef struct {
+    char mark;  // + 增加, - 删除, ~ 大小变化
+    const char *kind;
+    BloatEntry *old_entry;
+    BloatEntry *new_entry;
+} WatchChange;
+
+static WatchFile *watch_find_file(Watch *watch, const char *path, uint64_t hash) {
+    uint64_t mask = watch->capacity - 1;
+    for (uint64_t i = hash & mask;; i = (i + 1) & mask) {
+        WatchFile *file = &watch->files[i];
+        if (!file->path || (file->hash == hash && !strcmp(file->path, path))) {
+            return file;
+        }
+    }
+}
+
+static void watch_grow(Watch *watch) {
+    WatchFile *old_files = watch->files;
+    uint64_t old_capacity = watch->capacity;
+    watch->capacity = old_capacity ? old_capacity * 2 : 64;
+    watch->files = calloc(watch->capacity, sizeof(WatchFile));
+    for (uint64_t i = 0; i < old_capacity; i++) {
+        if (old_files[i].path) {
+            *watch_find_file(watch, old_files[i].path, old_files[i].hash) = old_files[i];
+        }
+    }
+    free(old_files);
+}
+
+static void watch_free_stat(BloatStat *stat) {
+    bloat_table_free(&stat->sections);
+    bloat_table_free(&stat->segments);
+    bloat_table_free(&stat->symbols);
+}
+
+/**
+ * @brief 监视目录以及其中所有的子目录, 不跟随符号链接
+ */
+static void watch_add_directory(Watch *watch, const char *path) {
+    int wd = inotify_add_watch(watch->fd, path, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR | IN_DONT_FOLLOW);
+    if (wd < 0) {
+        fprintf(stderr, "readelf Warning: can not watch %s: %s\n", path, strerror(errno));
+        return;
+    }
+    if (wd >= watch->directory_capacity) {
+        int capacity = MAX(wd + 1, watch->directory_capacity * 2);
+        watch->directories = realloc(watch->directories, sizeof(char *) * capacity);
+        memset(watch->directories + watch->directory_capacity,
+               0,
+               sizeof(char *) * (capacity - watch->directory_capacity));
+        watch->directory_capacity = capacity;
+    }
+    if (watch->directories[wd]) {
+        // 同一个目录已经在监视中
+        return;
+    }
+    watch->directories[wd] = strdup(path);
+
+    XBOX_DirList list;
+    if (XBOX_dir_read(&list, path, XBOX_DIR_IGNORE_CURRENT) < 0) {
+        return;
+    }
+    char full_path[PATH_MAX];
+    for (int i = 0; i < list.count; i++) {
+        const char *name = XBOX_DIR_LIST_NAME(&list, i);
+        if (snprintf(full_path, sizeof(full_path), "%s/%s", path, name) >= (int)sizeof(full_path)) {
+            continue;
+        }
+        unsigned char type = list.entries[i].type;
+        if (type == DT_UNKNOWN) {
+            struct stat st;
+            if (!lstat(full_path, &st) && S_ISDIR(st.st_mode)) {
+                type = DT_DIR;
+            }
+        }
+        if (type == DT_DIR) {
+            watch_add_directory(watch, full_path);
+        }
+    }
+    XBOX_dir_list_free(&list);
+}
+
+static uint64_t watch_entry_size(BloatEntry *entry) {
+    return MAX(entry->file_size, entry->memory_size);
+}
+
+/**
+ * @brief 比较同一张表的两次结果, 变化的项追加到 changes 中
+ */
+static void watch_collect_changes(
+    const char *kind, BloatTable *old_table, BloatTable *new_table, WatchChange **changes, uint64_t *change_number) {
+    // 最多 new 中的每一项都有变化, 加上 old 中的每一项都被删除
+    uint64_t max_number = *change_number + old_table->entry_number + new_table->entry_number;
+    *changes = realloc(*changes, sizeof(WatchChange) * (max_number + 1));
+    for (uint64_t i = 0; i < new_table->capacity; i++) {
+        BloatEntry *new_entry = &new_table->entries[i];
+        if (!new_entry->name) {
+            continue;
+        }
+        BloatEntry *old_entry =
+            old_table->capacity ? bloat_table_find(old_table, new_entry->name, new_entry->hash) : NULL;
+        if (!old_entry || !old_entry->name) {
+            (*changes)[(*change_number)++] = (WatchChange){'+', kind, NULL, new_entry};
+        } else if (watch_entry_size(old_entry) != watch_entry_size(new_entry)) {
+            (*changes)[(*change_number)++] = (WatchChange){'~', kind, old_entry, new_entry};
+        }
+    }
+    for (uint64_t i = 0; i < old_table->capacity; i++) {
+        BloatEntry *old_entry = &old_table->entries[i];
+        if (!old_entry->name) {
+            continue;
+        }
+        BloatEntry *new_entry =
+            new_table->capacity ? bloat_table_find(new_table, old_entry->name, old_entry->hash) : NULL;
+        if (!new_entry || !new_entry->name) {
+            (*changes)[(*change_number)++] = (WatchChange){'-', kind, old_entry, NULL};
+        }
+    }
+}
+
+static int watch_change_cmp(const void *a, const void *b) {
+    const WatchChange *c1 = (const WatchChange *)a;
+    const WatchChange *c2 = (const WatchChange *)b;
+    if (c1->kind != c2->kind) {
+        return strcmp(c1->kind, c2->kind);
+    }
+    const char *name1 = c1->new_entry ? c1->new_entry->name : c1->old_entry->name;
+    const char *name2 = c2->new_entry ? c2->new_entry->name : c2->old_entry->name;
+    return strcmp(name1, name2);
+}
+
+/**
+ * @brief 输出一个文件与上一次结果之间的变化, 只比较选项要求显示的表
+ *        -S 比较段, -s/--dyn-syms 比较有大小的符号, -l 比较程序头, 都没有指定时比较段和符号
+ */
+static void watch_print_delta(const char *path, BloatStat *old_stat, BloatStat *new_stat, ReadelfOptions *options) {
+    int compare_sections = options->display_section_table;
+    int compare_segments = options->display_program_header;
+    int compare_symbols = options->display_symbol_table || options->display_dynamic_symbol_table;
+    if (!compare_sections && !compare_segments && !compare_symbols) {
+        compare_sections = 1;
+        compare_symbols = 1;
+    }
+    WatchChange *changes = NULL;
+    uint64_t change_number = 0;
+    if (compare_sections) {
+        watch_collect_changes("section", &old_stat->sections, &new_stat->sections, &changes, &change_number);
+    }
+    if (compare_segments) {
+        watch_collect_changes("segment", &old_stat->segments, &new_stat->segments, &changes, &change_number);
+    }
+    if (compare_symbols) {
+        watch_collect_changes("symbol", &old_stat->symbols, &new_stat->symbols, &changes, &change_number);
+    }
+    qsort(changes, change_number, sizeof(WatchChange), watch_change_cmp);
+
+    uint64_t counts[3] = {0, 0, 0};  // 增加, 删除, 大小变化
+    printf("\n==> %s <==\n", path);
+    for (uint64_t i = 0; i < change_number; i++) {
+        WatchChange *change = &changes[i];
+        if (change->mark == '~') {
+            uint64_t old_size = watch_entry_size(change->old_entry);
+            uint64_t new_size = watch_entry_size(change->new_entry);
+            printf("~ %-8s %s %lu -> %lu (%c%lu)\n",
+                   change->kind,
+                   change->new_entry->name,
+                   old_size,
+                   new_size,
+                   new_size > old_size ? '+' : '-',
+                   new_size > old_size ? new_size - old_size : old_size - new_size);
+            counts[2]++;
+        } else {
+            BloatEntry *entry = change->mark == '+' ? change->new_entry : change->old_entry;
+            printf("%c %-8s %s %lu\n", change->mark, change->kind, entry->name, watch_entry_size(entry));
+            counts[change->mark == '+' ? 0 : 1]++;
+        }
+    }
+    printf("%lu added, %lu removed, %lu resized\n", counts[0], counts[1], counts[2]);
+    free(changes);
+}
+
+/**
+ * @brief 文件写完之后重新读取, 第一次出现时完整显示, 之后输出变化
+ */
+static void watch_file_changed(Watch *watch, const char *path, ReadelfOptions *options) {
+    ELF ELF_file_data;
+    // 构建目录中有很多不是 ELF 的文件, 直接忽略
+    if (RELF_open(&ELF_file_data, path, elf_display_checks(options) | RELF_CHECK_SYMBOLS)) {
+        return;
+    }
+    BloatStat stat;
+    memset(&stat, 0, sizeof(BloatStat));
+    bloat_collect(&stat, &ELF_file_data, ELF_file_data.size);
+
+    if ((watch->file_number + 1) * 2 > watch->capacity) {
+        watch_grow(watch);
+    }
+    uint64_t hash = fnv1a_hash(FNV1A_OFFSET_BASIS, path);
+    WatchFile *file = watch_find_file(watch, path, hash);
+    if (!file->path) {
+        printf("\n==> %s <==\n", path);
+        display_elf(&ELF_file_data, options);
+        printf("baseline: %lu sections, %lu segments, %lu sized symbols\n",
+               stat.sections.entry_number,
+               stat.segments.entry_number,
+               stat.symbols.entry_number);
+        file->path = strdup(path);
+        file->hash = hash;
+        watch->file_number++;
+    } else {
+        watch_print_delta(path, &file->stat, &stat, options);
+        watch_free_stat(&file->stat);
+    }
+    file->stat = stat;
+    RELF_close(&ELF_file_data);
+    output_flush();
+}
+
+/**
+ * @brief readelf --watch DIR 持续监视目录中写完的 ELF 文件, 直到进程被终止
+ *
+ * @param dir_name
+ * @param options
+ * @return int 正常情况下不会返回; 无法开始监视或者读取 inotify 事件失败时返回 1
+ */
+int display_elf_watch(const char *dir_name, ReadelfOptions *options) {
+    Watch watch;
+    memset(&watch, 0, sizeof(Watch));
+    watch.fd = inotify_init1(IN_CLOEXEC);
+    if (watch.fd < 0) {
+        fprintf(stderr, "readelf Error: inotify_init1 fail: %s\n", strerror(errno));
+        return 1;
+    }
+    watch_add_directory(&watch, dir_name);
+    if (!watch.directory_capacity) {
+        close(watch.fd);
+        return 1;
+    }
+    fprintf(stderr, "readelf: watching %s\n", dir_name);
+
+    // inotify_event 中有 int 成员, 缓冲区需要对齐
+    char *buffer = aligned_alloc(__alignof__(struct inotify_event), WATCH_EVENT_BUFFER_SIZE);
+    char full_path[PATH_MAX];
+    for (;;) {
+        ssize_t length = read(watch.fd, buffer, WATCH_EVENT_BUFFER_SIZE);
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "readelf Error: inotify read fail: %s\n", strerror(errno));
+            break;
+        }
+        for (char *p = buffer; p < buffer + length;) {
+            struct inotify_event *event = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                fprintf(stderr, "readelf Warning: inotify queue overflow, some changes are lost\n");
+                continue;
+            }
+            if (event->wd < 0 || event->wd >= watch.directory_capacity || !watch.directories[event->wd]) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                // 目录被删除
+                free(watch.directories[event->wd]);
+                watch.directories[event->wd] = NULL;
+                continue;
+            }
+            if (!event->len ||
+                snprintf(full_path, sizeof(full_path), "%s/%s", watch.directories[event->wd], event->name) >=
+                    (int)sizeof(full_path)) {
+                continue;
+            }
+            if (event->mask & IN_ISDIR) {
+                // 新建或移入的子目录
+                watch_add_directory(&watch, full_path);
+            } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                watch_file_changed(&watch, full_path, options);
+            }
+        }
+    }
+
+    free(buffer);
+    for (int i = 0; i < watch.directory_capacity; i++) {
+        free(watch.directories[i]);
+    }
+    free(watch.directories);
+    for (uint64_t i = 0; i < watch.capacity; i++) {
+        if (watch.files[i].path) {
+            free(watch.files[i].path);
+            watch_free_stat(&watch.files[i].stat);
+        }
+    }
+    free(watch.files);
+    close(watch.fd);
+    return 1;
+}
+
+// 静态库 (.a) 支持, 包括普通归档和 thin 归档
+// 普通归档的成员直接指向归档文件映射中的一段, 不做拷贝
+// thin 归档只保存成员的路径 (相对于归档所在目录), 成员在使用时单独映射
+
+#define ARCHIVE_THIN_MAGIC "!<thin>\n"
+#define ARCHIVE_MEMBERS_PER_JOB 16  // 成员数量较少时不值得 fork
+
+typedef struct {
+    char *name;
+    uint64_t header_offset;  // 成员头在归档中的偏移, 符号索引中记录的就是这个值
+    uint64_t data_offset;
+    uint64_t size;
+} ArchiveMember;
+
+typedef struct {
+    const char *file_name;
+    char *addr;
+    uint64_t size;
+    int is_thin;
+    ArchiveMember *members;
+    int member_number;
+    int member_capacity;
+    char *long_names;  // "//" 成员, GNU 格式的长文件名表
+    uint64_t long_names_size;
+    char *symbol_index;  // "/" 或 "/SYM64/" 成员, 符号索引
+    uint64_t symbol_index_size;
+    int symbol_index_64;
+} Archive;
+
+/**
+ * @brief 是否是归档文件
+ *
+ * @param addr 至少 SARMAG 字节
+ * @return int 普通归档返回 1, thin 归档返回 2, 否则返回 0
+ */
+static int is_archive(const char *addr) {
+    if (!memcmp(addr, ARMAG, SARMAG)) {
+        return 1;
+    }
+    if (!memcmp(addr, ARCHIVE_THIN_MAGIC, SARMAG)) {
+        return 2;
+    }
+    return 0;
+}
+
+static uint64_t archive_parse_number(const char *field, int length, int base) {
+    char buffer[32];
+    memcpy(buffer, field, length);
+    buffer[length] = 0;
+    return strtoull(buffer, NULL, base);
+}
+
+/**
+ * @brief 解析成员头的 ar_size, 只接受十进制数字加上空格填充
+ *        strtoull 会接受符号和前导空白, "-60" 这样的大小会让偏移回绕
+ *
+ * @return int 成功返回 0
+ */
+static int archive_parse_size(const char *field, int length, uint64_t *size) {
+    int i = 0;
+    *size = 0;
+    for (; i < length && field[i] >= '0' && field[i] <= '9'; i++) {
+        if (*size > (UINT64_MAX - 9) / 10) {
+            return -1;
+        }
+        *size = *size * 10 + (field[i] - '0');
+    }
+    if (i == 0) {
+        return -1;
+    }
+    for (; i < length; i++) {
+        if (field[i] != ' ') {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 解析成员名, 支持 "name/", "/offset" (长文件名表) 以及 BSD 的 "#1/length"
+ *
+ * @param archive
+ * @param header
+ * @param data_offset 成员数据的偏移, BSD 格式会把文件名放在数据的开头
+ * @param size 成员数据的长度, BSD 格式需要减去文件名的长度
+ * @return char* malloc 得到的成员名, 格式错误返回 NULL
+ */
+static char *archive_member_name(Archive *archive, struct ar_hdr *header, uint64_t *data_offset, uint64_t *size) {
+    if (header->ar_name[0] == '/' && header->ar_name[1] >= '0' && header->ar_name[1] <= '9') {
+        uint64_t offset = archive_parse_number(header->ar_name + 1, sizeof(header->ar_name) - 1, 10);
+        if (!archive->long_names || offset >= archive->long_names_size) {
+            return NULL;
+        }
+        const char *name = archive->long_names + offset;
+        const char *end = memchr(name, '\n', archive->long_names_size - offset);
+        uint64_t length = end ? (uint64_t)(end - name) : archive->long_names_size - offset;
+        if (length && name[length - 1] == '/') {
+            length--;
+        }
+        return strndup(name, length);
+    }
+    if (!memcmp(header->ar_name, "#1/", 3)) {
+        uint64_t length = archive_parse_number(header->ar_name + 3, sizeof(header->ar_name) - 3, 10);
+        if (length > *size) {
+            return NULL;
+        }
+        char *name = strndup(archive->addr + *data_offset, length);
+        *data_offset += length;
+        *size -= length;
+        return name;
+    }
+    int length = sizeof(header->ar_name);
+    while (length && header->ar_name[length - 1] == ' ') {
+        length--;
+    }
+    if (length && header->ar_name[length - 1] == '/') {
+        length--;
+    }
+    return strndup(header->ar_name, length);
+}
+
+static void archive_free(Archive *archive) {
+    for (int i = 0; i < archive->member_number; i++) {
+        free(archive->members[i].name);
+    }
+    free(archive->members);
+}
+
+/**
+ * @brief 解析 offset 处的一个成员头, 普通成员追加到 archive->members 中
+ *
+ * @param archive
+ * @param offset 成员头的偏移
+ * @param next_offset 输出下一个成员头的偏移
+ * @return int 成功返回 0
+ */
+static int archive_read_header(Archive *archive, uint64_t offset, uint64_t *next_offset) {
+    const char *file_name = archive->file_name;
+    struct ar_hdr *header = (struct ar_hdr *)(archive->addr + offset);
+    if (memcmp(header->ar_fmag, ARFMAG, 2)) {
+        fprintf(stderr, "readelf Error: %s: malformed archive header at offset %#lx\n", file_name, offset);
+        return 1;
+    }
+    uint64_t member_size;
+    if (archive_parse_size(header->ar_size, sizeof(header->ar_size), &member_size)) {
+        fprintf(stderr, "readelf Error: %s: bad member size at offset %#lx\n", file_name, offset);
+        return 1;
+    }
+    uint64_t data_offset = offset + sizeof(struct ar_hdr);
+    int is_special = header->ar_name[0] == '/' && (header->ar_name[1] < '0' || header->ar_name[1] > '9');
+    // thin 归档中只有符号索引和长文件名表的内容保存在归档里
+    uint64_t stored_size = archive->is_thin && !is_special ? 0 : member_size;
+    // 调用者保证 offset + sizeof(struct ar_hdr) <= archive->size, 减法不会回绕
+    if (stored_size > archive->size - data_offset) {
+        fprintf(stderr, "readelf Error: %s: truncated archive member at offset %#lx\n", file_name, offset);
+        return 1;
+    }
+    // 成员按 2 字节对齐, 下一个成员头总是在这个成员头之后, 遍历成员的循环一定会结束
+    *next_offset = data_offset + stored_size + ((data_offset + stored_size) & 1);
+    if (*next_offset <= offset) {
+        fprintf(stderr, "readelf Error: %s: malformed archive header at offset %#lx\n", file_name, offset);
+        return 1;
+    }
+
+    if (!memcmp(header->ar_name, "/               ", 16)) {
+        archive->symbol_index = archive->addr + data_offset;
+        archive->symbol_index_size = member_size;
+        archive->symbol_index_64 = 0;
+    } else if (!memcmp(header->ar_name, "/SYM64/         ", 16)) {
+        archive->symbol_index = archive->addr + data_offset;
+        archive->symbol_index_size = member_size;
+        archive->symbol_index_64 = 1;
+    } else if (!memcmp(header->ar_name, "//              ", 16)) {
+        archive->long_names = archive->addr + data_offset;
+        archive->long_names_size = member_size;
+    } else if (!is_special) {
+        uint64_t member_data_offset = data_offset;
+        char *name = archive_member_name(archive, header, &member_data_offset, &member_size);
+        if (!name) {
+            fprintf(stderr, "readelf Error: %s: bad member name at offset %#lx\n", file_name, offset);
+            return 1;
+        }
+        if (archive->member_number == archive->member_capacity) {
+            archive->member_capacity = archive->member_capacity ? archive->member_capacity * 2 : 64;
+            archive->members = realloc(archive->members, sizeof(ArchiveMember) * archive->member_capacity);
+        }
+        ArchiveMember *member = &archive->members[archive->member_number++];
+        member->name = name;
+        member->header_offset = offset;
+        member->data_offset = member_data_offset;
+        member->size = member_size;
+    }
+    return 0;
+}
+
+static void archive_init(Archive *archive, const char *file_name, char *addr, uint64_t size) {
+    memset(archive, 0, sizeof(Archive));
+    archive->file_name = file_name;
+    archive->addr = addr;
+    archive->size = size;
+    archive->is_thin = is_archive(addr) == 2;
+}
+
+/**
+ * @brief 解析归档文件的所有成员头
+ *
+ * @param archive
+ * @param file_name
+ * @param addr 归档文件的映射
+ * @param size
+ * @return int 成功返回 0
+ */
+static int archive_parse(Archive *archive, const char *file_name, char *addr, uint64_t size) {
+    archive_init(archive, file_name, addr, size);
+    uint64_t offset = SARMAG;
+    while (offset + sizeof(struct ar_hdr) <= size) {
+        if (archive_read_header(archive, offset, &offset)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 获取成员内容的视图
+ *
+ * @param archive
+ * @param member
+ * @param size 输出成员的长度
+ * @return char* 普通归档直接指向归档映射, thin 归档返回成员文件的映射, 需要 archive_member_release 释放
+ *               归档成员只按 2 字节对齐, 没有 8 字节对齐时复制到 malloc 的缓冲区, 之后按 Elf64_* 结构体访问
+ */
+static char *archive_member_view(Archive *archive, ArchiveMember *member, uint64_t *size) {
+    if (!archive->is_thin) {
+        char *addr = archive->addr + member->data_offset;
+        *size = member->size;
+        if ((uintptr_t)addr % 8 == 0) {
+            return addr;
+        }
+        char *copy = malloc(*size ? *size : 1);
+        if (copy) {
+            memcpy(copy, addr, *size);
+        }
+        return copy;
+    }
+    // thin 归档的成员路径相对于归档所在的目录
+    char path[PATH_MAX];
+    const char *slash = strrchr(archive->file_name, '/');
+    if (member->name[0] != '/' && slash) {
+        snprintf(path, sizeof(path), "%.*s/%s", (int)(slash - archive->file_name), archive->file_name, member->name);
+    } else {
+        snprintf(path, sizeof(path), "%s", member->name);
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "readelf Error: %s: cannot open thin archive member %s: %s\n",
+                archive->file_name,
+                path,
+                strerror(errno));
+        return NULL;
+    }
+    *size = lseek(fd, 0, SEEK_END);
+    void *addr = *size ? mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    return addr == MAP_FAILED ? NULL : addr;
+}
+
+static void archive_member_release(Archive *archive, ArchiveMember *member, char *addr, uint64_t size) {
+    if (archive->is_thin) {
+        munmap(addr, size);
+    } else if (addr != archive->addr + member->data_offset) {
+        free(addr);
+    }
+}
+
+/**
+ * @brief 输出一个归档成员
+ *
+ * @param archive
+ * @param member
+ * @return int
+ */
+static int display_archive_member(Archive *archive, ArchiveMember *member, ReadelfOptions *options) {
+    // 和 GNU readelf 一致, thin 归档的成员名用 [] 括起来
+    if (archive->is_thin) {
+        printf("\nFile: %s[%s]\n", archive->file_name, member->name);
+    } else {
+        printf("\nFile: %s(%s)\n", archive->file_name, member->name);
+    }
+    uint64_t size;
+    char *addr = archive_member_view(archive, member, &size);
+    if (!addr) {
+        return 1;
+    }
+    ELF ELF_file_data;
+    int status = 0;
+    char member_file_name[PATH_MAX];
+    snprintf(member_file_name, sizeof(member_file_name), "%s(%s)", archive->file_name, member->name);
+    if (RELF_open_memory(&ELF_file_data, addr, size, elf_display_checks(options))) {
+        fprintf(stderr, "readelf Error: %s: %s\n", member_file_name, ELF_file_data.error);
+        status = 1;
+    } else {
+        display_elf(&ELF_file_data, options);
+    }
+    archive_member_release(archive, member, addr, size);
+    return status;
+}
+
+/**
+ * @brief 输出归档中的所有成员
+ *        成员较多时 fork 多个子进程, 每个子进程处理连续的一段成员并把输出写到临时文件,
+ *        父进程按顺序拼接, 保证输出顺序和串行时完全一致
+ *
+ * @param file_name
+ * @param addr 归档文件的映射
+ * @param size
+ * @return int
+ */
+int display_elf_archive(const char *file_name, char *addr, uint64_t size, ReadelfOptions *options) {
+    Archive archive;
+    if (archive_parse(&archive, file_name, addr, size)) {
+        archive_free(&archive);
+        return 1;
+    }
+    int job_number = options->jobs > 0 ? options->jobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (job_number > archive.member_number / ARCHIVE_MEMBERS_PER_JOB) {
+        job_number = archive.member_number / ARCHIVE_MEMBERS_PER_JOB;
+    }
+
+    int status = 0;
+    if (job_number <= 1) {
+        for (int i = 0; i < archive.member_number; i++) {
+            status |= display_archive_member(&archive, &archive.members[i], options);
+        }
+        archive_free(&archive);
+        return status;
+    }
+
+    // 子进程会继承 stdout 的缓冲区, fork 之前先刷新
+    output_flush();
+    FILE **outputs = calloc(job_number, sizeof(FILE *));
+    pid_t *pids = calloc(job_number, sizeof(pid_t));
+    for (int k = 0; k < job_number; k++) {
+        int begin = (int)((int64_t)archive.member_number * k / job_number);
+        int end = (int)((int64_t)archive.member_number * (k + 1) / job_number);
+        outputs[k] = tmpfile();
+        pids[k] = outputs[k] ? fork() : -1;
+        if (pids[k] == 0) {
+            dup2(fileno(outputs[k]), STDOUT_FILENO);
+            output_detach();
+            int child_status = 0;
+            for (int i = begin; i < end; i++) {
+                child_status |= display_archive_member(&archive, &archive.members[i], options);
+            }
+            fflush(stdout);
+            _exit(child_status);
+        }
+    }
+    // 按顺序等待子进程, 把输出拼接到 stdout
+    // 无法创建子进程的那一段轮到它时在当前进程中完成
+    char buffer[65536];
+    for (int k = 0; k < job_number; k++) {
+        if (pids[k] < 0) {
+            int begin = (int)((int64_t)archive.member_number * k / job_number);
+            int end = (int)((int64_t)archive.member_number * (k + 1) / job_number);
+            for (int i = begin; i < end; i++) {
+                status |= display_archive_member(&archive, &archive.members[i], options);
+            }
+        } else {
+            int child_status;
+            waitpid(pids[k], &child_status, 0);
+            status |= !WIFEXITED(child_status) || WEXITSTATUS(child_status);
+            rewind(outputs[k]);
+            size_t length;
+            while ((length = fread(buffer, 1, sizeof(buffer), outputs[k])) > 0) {
+                fwrite(buffer, 1, length, stdout);
+            }
+        }
+        if (outputs[k]) {
+            fclose(outputs[k]);
+        }
+    }
+    free(outputs);
+    free(pids);
+    archive_free(&archive);
+    return status;
+}
+
+// --lookup SYMBOL: 根据归档的符号索引 ("/" 或 "/SYM64/") 直接找到定义符号的成员
+// 符号索引的格式: 大端的符号数量 N, N 个成员头偏移, N 个以 '\0' 结尾的符号名
+// 普通归档中偏移是 4 字节, /SYM64/ 中是 8 字节
+
+typedef struct {
+    const char *name;  // 指向符号索引中的字符串
+    uint64_t hash;     // 0 表示空槽
+    uint64_t header_offset;
+} ArchiveSymbol;
+
+typedef struct {
+    ArchiveSymbol *symbols;
+    uint64_t capacity;  // 2 的幂
+} ArchiveSymbolTable;
+
+static uint64_t archive_read_be(const unsigned char *p, int size) {
+    uint64_t value = 0;
+    for (int i = 0; i < size; i++) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static int uint64_cmp(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x == y ? 0 : (x < y ? -1 : 1);
+}
+
+/**
+ * @brief 把符号索引解码为哈希表, 同名符号 (例如多个成员中的弱定义) 全部保留
+ *
+ * @param archive
+ * @param table
+ * @return int 成功返回 0, 索引格式错误返回 1
+ */
+static int archive_build_symbol_table(Archive *archive, ArchiveSymbolTable *table) {
+    const unsigned char *index = (const unsigned char *)archive->symbol_index;
+    uint64_t word_size = archive->symbol_index_64 ? 8 : 4;
+    uint64_t size = archive->symbol_index_size;
+    table->symbols = NULL;
+    table->capacity = 0;
+    if (size < word_size) {
+        return 1;
+    }
+    uint64_t symbol_number = archive_read_be(index, word_size);
+    if (symbol_number > (size - word_size) / word_size) {
+        return 1;
+    }
+    const unsigned char *offsets = index + word_size;
+    const char *name = (const char *)(offsets + symbol_number * word_size);
+    const char *end = (const char *)index + size;
+
+    table->capacity = 16;
+    while (table->capacity < symbol_number * 2) {
+        table->capacity <<= 1;
+    }
+    table->symbols = calloc(table->capacity, sizeof(ArchiveSymbol));
+    uint64_t mask = table->capacity - 1;
+    for (uint64_t i = 0; i < symbol_number; i++) {
+        const char *name_end = memchr(name, 0, end - name);
+        if (!name_end) {
+            return 1;
+        }
+        uint64_t hash = fnv1a_hash(FNV1A_OFFSET_BASIS, name) | 1;
+        uint64_t slot = hash & mask;
+        while (table->symbols[slot].hash) {
+            slot = (slot + 1) & mask;
+        }
+        table->symbols[slot].name = name;
+        table->symbols[slot].hash = hash;
+        table->symbols[slot].header_offset = archive_read_be(offsets + i * word_size, word_size);
+        name = name_end + 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief readelf --lookup SYMBOL 查找归档中定义 SYMBOL 的成员
+ *        只读取符号索引和定义符号的成员头, 不遍历其他成员
+ *        同时指定了 -h/-S/-s 等选项时只输出这个成员
+ *
+ * @param file_name
+ * @param addr 归档文件的映射
+ * @param size
+ * @param symbol
+ * @return int 找到返回 0
+ */
+int display_elf_archive_lookup(
+    const char *file_name, char *addr, uint64_t size, const char *symbol, ReadelfOptions *options) {
+    Archive archive;
+    archive_init(&archive, file_name, addr, size);
+    // 符号索引和长文件名表都在第一个普通成员之前
+    uint64_t offset = SARMAG;
+    while (offset + sizeof(struct ar_hdr) <= size) {
+        struct ar_hdr *header = (struct ar_hdr *)(addr + offset);
+        if (header->ar_name[0] != '/' || (header->ar_name[1] >= '0' && header->ar_name[1] <= '9')) {
+            break;
+        }
+        if (archive_read_header(&archive, offset, &offset)) {
+            return 1;
+        }
+    }
+    if (!archive.symbol_index) {
+        fprintf(stderr, "readelf Error: %s: archive has no symbol index (run ranlib)\n", file_name);
+        return 1;
+    }
+    ArchiveSymbolTable table;
+    if (archive_build_symbol_table(&archive, &table)) {
+        fprintf(stderr, "readelf Error: %s: malformed archive symbol index\n", file_name);
+        free(table.symbols);
+        return 1;
+    }
+
+    // 收集所有定义, 按成员在归档中的顺序输出
+    uint64_t *header_offsets = NULL;
+    uint64_t match_number = 0;
+    uint64_t hash = fnv1a_hash(FNV1A_OFFSET_BASIS, symbol) | 1;
+    uint64_t mask = table.capacity - 1;
+    for (uint64_t slot = hash & mask; table.symbols[slot].hash; slot = (slot + 1) & mask) {
+        ArchiveSymbol *entry = &table.symbols[slot];
+        if (entry->hash == hash && !strcmp(entry->name, symbol)) {
+            header_offsets = realloc(header_offsets, sizeof(uint64_t) * (match_number + 1));
+            header_offsets[match_number++] = entry->header_offset;
+        }
+    }
+    qsort(header_offsets, match_number, sizeof(uint64_t), uint64_cmp);
+
+    int status = 1;
+    for (uint64_t i = 0; i < match_number; i++) {
+        int member_number = archive.member_number;
+        uint64_t next_offset;
+        if (header_offsets[i] < SARMAG || header_offsets[i] > size - sizeof(struct ar_hdr) ||
+            archive_read_header(&archive, header_offsets[i], &next_offset) ||
+            archive.member_number == member_number) {
+            fprintf(stderr,
+                    "readelf Error: %s: bad member offset %#lx for %s\n",
+                    file_name,
+                    header_offsets[i],
+                    symbol);
+            continue;
+        }
+        ArchiveMember *member = &archive.members[archive.member_number - 1];
+        printf(archive.is_thin ? "%s: %s[%s]\n" : "%s: %s(%s)\n", symbol, file_name, member->name);
+        if (options->display_header || IO_NEED_SECTION_TABLE(options)) {
+            display_archive_member(&archive, member, options);
+        }
+        status = 0;
+    }
+    free(header_offsets);
+    if (status) {
+        fprintf(stderr, "readelf Warning: %s: symbol %s not found in the archive index\n", file_name, symbol);
+    }
+    free(table.symbols);
+    archive_free(&archive);
+    return status;
+}
+
+// --core: 解析 core 文件中的 PT_NOTE 段 (线程寄存器, 信号, 辅助向量, 映射文件表)
+// core 文件可能有上百 GB, 这里不做内存映射, 只按窗口 pread PT_NOTE 段
+
+#define CORE_NOTE_WINDOW_SIZE (1024 * 1024)     // 每次读取的窗口大小
+#define CORE_NOTE_MAX_SIZE (256 * 1024 * 1024)  // 单个 note 的最大长度, 超过认为文件已损坏
+
+typedef struct {
+    int thread_number;
+    int has_siginfo;
+    Elf64_Half machine;
+} CoreContext;
+
+static const char *get_auxv_type(uint64_t type) {
+    switch (type) {
+        case AT_NULL:
+            return "AT_NULL";
+        case AT_IGNORE:
+            return "AT_IGNORE";
+        case AT_EXECFD:
+            return "AT_EXECFD";
+        case AT_PHDR:
+            return "AT_PHDR";
+        case AT_PHENT:
+            return "AT_PHENT";
+        case AT_PHNUM:
+            return "AT_PHNUM";
+        case AT_PAGESZ:
+            return "AT_PAGESZ";
+        case AT_BASE:
+            return "AT_BASE";
+        case AT_FLAGS:
+            return "AT_FLAGS";
+        case AT_ENTRY:
+            return "AT_ENTRY";
+        case AT_NOTELF:
+            return "AT_NOTELF";
+        case AT_UID:
+            return "AT_UID";
+        case AT_EUID:
+            return "AT_EUID";
+        case AT_GID:
+            return "AT_GID";
+        case AT_EGID:
+            return "AT_EGID";
+        case AT_CLKTCK:
+            return "AT_CLKTCK";
+        case AT_PLATFORM:
+            return "AT_PLATFORM";
+        case AT_HWCAP:
+            return "AT_HWCAP";
+        case AT_SECURE:
+            return "AT_SECURE";
+        case AT_BASE_PLATFORM:
+            return "AT_BASE_PLATFORM";
+        case AT_RANDOM:
+            return "AT_RANDOM";
+        case AT_HWCAP2:
+            return "AT_HWCAP2";
+        case AT_EXECFN:
+            return "AT_EXECFN";
+        case AT_SYSINFO_EHDR:
+            return "AT_SYSINFO_EHDR";
+        case AT_MINSIGSTKSZ:
+            return "AT_MINSIGSTKSZ";
+        default:
+            return NULL;
+    }
+}
+
+static void display_core_prstatus(CoreContext *context, const char *desc, uint64_t size) {
+    struct elf_prstatus prstatus;
+    if (size < sizeof(prstatus)) {
+        printf("\n  NT_PRSTATUS: truncated (%lu bytes)\n", size);
+        return;
+    }
+    memcpy(&prstatus, desc, sizeof(prstatus));
+    context->thread_number++;
+    printf("\nThread %d (LWP %d): signal %d, pending %#lx, held %#lx\n",
+           context->thread_number,
+           prstatus.pr_pid,
+           prstatus.pr_cursig,
+           prstatus.pr_sigpend,
+           prstatus.pr_sighold);
+    if (context->machine != EM_X86_64) {
+        return;
+    }
+    // elf_gregset_t 的布局和 struct user_regs_struct 相同
+    struct user_regs_struct regs;
+    memcpy(&regs, prstatus.pr_reg, sizeof(regs));
+    const struct {
+        const char *name;
+        unsigned long long value;
+    } registers[] = {
+        {"rax", regs.rax},
+        {"rbx", regs.rbx},
+        {"rcx", regs.rcx},
+        {"rdx", regs.rdx},
+        {"rsi", regs.rsi},
+        {"rdi", regs.rdi},
+        {"rbp", regs.rbp},
+        {"rsp", regs.rsp},
+        {"r8", regs.r8},
+        {"r9", regs.r9},
+        {"r10", regs.r10},
+        {"r11", regs.r11},
+        {"r12", regs.r12},
+        {"r13", regs.r13},
+        {"r14", regs.r14},
+        {"r15", regs.r15},
+        {"rip", regs.rip},
+        {"eflags", regs.eflags},
+        {"cs", regs.cs},
+        {"ss", regs.ss},
+        {"ds", regs.ds},
+        {"es", regs.es},
+        {"fs", regs.fs},
+        {"gs", regs.gs},
+        {"fs_base", regs.fs_base},
+        {"gs_base", regs.gs_base},
+        {"orig_rax", regs.orig_rax},
+    };
+    int register_number = sizeof(registers) / sizeof(registers[0]);
+    for (int i = 0; i < register_number; i++) {
+        // 每行三个寄存器
+        const char *end = (i % 3 == 2 || i == register_number - 1) ? "\n" : "";
+        printf("  %-8s 0x%016llx%s", registers[i].name, registers[i].value, end);
+    }
+}
+
+static void display_core_prpsinfo(const char *desc, uint64_t size) {
+    struct elf_prpsinfo prpsinfo;
+    if (size < sizeof(prpsinfo)) {
+        printf("\n  NT_PRPSINFO: truncated (%lu bytes)\n", size);
+        return;
+    }
+    memcpy(&prpsinfo, desc, sizeof(prpsinfo));
+    printf("\nProcess: %.*s (pid %d, ppid %d, uid %u, gid %u, state %c)\n",
+           (int)sizeof(prpsinfo.pr_fname),
+           prpsinfo.pr_fname,
+           prpsinfo.pr_pid,
+           prpsinfo.pr_ppid,
+           prpsinfo.pr_uid,
+           prpsinfo.pr_gid,
+           prpsinfo.pr_sname ? prpsinfo.pr_sname : '?');
+    printf("Command: %.*s\n", (int)sizeof(prpsinfo.pr_psargs), prpsinfo.pr_psargs);
+}
+
+static void display_core_siginfo(CoreContext *context, const char *desc, uint64_t size) {
+    siginfo_t siginfo;
+    if (size < sizeof(siginfo)) {
+        printf("\n  NT_SIGINFO: truncated (%lu bytes)\n", size);
+        return;
+    }
+    memcpy(&siginfo, desc, sizeof(siginfo));
+    context->has_siginfo = 1;
+    printf("\nSignal: %d (%s), code %d, errno %d",
+           siginfo.si_signo,
+           strsignal(siginfo.si_signo),
+           siginfo.si_code,
+           siginfo.si_errno);
+    if (siginfo.si_code <= 0) {
+        // 由 kill/tgkill 等发送, 记录了发送者
+        printf(", sent by pid %d uid %u", siginfo.si_pid, siginfo.si_uid);
+    } else if (siginfo.si_signo == SIGSEGV || siginfo.si_signo == SIGBUS || siginfo.si_signo == SIGILL ||
+               siginfo.si_signo == SIGFPE || siginfo.si_signo == SIGTRAP) {
+        // 只有内核产生的这些信号 si_addr 有意义
+        printf(", address %p", siginfo.si_addr);
+    }
+    printf("\n");
+}
+
+static void display_core_auxv(const char *desc, uint64_t size) {
+    uint64_t entry_number = size / sizeof(Elf64_auxv_t);
+    printf("\nAuxiliary vector (%lu entries):\n", entry_number);
+    for (uint64_t i = 0; i < entry_number; i++) {
+        Elf64_auxv_t auxv;
+        memcpy(&auxv, desc + i * sizeof(Elf64_auxv_t), sizeof(Elf64_auxv_t));
+        const char *name = get_auxv_type(auxv.a_type);
+        if (name) {
+            printf("  %-18s 0x%lx\n", name, auxv.a_un.a_val);
+        } else {
+            printf("  %-18lu 0x%lx\n", auxv.a_type, auxv.a_un.a_val);
+        }
+        if (auxv.a_type == AT_NULL) {
+            break;
+        }
+    }
+}
+
+static void display_core_file_table(const char *desc, uint64_t size) {
+    // count, page_size, count 个 {start, end, file_ofs}, 之后是 count 个文件名
+    uint64_t header[2];
+    if (size < sizeof(header)) {
+        printf("\n  NT_FILE: truncated (%lu bytes)\n", size);
+        return;
+    }
+    memcpy(header, desc, sizeof(header));
+    uint64_t count = header[0];
+    uint64_t page_size = header[1];
+    if (count > (size - sizeof(header)) / (3 * sizeof(uint64_t))) {
+        printf("\n  NT_FILE: malformed (count %lu)\n", count);
+        return;
+    }
+    const char *name = desc + sizeof(header) + count * 3 * sizeof(uint64_t);
+    const char *end = desc + size;
+    printf("\nMapped files (%lu entries, page size %lu):\n", count, page_size);
+    printf("  %-18s %-18s %-18s %s\n", "Start", "End", "File Offset", "Path");
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t range[3];
+        memcpy(range, desc + sizeof(header) + i * sizeof(range), sizeof(range));
+        const char *name_end = name < end ? memchr(name, 0, end - name) : NULL;
+        printf("  0x%016lx 0x%016lx 0x%016lx %s\n",
+               range[0],
+               range[1],
+               range[2] * page_size,
+               name_end ? name : "<truncated>");
+        name = name_end ? name_end + 1 : end;
+    }
+}
+
+static void display_core_note(CoreContext *context, Elf64_Nhdr *nhdr, const char *name, const char *desc) {
+    // LINUX 名下的是 x86 扩展寄存器等, 只解析 CORE 名下的 note
+    if (nhdr->n_namesz != sizeof("CORE") || memcmp(name, "CORE", sizeof("CORE"))) {
+        return;
+    }
+    switch (nhdr->n_type) {
+        case NT_PRSTATUS:
+            display_core_prstatus(context, desc, nhdr->n_descsz);
+            break;
+        case NT_PRPSINFO:
+            display_core_prpsinfo(desc, nhdr->n_descsz);
+            break;
+        case NT_SIGINFO:
+            display_core_siginfo(context, desc, nhdr->n_descsz);
+            break;
+        case NT_AUXV:
+            display_core_auxv(desc, nhdr->n_descsz);
+            break;
+        case NT_FILE:
+            display_core_file_table(desc, nhdr->n_descsz);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 按窗口读取一个 PT_NOTE 段并逐个解析 note
+ *        窗口末尾不完整的 note 移到缓冲区开头和下一个窗口拼接, 超过窗口的 note 临时扩大缓冲区
+ *
+ * @param fd
+ * @param phdr
+ * @param context
+ * @return int 成功返回 0
+ */
+static int display_core_note_segment(int fd, Elf64_Phdr *phdr, CoreContext *context) {
+    uint64_t align = phdr->p_align == 8 ? 8 : 4;
+    uint64_t capacity = CORE_NOTE_WINDOW_SIZE;
+    char *buffer = malloc(capacity);
+    uint64_t buffer_size = 0;  // 缓冲区中有效数据的长度
+    uint64_t consumed = 0;     // 已经读入缓冲区的段内偏移
+    int status = 0;
+
+    while (1) {
+        // 补满缓冲区
+        uint64_t read_size = capacity - buffer_size;
+        if (read_size > phdr->p_filesz - consumed) {
+            read_size = phdr->p_filesz - consumed;
+        }
+        if (read_size) {
+            ssize_t length = pread(fd, buffer + buffer_size, read_size, phdr->p_offset + consumed);
+            if (length <= 0) {
+                fprintf(stderr,
+                        "readelf Error: failed to read PT_NOTE at offset %#lx\n",
+                        phdr->p_offset + consumed);
+                status = 1;
+                break;
+            }
+            buffer_size += length;
+            consumed += length;
+        }
+        uint64_t offset = 0;
+        while (offset + sizeof(Elf64_Nhdr) <= buffer_size) {
+            Elf64_Nhdr nhdr;
+            memcpy(&nhdr, buffer + offset, sizeof(Elf64_Nhdr));
+            uint64_t name_offset = offset + sizeof(Elf64_Nhdr);
+            uint64_t desc_offset = name_offset + ((nhdr.n_namesz + align - 1) & ~(align - 1));
+            uint64_t next_offset = desc_offset + ((nhdr.n_descsz + align - 1) & ~(align - 1));
+            if (next_offset > buffer_size && desc_offset + nhdr.n_descsz <= buffer_size &&
+                consumed == phdr->p_filesz) {
+                // 最后一个 note 的对齐填充可能被省略
+                next_offset = buffer_size;
+            }
+            if (next_offset > buffer_size) {
+                break;
+            }
+            display_core_note(context, &nhdr, buffer + name_offset, buffer + desc_offset);
+            offset = next_offset;
+        }
+        if (consumed == phdr->p_filesz) {
+            break;
+        }
+        // 把未解析的部分移到开头, note 比窗口还大时扩大缓冲区
+        memmove(buffer, buffer + offset, buffer_size - offset);
+        buffer_size -= offset;
+        if (buffer_size == capacity) {
+            if (capacity * 2 > CORE_NOTE_MAX_SIZE) {
+                fprintf(stderr,
+                        "readelf Error: note at offset %#lx is too large\n",
+                        phdr->p_offset + consumed - buffer_size);
+                status = 1;
+                break;
+            }
+            capacity *= 2;
+            buffer = realloc(buffer, capacity);
+        }
+    }
+    free(buffer);
+    return status;
+}
+
+/**
+ * @brief readelf --core 解析 core 文件的 note
+ *        只读取 ELF 头, 程序头表和 PT_NOTE 段, 和 core 文件本身的大小无关
+ *
+ * @param file_name
+ * @return int
+ */
+int display_elf_core(const char *file_name) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "open fail: %s: %s\n", file_name, strerror(errno));
+        return 1;
+    }
+    Elf64_Ehdr ehdr;
+    if (pread(fd, &ehdr, sizeof(ehdr), 0) != sizeof(ehdr) || memcmp(ehdr.e_ident, ELFMAG, SELFMAG) ||
+        ehdr.e_ident[EI_CLASS] != ELFCLASS64) {
+        fprintf(stderr, "readelf Error: Not an ELF64 file: %s\n", file_name);
+        close(fd);
+        return 1;
+    }
+    if (ehdr.e_type != ET_CORE) {
+        fprintf(stderr, "readelf Error: %s is not a core file\n", file_name);
+        close(fd);
+        return 1;
+    }
+    // 超过 65535 个映射时 e_phnum 为 PN_XNUM, 真正的数量在 0 号段表项的 sh_info 中
+    uint64_t phdr_number = ehdr.e_phnum;
+    if (ehdr.e_phnum == PN_XNUM) {
+        Elf64_Shdr shdr;
+        if (!ehdr.e_shoff || pread(fd, &shdr, sizeof(shdr), ehdr.e_shoff) != sizeof(shdr)) {
+            fprintf(stderr, "readelf Error: %s: failed to read the program header count\n", file_name);
+            close(fd);
+            return 1;
+        }
+        phdr_number = shdr.sh_info;
+    }
+    if (ehdr.e_phentsize != sizeof(Elf64_Phdr)) {
+        fprintf(stderr, "readelf Error: %s: bad program header entry size %u\n", file_name, ehdr.e_phentsize);
+        close(fd);
+        return 1;
+    }
+    struct stat st;
+    uint64_t phdr_size = sizeof(Elf64_Phdr) * phdr_number;
+    if (fstat(fd, &st) || ehdr.e_phoff > (uint64_t)st.st_size ||
+        phdr_size > (uint64_t)st.st_size - ehdr.e_phoff) {
+        fprintf(stderr, "readelf Error: %s: the program header table is out of the file\n", file_name);
+        close(fd);
+        return 1;
+    }
+    Elf64_Phdr *phdr = malloc(phdr_size ? phdr_size : 1);
+    if (!phdr) {
+        fprintf(stderr, "readelf Error: %s: not enough memory for %lu program headers\n", file_name, phdr_number);
+        close(fd);
+        return 1;
+    }
+    if (pread(fd, phdr, phdr_size, ehdr.e_phoff) != (ssize_t)phdr_size) {
+        fprintf(stderr, "readelf Error: %s: failed to read the program headers\n", file_name);
+        free(phdr);
+        close(fd);
+        return 1;
+    }
+
+    printf("\nCore file: %s\n", file_name);
+    CoreContext context;
+    memset(&context, 0, sizeof(CoreContext));
+    context.machine = ehdr.e_machine;
+    int status = 0;
+    for (uint64_t i = 0; i < phdr_number; i++) {
+        if (phdr[i].p_type == PT_NOTE && phdr[i].p_filesz) {
+            status |= display_core_note_segment(fd, &phdr[i], &context);
+        }
+    }
+    free(phdr);
+    close(fd);
+    return status;
+}
+
+// --io 选择读取输入文件的方式, 冷 NFS, 热页缓存和很小的文件适合的方式不同, 可以用 --io-bench 比较
+// mmap: 关闭预读, 只预取 io plan 计算出的范围 (默认)
+// populate: MAP_POPULATE 在映射时读入整个文件
+// sequential/hugepage: 映射之后 madvise(MADV_SEQUENTIAL/MADV_HUGEPAGE), 文件页的大页需要内核支持只读文件的 THP
+// pread: 读入一块在文件之间复用的缓冲区
+
+static char *input_buffer;  // pread 的缓冲区, 只增长不释放
+static uint64_t input_buffer_capacity;
+
+/**
+ * @brief 按 --io 的方式读入整个文件
+ *
+ * @param fd
+ * @param size 大于 0
+ * @param strategy enum io_strategy
+ * @return void* 失败返回 MAP_FAILED, 原因在 errno 中
+ */
+static void *input_load(int fd, uint64_t size, int strategy) {
+    if (strategy == IO_PREAD) {
+        if (size > input_buffer_capacity) {
+            free(input_buffer);
+            input_buffer = malloc(size);
+            input_buffer_capacity = input_buffer ? size : 0;
+            if (!input_buffer) {
+                errno = ENOMEM;
+                return MAP_FAILED;
+            }
+        }
+        for (uint64_t offset = 0; offset < size;) {
+            ssize_t n = pread(fd, input_buffer + offset, size - offset, offset);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                errno = n ? errno : EIO;
+                return MAP_FAILED;
+            }
+            offset += n;
+        }
+        return input_buffer;
+    }
+    void *addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE | (strategy == IO_POPULATE ? MAP_POPULATE : 0), fd, 0);
+    if (addr == MAP_FAILED) {
+        return addr;
+    }
+    if (strategy == IO_MMAP) {
+        // 关闭预读, 避免 -h 这种只需要几十个字节的情况把整个文件都读进来
+        madvise(addr, size, MADV_RANDOM);
+    } else if (strategy == IO_SEQUENTIAL) {
+        madvise(addr, size, MADV_SEQUENTIAL);
+    } else if (strategy == IO_HUGEPAGE) {
+        // 内核不支持时返回 EINVAL, 等同于 mmap
+        madvise(addr, size, MADV_HUGEPAGE);
+    }
+    return addr;
+}
+
+static void input_release(void *addr, uint64_t size, int strategy) {
+    if (strategy != IO_PREAD) {
+        munmap(addr, size);
+    }
+}
+
+/**
+ * @brief --io 的参数
+ *
+ * @return int enum io_strategy, 不认识的参数返回 -1
+ */
+static int parse_io_option(const char *name) {
+    for (int i = 0; i < IO_STRATEGY_NUMBER; i++) {
+        if (!strcmp(name, io_strategy_names[i])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 按照选项显示一个文件, 可以是 ELF 文件, 静态库或者 core 文件
+ *        单个文件出错时输出错误并返回, 不影响其他文件
+ *
+ * @param file_name
+ * @param options
+ * @return int 成功返回 0
+ */
+static int display_elf_file(const char *file_name, ReadelfOptions *options) {
+    int status = 0;
+    if (options->display_core) {
+        // core 文件可能非常大, 只按窗口读取 PT_NOTE 段
+        status |= display_elf_core(file_name);
+        if (!options->display_build_id && !options->display_header && !IO_NEED_SECTION_TABLE(options)) {
+            return status;
+        }
+    }
+    if (options->display_build_id) {
+        // build-id 只需要读取少量数据, 不做完整的内存映射
+        status |= display_elf_build_id(file_name);
+        if (!options->display_header && !IO_NEED_SECTION_TABLE(options)) {
+            return status;
+        }
+    }
+    ELF ELF_file_data;
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "open fail: %s: %s\n", file_name, strerror(errno));
+        return 1;
+    }
+
+    // 按 --io 的方式读入整个文件, 保存在 ELF_file_data.addr 中, 方便后面寻址
+    // 默认的 mmap 本身不会读取文件, 真正需要读取的范围由 io plan 决定
+    int io_strategy = options->io_strategy;
+    off_t size = lseek(fd, 0, SEEK_END);
+    void *addr = size > 0 ? input_load(fd, size, io_strategy) : MAP_FAILED;
+    if (addr == MAP_FAILED) {
+        if (size > 0) {
+            fprintf(stderr,
+                    "%s fail: %s: %s\n",
+                    io_strategy == IO_PREAD ? "read" : "mmap",
+                    file_name,
+                    strerror(errno));
+        } else {
+            fprintf(stderr, "readelf Error: Not an ELF64 file: %s\n", file_name);
+        }
+        close(fd);
+        return 1;
+    }
+    memset(&ELF_file_data, 0, sizeof(ELF));
+    ELF_file_data.addr = addr;
+    ELF_file_data.size = size;
+
+    // 静态库
+    if (size >= SARMAG && is_archive(addr)) {
+        if (options->lookup_symbol) {
+            status |= display_elf_archive_lookup(file_name, addr, size, options->lookup_symbol, options);
+        } else {
+            // 静态库的成员会被顺序访问, 恢复预读
+            if (io_strategy == IO_MMAP) {
+                madvise(addr, size, MADV_SEQUENTIAL);
+            }
+            status |= display_elf_archive(file_name, addr, size, options);
+        }
+        input_release(addr, size, io_strategy);
+        close(fd);
+        return status;
+    }
+    if (options->lookup_symbol) {
+        fprintf(stderr, "readelf Warning: %s: --lookup needs an archive\n", file_name);
+        input_release(addr, size, io_strategy);
+        close(fd);
+        return 1;
+    }
+
+    // 读取 ELF 头, 保存在 ELF_file_data.ehdr 中
+    if (pread(fd, &ELF_file_data.ehdr, sizeof(Elf64_Ehdr), 0) != sizeof(Elf64_Ehdr) ||
+        memcmp(ELF_file_data.ehdr.e_ident, ELFMAG, SELFMAG) || ELF_file_data.ehdr.e_ident[EI_CLASS] != ELFCLASS64) {
+        fprintf(stderr, "readelf Error: Not an ELF64 file: %s\n", file_name);
+        input_release(addr, size, io_strategy);
+        close(fd);
+        return 1;
+    }
+
+    if (IO_NEED_SECTION_TABLE(options)) {
+        int section_number = ELF_file_data.ehdr.e_shnum;                       // 段的数量
+        unsigned long long section_table_offset = ELF_file_data.ehdr.e_shoff;  // 段表的偏移量
+
+        // 读取段表的所有信息, 保存在 shdr 中
+        ssize_t section_table_size = sizeof(Elf64_Shdr) * section_number;
+        ELF_file_data.shdr = malloc(section_table_size);
+        if (pread(fd, ELF_file_data.shdr, section_table_size, section_table_offset) != section_table_size) {
+            fprintf(stderr, "readelf Error: %s: the section header table is out of the file\n", file_name);
+            input_release(addr, size, io_strategy);
+            close(fd);
+            free(ELF_file_data.shdr);
+            return 1;
+        }
+
+        // 段表字符串表的偏移量, 段表字符串表的索引在下面的 RELF_validate_headers 中检查
+        if (section_number && ELF_file_data.ehdr.e_shstrndx < section_number) {
+            ELF_file_data.shstrtab_offset = ELF_file_data.shdr[ELF_file_data.ehdr.e_shstrndx].sh_offset;
+        }
+    }
+
+    // 显示之前检查一次所有表的边界, 损坏的文件只输出错误, 不影响其他文件
+    // 表内容的检查放在预取之后, 避免逐页读取
+    if (RELF_validate_headers(&ELF_file_data, size)) {
+        fprintf(stderr, "readelf Error: %s: %s\n", file_name, ELF_file_data.error);
+        input_release(addr, size, io_strategy);
+        close(fd);
+        free(ELF_file_data.shdr);
+        return 1;
+    }
+
+    // 根据需要显示的内容计算需要读取的字节范围, 只预取这些范围
+    IOPlan io_plan;
+    io_plan_build(&io_plan, &ELF_file_data, size, options);
+    if (io_strategy == IO_MMAP) {
+        io_plan_prefetch(&io_plan, addr);
+    }
+    if (options->display_io_stats) {
+        io_plan_report(&io_plan, file_name, size);
+    }
+    io_plan_free(&io_plan);
+
+    if (RELF_validate_tables(&ELF_file_data, elf_display_checks(options))) {
+        fprintf(stderr, "readelf Error: %s: %s\n", file_name, ELF_file_data.error);
+        input_release(addr, size, io_strategy);
+        close(fd);
+        free(ELF_file_data.shdr);
+        return 1;
+    }
+
+    display_elf(&ELF_file_data, options);
+    input_release(addr, size, io_strategy);
+    close(fd);
+    free(ELF_file_data.shdr);
+    return status;
+}
+
+static double elapsed_ms(struct timespec *start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1e3 + (end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/**
+ * @brief 用 POSIX_FADV_DONTNEED 丢弃文件的页缓存, 不需要 root, 但是被其他进程映射或者脏的页不会被丢弃
+ */
+static void io_bench_drop_cache(BatchFileList *list) {
+    for (int i = 0; i < list->file_number; i++) {
+        int fd = open(list->files[i].file_name, O_RDONLY);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+}
+
+/**
+ * @brief 按照选项显示所有文件一次, 输出已经被重定向
+ */
+static void io_bench_run(BatchFileList *list, ReadelfOptions *options) {
+    for (int i = 0; i < list->file_number; i++) {
+        display_elf_file(list->files[i].file_name, options);
+    }
+    output_flush();
+}
+
+/**
+ * @brief readelf --io-bench 用每一种 --io 的方式运行同样的显示, 输出耗时和吞吐量
+ *        热缓存: 先不计时运行一次; 冷缓存: 每一轮之前丢弃所有文件的页缓存
+ *        计时期间 stdout 和 stderr 重定向到 /dev/null, 包含格式化的开销
+ *
+ * @param source
+ * @param options
+ * @return int 成功返回 0
+ */
+int display_io_benchmark(FileSource *source, ReadelfOptions *options) {
+    BatchFileList list;
+    batch_collect_files(&list, source);
+    uint64_t total_size = 0;
+    for (int i = 0; i < list.file_number; i++) {
+        struct stat st;
+        if (!stat(list.files[i].file_name, &st)) {
+            total_size += st.st_size;
+        }
+    }
+
+    output_flush();
+    fflush(stderr);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int saved_stderr = dup(STDERR_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (saved_stdout < 0 || saved_stderr < 0 || null_fd < 0) {
+        fprintf(stderr, "readelf Error: --io-bench can not redirect the output: %s\n", strerror(errno));
+        int fds[] = {saved_stdout, saved_stderr, null_fd};
+        for (int i = 0; i < 3; i++) {
+            if (fds[i] >= 0) {
+                close(fds[i]);
+            }
+        }
+        batch_free_files(&list);
+        return 1;
+    }
+    dup2(null_fd, STDOUT_FILENO);
+    int saved_strategy = options->io_strategy;
+
+    // 第一轮不计时, 错误信息只输出这一次
+    options->io_strategy = IO_MMAP;
+    io_bench_run(&list, options);
+    fflush(stderr);
+    dup2(null_fd, STDERR_FILENO);
+
+    double hot_ms[IO_STRATEGY_NUMBER], cold_ms[IO_STRATEGY_NUMBER];
+    for (int i = 0; i < IO_STRATEGY_NUMBER; i++) {
+        struct timespec start;
+        options->io_strategy = i;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        io_bench_run(&list, options);
+        hot_ms[i] = elapsed_ms(&start);
+
+        io_bench_drop_cache(&list);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        io_bench_run(&list, options);
+        cold_ms[i] = elapsed_ms(&start);
+    }
+    options->io_strategy = saved_strategy;
+
+    output_flush();
+    fflush(stderr);
+    dup2(saved_stdout, STDOUT_FILENO);
+    dup2(saved_stderr, STDERR_FILENO);
+    close(saved_stdout);
+    close(saved_stderr);
+    close(null_fd);
+
+    double total_mb = total_size / (1024.0 * 1024.0);
+    printf("I/O benchmark: %d %s, %.1f MB\n", list.file_number, list.file_number == 1 ? "file" : "files", total_mb);
+    printf("  %-10s %12s %12s %12s %12s\n", "Strategy", "Hot ms", "Hot MB/s", "Cold ms", "Cold MB/s");
+    for (int i = 0; i < IO_STRATEGY_NUMBER; i++) {
+        printf("  %-10s %12.2f %12.1f %12.2f %12.1f\n",
+               io_strategy_names[i],
+               hot_ms[i],
+               hot_ms[i] > 0 ? total_mb * 1e3 / hot_ms[i] : 0.0,
+               cold_ms[i],
+               cold_ms[i] > 0 ? total_mb * 1e3 / cold_ms[i] : 0.0);
+    }
+    batch_free_files(&list);
+    return 0;
+}
+
+int main(int argc, const char **argv) {
+    char **file_names;
+    ReadelfOptions readelf_options;
+    memset(&readelf_options, 0, sizeof(ReadelfOptions));
+    ReadelfOptions *options = &readelf_options;
+    argparse_option argparse_options[] = {
+        XBOX_ARG_BOOLEAN(NULL, "-H", "--help", "show help information", NULL, "help"),
+        XBOX_ARG_BOOLEAN(NULL, "-v", "--version", "show version", NULL, "version"),
+        XBOX_ARG_BOOLEAN(&options->display_header, "-h", "--file-header", "Display the ELF file header", NULL, NULL),
+        XBOX_ARG_BOOLEAN(&options->display_section_table,
+                         "-S",
+                         "--section-headers",
+                         "Display the sections' header",
+                         NULL,
+                         NULL),
+        XBOX_ARG_BOOLEAN(&options->display_section_table,
+                         NULL,
+                         "--sections",
+                         "An alias for --section-headers",
+                         NULL,
+                         NULL),
+        XBOX_ARG_BOOLEAN(&options->display_symbol_table, "-s", "--syms", "Display the symbol table", NULL, NULL),
+        XBOX_ARG_BOOLEAN(&options->display_symbol_table, NULL, "--symbols", "An alias for --syms", NULL, NULL),
+        XBOX_ARG_BOOLEAN(&options->display_dynamic_symbol_table,
+                         NULL,
+                         "--dyn-syms",
+                         "Display the dynamic symbol table",
+                         NULL,
+                         NULL),
+        XBOX_ARG_BOOLEAN(&options->display_relocations,
+                         "-r",
+                         "--relocs",
+                         "Display the relocations (if present)",
+                         NULL,
+                         NULL),
+        XBOX_ARG_BOOLEAN(&options->relr_summary,
+                         NULL,
+                         "--relr-summary",
+                         "Display the relocations, with only the counts of each packed RELR section",
+                         NULL,
+                         NULL),
+        XBOX_ARG_BOOLEAN(&options->display_reloc_stats,
+                         NULL,
+                         "--reloc-stats",
+                         "Display the relocation counts by kind, type and target section, and the RELR saving",
+                         NULL,
+                         NULL),
+        XBOX_ARG_BOOLEAN(&options->display_program_header,
+                         "-l",
+                         "--program-header",
+                         "Display the program headers",
+                         NULL,
+                         NULL),
+        XBOX_ARG_BOOLEAN(&options->display_program_header,
+                         NULL,
+                         "--segments",
+                         "An alias for --program-headers",
+                         NULL,
+                         NULL),
+        XBOX_ARG_BOOLEAN(&options->display_version_info,
+                         "-V",
+                         "--version-info",
+                         "Display the version sections (if present)",
+                         NULL,
+                         NULL),
+        XBOX_ARG_BOOLEAN(&options->truncated,
+                         "-T",
+                         "--silent-truncation",
+                         "If a symbol name is truncated, do not add [...] suffix",
+                         NULL,
+                         NULL),
+        XBOX_ARG_BOOLEAN(&options->truncated,
+                         "-W",
+                         NULL,
+                         "Don't break output lines to fit into 80 columns",
+                         NULL,
+                         NULL),
+        XBOX_ARG_STR(&options->color_when,
+                     NULL,
+                     "--color",
+                     "Color section types, section flags and symbol bindings: always, never or auto",
+                     "=<WHEN>",
+                     NULL),
+        XBOX_ARG_STRS(&options->filters,
+                      NULL,
+                      "--filter",
+                      "Only show the symbols matching all the TERMs of -s/--dyn-syms: type=, bind=, vis=, ndx=, "
+                      "size=MIN-MAX, size<N, size>N, name=GLOB, name~REGEX",
+                      "=<TERM>",
+                      "filter"),
+        XBOX_ARG_STR(&options->sort_key,
+                     NULL,
+                     "--sort",
+                     "Sort the rows of -s/--dyn-syms by addr, size or name (size is largest first with --top)",
+                     "=<KEY>",
+                     NULL),
+        XBOX_ARG_INT(&options->top_number,
+                     NULL,
+                     "--top",
+                     "Only show the N largest entries of -S, -s/--dyn-syms and --bloat (default for --bloat: 20)",
+                     " <N>",
+                     "top"),
+        XBOX_ARG_BOOLEAN(&options->display_build_id,
+                         NULL,
+                         "--build-id",
+                         "Display the GNU build-id, only reads the headers and PT_NOTE",
+                         NULL,
+                         NULL),
+        XBOX_ARG_STR(&options->build_id_index_dir,
+                     NULL,
+                     "--build-id-index",
+                     "Scan DIR and write a sorted build-id index",
+                     " <DIR>",
+                     "build-id-index"),
+        XBOX_ARG_STR(&options->build_id_lookup,
+                     NULL,
+                     "--build-id-lookup",
+                     "Look up the paths of a build-id in the index",
+                     " <ID>",
+                     "build-id-lookup"),
+        XBOX_ARG_STR(&options->build_id_index_file,
+                     NULL,
+                     "--index-file",
+                     "build-id index file (default: build-id.idx)",
+                     " <FILE>",
+                     NULL),
+        XBOX_ARG_BOOLEAN(&options->display_io_stats,
+                         NULL,
+                         "--io-stats",
+                         "Report the bytes fetched versus the file size",
+                         NULL,
+                         NULL),
+        XBOX_ARG_STR(&options->io_name,
+                     NULL,
+                     "--io",
+                     "How to read FILES: mmap (default), populate, sequential, hugepage or pread",
+                     "=<HOW>",
+                     NULL),
+        XBOX_ARG_BOOLEAN(&options->io_bench,
+                         NULL,
+                         "--io-bench",
+                         "Time the selected displays of FILES and directories with each --io, hot and cold cache",
+                         NULL,
+                         NULL),
+        XBOX_ARG_BOOLEAN(&options->display_batch,
+                         NULL,
+                         "--batch",
+                         "Read -h/-S of FILES and directories with batched io_uring requests",
+                         NULL,
+                         NULL),
+        XBOX_ARG_INT(&options->batch_queue_depth,
+                     NULL,
+                     "--queue-depth",
+                     "Number of files in flight for --batch (default: 256)",
+                     " <N>",
+                     NULL),
+        XBOX_ARG_STR(&options->diff_old_file,
+                     NULL,
+                     "--diff",
+                     "Compare the exported symbols of OLD with each of FILES",
+                     " <OLD>",
+                     "diff"),
+        XBOX_ARG_BOOLEAN(&options->display_bloat,
+                         NULL,
+                         "--bloat",
+                         "Attribute the bytes of FILES and directories to sections, segments and symbols",
+                         NULL,
+                         NULL),
+        XBOX_ARG_INT(&options->jobs,
+                     NULL,
+                     "--jobs",
+                     "Number of threads or processes for --bloat and archives (default: online CPUs)",
+                     " <N>",
+                     NULL),
+        XBOX_ARG_STR(&options->lookup_symbol,
+                     NULL,
+                     "--lookup",
+                     "Find the archive member defining SYMBOL through the archive index",
+                     " <SYMBOL>",
+                     NULL),
+        XBOX_ARG_BOOLEAN(&options->display_core,
+                         NULL,
+                         "--core",
+                         "Decode the threads, signal, auxv and mapped files of a core file",
+                         NULL,
+                         NULL),
+        XBOX_ARG_STR(&options->files_from,
+                     NULL,
+                     "--files-from",
+                     "Read more FILES from FILE (- for stdin), one per line or separated by NUL; @FILE also works",
+                     " <FILE>",
+                     NULL),
+        XBOX_ARG_STR(&options->watch_dir,
+                     NULL,
+                     "--watch",
+                     "Show each ELF file written in DIR, then only the sections and symbols added, removed or resized",
+                     " <DIR>",
+                     "watch"),
+        XBOX_ARG_BOOLEAN(&options->no_dedup,
+                         NULL,
+                         "--no-dedup",
+                         "Display every file again instead of 'identical to' for files with the same content",
+                         NULL,
+                         NULL),
+        XBOX_ARG_STRS_GROUP(&file_names, NULL, NULL, NULL, NULL, "FILES"),
+        XBOX_ARG_END()};
+
+    XBOX_argparse parser;
+    XBOX_argparse_init(&parser, argparse_options, XBOX_ARGPARSE_ENABLE_ARG_STICK | XBOX_ARGPARSE_ENABLE_EQUAL);
+    XBOX_argparse_describe(&parser, "readelf", "Display information about the contents of ELF format files", "");
+    XBOX_argparse_parse(&parser, argc, argv);
+
+    if (XBOX_ismatch(&parser, "help")) {
+        XBOX_argparse_info(&parser);
+        XBOX_free_argparse(&parser);
+        return 0;
+    }
+
+    if (XBOX_ismatch(&parser, "version")) {
+        printf("%s\n", VERSION);
+        XBOX_free_argparse(&parser);
+        return 0;
+    }
+
+    if (options->color_when) {
+        options->color = parse_color_option(options->color_when);
+        if (options->color < 0) {
+            fprintf(stderr, "readelf Error: invalid argument '%s' for '--color'\n", options->color_when);
+            XBOX_print_invalid_color_option();
+            XBOX_free_argparse(&parser);
+            return 1;
+        }
+    }
+
+    if (options->sort_key) {
+        options->symbol_sort = parse_sort_option(options->sort_key);
+        if (options->symbol_sort < 0) {
+            fprintf(stderr, "readelf Error: invalid argument '%s' for '--sort', expect addr, size or name\n",
+                    options->sort_key);
+            XBOX_free_argparse(&parser);
+            return 1;
+        }
+    }
+
+    if (options->relr_summary) {
+        options->display_relocations = 1;
+    }
+
+    if (options->io_name) {
+        options->io_strategy = parse_io_option(options->io_name);
+        if (options->io_strategy < 0) {
+            fprintf(stderr,
+                    "readelf Error: invalid argument '%s' for '--io', expect mmap, populate, sequential, hugepage or "
+                    "pread\n",
+                    options->io_name);
+            XBOX_free_argparse(&parser);
+            return 1;
+        }
+    }
+
+    if (XBOX_ismatch(&parser, "top") && options->top_number <= 0) {
+        fprintf(stderr, "readelf Error: invalid argument '%d' for '--top'\n", options->top_number);
+        XBOX_free_argparse(&parser);
+        return 1;
+    }
+
+    SymbolFilter symbol_filter;
+    if (XBOX_ismatch(&parser, "filter")) {
+        if (symbol_filter_compile(&symbol_filter, options->filters, XBOX_ismatch(&parser, "filter"))) {
+            XBOX_free_argparse(&parser);
+            return 1;
+        }
+        options->symbol_filter = &symbol_filter;
+    }
+
+    output_start();
+    int status = 0;
+    const char *index_file_name =
+        options->build_id_index_file ? options->build_id_index_file : BUILD_ID_INDEX_DEFAULT_FILE;
+    if (XBOX_ismatch(&parser, "build-id-index")) {
+        status |= create_build_id_index(options->build_id_index_dir, index_file_name);
+    }
+    if (XBOX_ismatch(&parser, "build-id-lookup")) {
+        status |= lookup_build_id_index(index_file_name, options->build_id_lookup);
+    }
+
+    // FILES 中的 @listfile 和 --files-from 的列表在处理时才逐个读取
+    FileSource source;
+    file_source_init(&source, file_names, XBOX_ismatch(&parser, "FILES"), options->files_from);
+    int n = source.file_number || source.files_from;
+    if (!n && !XBOX_ismatch(&parser, "build-id-index") && !XBOX_ismatch(&parser, "build-id-lookup") &&
+        !XBOX_ismatch(&parser, "diff") && !XBOX_ismatch(&parser, "watch")) {
+        printf("readelf Warning: Nothing to do.\n");
+        XBOX_argparse_info(&parser);
+    }
+    if (XBOX_ismatch(&parser, "diff")) {
+        if (!n) {
+            fprintf(stderr, "readelf Error: --diff needs a NEW file to compare with\n");
+            status = 2;
+        }
+        const char *new_file_name;
+        while ((new_file_name = file_source_next(&source))) {
+            int diff_status = display_elf_symbol_diff(options->diff_old_file, new_file_name);
+            status = MAX(status, diff_status);
+        }
+        if (source.status) {
+            status = 2;
+        }
+        n = 0;
+    }
+    if (n && options->display_bloat) {
+        status |= display_elf_bloat(&source, options);
+        status |= source.status;
+        n = 0;
+    }
+    if (n && options->io_bench) {
+        status |= display_io_benchmark(&source, options);
+        status |= source.status;
+        n = 0;
+    }
+    if (n && options->display_batch) {
+        status |= display_elf_batch(&source, options);
+        status |= source.status;
+        n = 0;
+    }
+    DedupTable dedup;
+    memset(&dedup, 0, sizeof(DedupTable));
+    const char *file_name;
+    int multiple_files = file_source_multiple(&source);
+    while (n && (file_name = file_source_next(&source))) {
+        DedupFile dedup_file;
+        const char *original = options->no_dedup ? NULL : dedup_find(&dedup, file_name, NULL, &dedup_file);
+        if (original) {
+            dedup_print(file_name, original);
+            continue;
+        }
+        if (multiple_files) {
+            printf("\nFile: %s\n", file_name);
+        }
+        int file_status = display_elf_file(file_name, options);
+        if (!file_status && !options->no_dedup) {
+            dedup_add(&dedup, &dedup_file);
+        }
+        status |= file_status;
+    }
+    dedup_free(&dedup);
+    status |= source.status;
+    if (XBOX_ismatch(&parser, "watch")) {
+        status |= display_elf_watch(options->watch_dir, options);
+    }
+    status |= output_finish();
+    if (options->symbol_filter) {
+        symbol_filter_free(options->symbol_filter);
+    }
+    XBOX_free_argparse(&parser);
+    return status;
 }
\ No newline at end of file
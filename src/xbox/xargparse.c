@@ -23,36 +23,154 @@ void XBOX_free_argparse(XBOX_argparse *parser) {
     // fprintf(stderr, "argument parse error, free options\n");
     for (int i = 0; i < parser->args_number; i++) {
         argparse_option *option = &(parser->options[i]);
-        if (option->value) {
-            free(option->value);
-        }
+        // 字符串都指向 argv, 只释放多个匹配的数组
         if (__XBOX_ARGS_NEED_FREE(option->type) && option->match) {
-            if (option->type == __ARGPARSE_OPT_STR || option->type == __ARGPARSE_OPT_STR_GROUP) {
-                free(*(char **)option->p);
-            } else if (option->type == __ARGPARSE_OPT_INTS || option->type == __ARGPARSE_OPT_INTS_GROUP) {
-                free(*(int **)option->p);
-            } else {
-                for (int j = 0; j < option->match; j++) {
-                    free((*(char ***)option->p)[j]);
-                }
-                free(*(char ***)option->p);
-            }
+            free(*(void **)option->p);
+            *(void **)option->p = NULL;
+            option->match = 0;
         }
     }
+    free(parser->index);
+    parser->index = NULL;
 
     // fprintf(stderr, "finished free options\n");
 }
 
 static int check_valid_character(const char *str) {
-    int length = (int)strlen(str);
-    for (int i = 0; i < length; i++) {
-        if (!(islower(str[i]) || str[i] == '_' || str[i] == '-')) {
+    for (; *str; str++) {
+        if (!(islower(*str) || *str == '_' || *str == '-')) {
             return 1;
         }
     }
     return 0;
 }
 
+static int is_group_option(argparse_option *option) {
+    return option->type == __ARGPARSE_OPT_INT_GROUP || option->type == __ARGPARSE_OPT_STR_GROUP ||
+           option->type == __ARGPARSE_OPT_INTS_GROUP || option->type == __ARGPARSE_OPT_STRS_GROUP;
+}
+
+/**
+ * @brief 选项在索引中对应的名字, 分组参数没有长短参数
+ *
+ * @param option
+ * @param kind
+ * @return const char* 没有这个名字时返回 NULL
+ */
+static const char *option_index_key(argparse_option *option, int kind) {
+    if (kind == __ARGPARSE_INDEX_NAME) {
+        return option->name;
+    }
+    if (is_group_option(option)) {
+        return NULL;
+    }
+    return kind == __ARGPARSE_INDEX_LONG ? option->long_name : option->short_name;
+}
+
+/**
+ * @brief FNV-1a, seed 用于寻找没有冲突的哈希函数
+ */
+static unsigned option_hash(unsigned seed, int kind, const char *key, size_t length) {
+    unsigned hash = (2166136261u ^ seed) * 16777619u;
+    hash = (hash ^ (unsigned)kind) * 16777619u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+    }
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    return hash;
+}
+
+/**
+ * @brief 使用 seed 把所有名字放入哈希表
+ *
+ * @param parser
+ * @param seed
+ * @param duplicate 名字重复时输出对应的两个选项
+ * @return int 0 表示没有冲突; 1 表示有冲突, 需要换一个 seed; 2 表示名字重复
+ */
+static int option_index_fill(XBOX_argparse *parser, unsigned seed, argparse_index_entry *duplicate) {
+    memset(parser->index, 0, sizeof(argparse_index_entry) * (parser->index_mask + 1));
+    for (int i = 0; i < parser->args_number; i++) {
+        argparse_option *option = &(parser->options[i]);
+        for (int kind = __ARGPARSE_INDEX_LONG; kind <= __ARGPARSE_INDEX_NAME; kind++) {
+            const char *key = option_index_key(option, kind);
+            if (!key) {
+                continue;
+            }
+            unsigned slot = option_hash(seed, kind, key, strlen(key)) & parser->index_mask;
+            argparse_index_entry *entry = &parser->index[slot];
+            if (entry->kind) {
+                if (entry->kind == kind && !strcmp(option_index_key(entry->option, kind), key)) {
+                    duplicate->option = option;
+                    duplicate->kind = kind;
+                    return 2;
+                }
+                return 1;
+            }
+            entry->option = option;
+            entry->kind = kind;
+        }
+    }
+    parser->index_seed = seed;
+    return 0;
+}
+
+/**
+ * @brief 构建选项名的完美哈希表, 同时检查名字是否重复
+ *
+ * @param parser
+ */
+static void build_option_index(XBOX_argparse *parser) {
+    unsigned size = 8;
+    while (size < (unsigned)parser->args_number * 3 * 2) {
+        size <<= 1;
+    }
+    free(parser->index);
+    for (;;) {
+        parser->index = (argparse_index_entry *)malloc(sizeof(argparse_index_entry) * size);
+        parser->index_mask = size - 1;
+        // 槽的数量至少是名字的两倍, 一般几次尝试之内就能找到没有冲突的 seed
+        for (unsigned seed = 0; seed < 256; seed++) {
+            argparse_index_entry duplicate;
+            int ret = option_index_fill(parser, seed, &duplicate);
+            if (ret == 0) {
+                return;
+            }
+            if (ret == 2) {
+                static const char *kind_names[] = {"", "long_name", "short_name", "name"};
+                fprintf(stderr,
+                        "%s: options have the same %s [%s]\n",
+                        __XBOX_ARGS_BUILD_ERROR,
+                        kind_names[duplicate.kind],
+                        option_index_key(duplicate.option, duplicate.kind));
+                XBOX_free_argparse(parser);
+                exit(XBOX_FORMAT_ERROR);
+            }
+        }
+        free(parser->index);
+        size <<= 1;
+    }
+}
+
+/**
+ * @brief 在索引中查找名字
+ *
+ * @param parser
+ * @param kind
+ * @param key argv 中的切片, 例如 --name=value 中的 --name
+ * @return argparse_option* 没有找到返回 NULL
+ */
+static argparse_option *find_option(XBOX_argparse *parser, int kind, XBOX_str key) {
+    unsigned slot = option_hash(parser->index_seed, kind, key.data, key.length) & parser->index_mask;
+    argparse_index_entry *entry = &parser->index[slot];
+    if (entry->kind != kind || !XBOX_str_equal(key, option_index_key(entry->option, kind))) {
+        return NULL;
+    }
+    return entry->option;
+}
+
 /**
  * @brief 检验参数合法性
  *
@@ -82,54 +200,19 @@ static void check_valid_options(XBOX_argparse *parser) {
             exit(XBOX_FORMAT_ERROR);
         }
         // 检查长参数合法性
-        if (option->long_name) {
-            char *l_name = XBOX_splice(option->long_name, 2, -1);
-            char *p = l_name;
+        if (option->long_name && strlen(option->long_name) > 2) {
+            const char *p = option->long_name + 2;
 
             // long_name 合法性: a-z-_
             if (check_valid_character(p)) {
                 fprintf(stderr, "%s: only [a-z_-] are legal characters instead of [%s]\n", __XBOX_ARGS_BUILD_ERROR, p);
-                free(p);
                 exit(XBOX_FORMAT_ERROR);
             }
-            free(p);
         }
     }
 
-    for (int i = 0; i < parser->args_number; i++) {
-        argparse_option *option1 = &(parser->options[i]);
-        for (int j = i + 1; j < parser->args_number; j++) {
-            argparse_option *option2 = &(parser->options[j]);
-            // 没有两个参数同名
-            if (option1->name && option2->name && !strcmp(option1->name, option2->name)) {
-                fprintf(stderr, "%s: options have the same name [%s]\n", __XBOX_ARGS_BUILD_ERROR, option1->name);
-                XBOX_free_argparse(parser);
-                exit(XBOX_FORMAT_ERROR);
-            }
-            // 没有两个长参数同名
-            if (option1->long_name && option2->long_name) {
-                if (!strcmp(option1->long_name, option2->long_name)) {
-                    fprintf(stderr,
-                            "%s: options have the same long_name [%s]\n",
-                            __XBOX_ARGS_BUILD_ERROR,
-                            option1->long_name);
-                    XBOX_free_argparse(parser);
-                    exit(XBOX_FORMAT_ERROR);
-                }
-            }
-            // 没有两个短参数同名
-            if (option1->short_name && option2->short_name) {
-                if (!strcmp(option1->short_name, option2->short_name)) {
-                    fprintf(stderr,
-                            "%s: options have the same short_name [%s]\n",
-                            __XBOX_ARGS_BUILD_ERROR,
-                            option1->short_name);
-                    XBOX_free_argparse(parser);
-                    exit(XBOX_FORMAT_ERROR);
-                }
-            }
-        }
-    }
+    // 重名的检查在构建索引时完成, 重复的名字一定落在同一个槽
+    build_option_index(parser);
 
     // if (parser->flag & XBOX_ARGPARSE_ENABLE_ARG_STICK &&
     //     ((parser->flag & XBOX_ARGPARSE_ENABLE_EQUAL) || (parser->flag &
@@ -356,6 +439,8 @@ left_space   mid_space           right_space
 
     if ((parser->flag & XBOX_ARGPARSE_SORT)) {
         qsort(parser->options, (size_t)parser->args_number, sizeof(argparse_option), option_cmp);
+        // 排序之后选项的位置改变, 重新构建索引
+        build_option_index(parser);
     }
 
     for (int i = 0; i < parser->args_number; i++) {
@@ -422,43 +507,22 @@ left_space   mid_space           right_space
  * @brief 判断长参数是否匹配
  *
  * @param parser
- * @param str
+ * @param name
  * @return argparse_option 返回匹配的option, 否则返回 NULL
  */
-argparse_option *check_argparse_loptions(XBOX_argparse *parser, const char *str) {
-    for (int i = 0; i < parser->args_number; i++) {
-        argparse_option *option = &(parser->options[i]);
-        if (option->type == __ARGPARSE_OPT_INT_GROUP || option->type == __ARGPARSE_OPT_STR_GROUP ||
-            option->type == __ARGPARSE_OPT_INTS_GROUP || option->type == __ARGPARSE_OPT_STRS_GROUP) {
-            continue;
-        }
-        if (option->long_name && !strcmp(option->long_name, str)) {
-            return option;
-        }
-    }
-    return NULL;
+argparse_option *check_argparse_loptions(XBOX_argparse *parser, XBOX_str name) {
+    return find_option(parser, __ARGPARSE_INDEX_LONG, name);
 }
 
 /**
- * @brief 判断短参数是否匹配, 并修改 option->match
+ * @brief 判断短参数是否匹配
  *
  * @param parser
- * @param str
+ * @param name
  * @return argparse_option* 返回匹配的option, 否则返回 NULL
  */
-argparse_option *check_argparse_soptions(XBOX_argparse *parser, const char *str) {
-    for (int i = 0; i < parser->args_number; i++) {
-        argparse_option *option = &(parser->options[i]);
-        if (option->type == __ARGPARSE_OPT_INT_GROUP || option->type == __ARGPARSE_OPT_STR_GROUP ||
-            option->type == __ARGPARSE_OPT_INTS_GROUP || option->type == __ARGPARSE_OPT_STRS_GROUP) {
-            continue;
-        }
-        if (option->short_name && !strcmp(option->short_name, str)) {
-            // printf("matched %s\n", option->short_name);
-            return option;
-        }
-    }
-    return NULL;
+argparse_option *check_argparse_soptions(XBOX_argparse *parser, XBOX_str name) {
+    return find_option(parser, __ARGPARSE_INDEX_SHORT, name);
 }
 
 /**
@@ -474,24 +538,16 @@ int check_argparse_groups(XBOX_argparse *parser, const char *str, int *match_pos
 
         if (option->type == __ARGPARSE_OPT_INT_GROUP || option->type == __ARGPARSE_OPT_STR_GROUP) {
             if (!option->match) {
-                if (option->value) {
-                    free(option->value);
-                }
-                option->value = (char *)malloc(sizeof(char) * ((int)strlen(str) + 1));
+                option->value = (char *)str;
                 option->pos = *match_pos++;
-                strcpy(option->value, str);
                 // printf("matched [%s] for group [%s]\n", option->value, option->name);
                 value_pass(parser, option);
                 return 0;
             }
         }
         if (option->type == __ARGPARSE_OPT_INTS_GROUP || option->type == __ARGPARSE_OPT_STRS_GROUP) {
-            if (option->value) {
-                free(option->value);
-            }
-            option->value = (char *)malloc(sizeof(char) * ((int)strlen(str) + 1));
+            option->value = (char *)str;
             option->pos = *match_pos++;
-            strcpy(option->value, str);
             // printf("[%d]: matched [%s] for group [%s]\n", __LINE__, option->value,
             // option->name);
             value_pass(parser, option);
@@ -517,11 +573,7 @@ static void value_pass(XBOX_argparse *parser, argparse_option *option) {
 
     // 单个匹配
     if ((option->type == __ARGPARSE_OPT_STR) || option->type == __ARGPARSE_OPT_STR_GROUP) {
-        if (option->match >= 1) {
-            free(*(char **)option->p);
-        }
-        *(char **)option->p = (char *)malloc((int)strlen(option->value) + 1);
-        strcpy(*(char **)option->p, option->value);
+        *(char **)option->p = option->value;
         option->match = 1;
         return;
     } else if ((option->type == __ARGPARSE_OPT_INT) || option->type == __ARGPARSE_OPT_INT_GROUP) {
@@ -547,17 +599,15 @@ static void value_pass(XBOX_argparse *parser, argparse_option *option) {
     }
     // 多个匹配的情况
     // -D __GNU__ -D __KERNEL
+    // 数组的容量按 2 的幂增长, match_number 为 2 的幂时扩容
     int match_number = ++option->match;
+    int need_grow = !(match_number & (match_number - 1));
     if (option->type == __ARGPARSE_OPT_STRS || option->type == __ARGPARSE_OPT_STRS_GROUP) {
-        char **new_p;
-        if (match_number == 1) {
-            new_p = (char **)realloc(NULL, sizeof(char *) * match_number);
-        } else {
-            new_p = (char **)realloc(*(char ***)option->p, sizeof(char *) * match_number);
+        if (need_grow) {
+            *(char ***)option->p =
+                (char **)realloc(match_number == 1 ? NULL : *(char ***)option->p, sizeof(char *) * match_number * 2);
         }
-        *(char ***)option->p = new_p;
-        char *value_str = XBOX_splice(option->value, 0, -1);
-        (*(char ***)option->p)[match_number - 1] = value_str;
+        (*(char ***)option->p)[match_number - 1] = option->value;
 
     } else if (option->type == __ARGPARSE_OPT_INTS || option->type == __ARGPARSE_OPT_INTS_GROUP) {
         int value = 0;
@@ -576,13 +626,10 @@ static void value_pass(XBOX_argparse *parser, argparse_option *option) {
             value = value * 10 + (*temp) - '0';
             temp++;
         }
-        int *new_p;
-        if (match_number == 1) {
-            new_p = (int *)realloc(NULL, sizeof(int) * match_number);
-        } else {
-            new_p = (int *)realloc(*(int **)option->p, sizeof(int) * match_number);
+        if (need_grow) {
+            *(int **)option->p =
+                (int *)realloc(match_number == 1 ? NULL : *(int **)option->p, sizeof(int) * match_number * 2);
         }
-        (*(int **)option->p) = new_p;
         (*(int **)option->p)[match_number - 1] = value * signal;
     } else {
         fprintf(stderr, "%s: unknown option type for [%s]\n", __XBOX_ARGS_PARSE_ERROR, option->name);
@@ -602,36 +649,31 @@ void XBOX_argparse_parse(XBOX_argparse *parser, int argc, const char **argv) {
     // 不使用 i 作为匹配位置的索引, 因为需要考虑粘连参数的先后顺序 -abc
     int match_pos = 1;
     for (int i = 1; i < argc; i++) {
-        int argv_length = (int)strlen(argv[i]);
-        if (argv_length >= 2 && argv[i][0] == '-') {
+        XBOX_str arg = XBOX_str_from(argv[i]);
+        if (arg.length >= 2 && argv[i][0] == '-') {
             // --long_name
             argparse_option *option;
             if (argv[i][1] == '-') {
-                option = check_argparse_loptions(parser, argv[i]);
+                option = check_argparse_loptions(parser, arg);
             } else {
-                option = check_argparse_soptions(parser, argv[i]);
+                option = check_argparse_soptions(parser, arg);
             }
 
             if (option == NULL) {
                 if (parser->flag & XBOX_ARGPARSE_ENABLE_EQUAL) {
-                    int pos = XBOX_findChar(argv[i], '=', 0);
-                    if (pos != -1) {
-                        char *name = XBOX_splice(argv[i], 0, pos - 1);
-                        if ((int)strlen(name) >= 2 && name[0] == '-') {
-                            if (name[1] == '-') {
+                    long equal = XBOX_str_find(arg, '=', 0);
+                    if (equal != -1) {
+                        // --name=value 直接在 argv 中查找名字, value 指向 '=' 之后
+                        XBOX_str name = XBOX_str_sub(arg, 0, (size_t)equal);
+                        if (name.length >= 2) {
+                            if (argv[i][1] == '-') {
                                 option = check_argparse_loptions(parser, name);
                             } else {
                                 option = check_argparse_soptions(parser, name);
                             }
                         }
-
-                        free(name);
                         if (option) {
-                            if (option->value) {
-                                free(option->value);
-                            }
-                            char *value = XBOX_splice(argv[i], pos + 1, -1);
-                            option->value = value;
+                            option->value = (char *)argv[i] + equal + 1;
                             option->pos = match_pos++;
                             value_pass(parser, option);
                             continue;
@@ -639,17 +681,11 @@ void XBOX_argparse_parse(XBOX_argparse *parser, int argc, const char **argv) {
                     }
                 }
                 if (parser->flag & XBOX_ARGPARSE_ENABLE_STICK) {
-                    char *short_name = XBOX_splice(argv[i], 0, 1);
-                    option = check_argparse_soptions(parser, short_name);
-                    free(short_name);
+                    option = check_argparse_soptions(parser, XBOX_str_sub(arg, 0, 2));
                     if (option) {
                         // 只判断非 boolean 类型的粘连情况
                         if (option->type != __ARGPARSE_OPT_BOOLEAN) {
-                            if (option->value) {
-                                free(option->value);
-                            }
-                            char *value = XBOX_splice(argv[i], 2, -1);
-                            option->value = value;
+                            option->value = (char *)argv[i] + 2;
                             option->pos = match_pos++;
                             value_pass(parser, option);
                             continue;
@@ -668,11 +704,11 @@ void XBOX_argparse_parse(XBOX_argparse *parser, int argc, const char **argv) {
                     }
                 }
                 if ((parser->flag & XBOX_ARGPARSE_ENABLE_ARG_STICK) && argv[i][1] != '-') {
-                    char s[3] = {'-', '0', '\0'};
-                    int n = (int)strlen(argv[i]);
-                    for (int j = 1; j < n; j++) {
+                    char s[2] = {'-', '0'};
+                    XBOX_str short_name = {s, 2};
+                    for (size_t j = 1; j < arg.length; j++) {
                         s[1] = argv[i][j];
-                        option = check_argparse_soptions(parser, s);
+                        option = check_argparse_soptions(parser, short_name);
                         if (option == NULL) {
                             fprintf(stderr, "%s: no match options for [%s]\n", __XBOX_ARGS_PARSE_ERROR, argv[i]);
                             XBOX_free_argparse(parser);
@@ -727,11 +763,7 @@ void XBOX_argparse_parse(XBOX_argparse *parser, int argc, const char **argv) {
                 //             argv[i + 1],
                 //             argv[i]);
                 // }
-                if (option->value) {
-                    free(option->value);
-                }
-                option->value = (char *)malloc(sizeof(char) * ((int)strlen(argv[i + 1]) + 1));
-                strcpy(option->value, argv[i + 1]);
+                option->value = (char *)argv[i + 1];
                 option->pos = match_pos++;
                 value_pass(parser, option);
                 // printf("matched [%s]:[%s]\n", option->long_name, argv[i + 1]);
@@ -769,11 +801,9 @@ void XBOX_argparse_parse(XBOX_argparse *parser, int argc, const char **argv) {
  * @return int 如果未匹配返回0; 如果匹配,返回值为匹配的个数
  */
 int XBOX_ismatch(XBOX_argparse *parser, char *name) {
-    for (int i = 0; i < parser->args_number; i++) {
-        argparse_option *option = &(parser->options[i]);
-        if (option->name && !strcmp(option->name, name)) {
-            return option->match;
-        }
+    argparse_option *option = find_option(parser, __ARGPARSE_INDEX_NAME, XBOX_str_from(name));
+    if (option) {
+        return option->match;
     }
     fprintf(stderr, "%s: no matched name in options for [%s]\n", __XBOX_ARGS_PARSE_WARNING, name);
     return 0;
@@ -795,11 +825,9 @@ int XBOX_ismatch(XBOX_argparse *parser, char *name) {
  * @return int
  */
 int XBOX_match_pos(XBOX_argparse *parser, char *name) {
-    for (int i = 0; i < parser->args_number; i++) {
-        argparse_option *option = &(parser->options[i]);
-        if (option->name && !strcmp(option->name, name)) {
-            return option->pos;
-        }
+    argparse_option *option = find_option(parser, __ARGPARSE_INDEX_NAME, XBOX_str_from(name));
+    if (option) {
+        return option->pos;
     }
     fprintf(stderr, "%s: no matched name in options for [%s]\n", __XBOX_ARGS_PARSE_WARNING, name);
     return 0;
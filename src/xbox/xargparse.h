@@ -56,8 +56,10 @@ left_space   mid_space           right_space
 #define __XBOX_ARGS_PARSE_ERROR "[Args Parse Error]"
 #define __XBOX_ARGS_PARSE_WARNING "[Args Parse Warning]"
 
-#define __XBOX_ARGS_NEED_FREE(type) \
-    (!((type == __ARGPARSE_OPT_BOOLEAN) || (type == __ARGPARSE_OPT_INT) || (type == __ARGPARSE_OPT_INT_GROUP)))
+// 字符串直接指向 argv, 只有多个匹配的数组需要释放
+#define __XBOX_ARGS_NEED_FREE(type)                                                                           \
+    ((type == __ARGPARSE_OPT_INTS) || (type == __ARGPARSE_OPT_STRS) || (type == __ARGPARSE_OPT_INTS_GROUP) || \
+     (type == __ARGPARSE_OPT_STRS_GROUP))
 
 enum argparse_option_type {
     __ARGPARSE_OPT_END,
@@ -92,11 +94,19 @@ typedef struct {
     char *append_info;  // 补充信息
     char *name;         // 记录用的名字
     // 下面三个字段由内部维护
-    char *value;  // 匹配的值
+    char *value;  // 匹配的值, 指向 argv 中的字符串, 不复制
     int pos;      // 匹配的位置
     int match;    // 匹配的次数
 } argparse_option;
 
+// 选项名的索引: 长参数, 短参数和记录用的名字分别查找
+enum argparse_index_kind { __ARGPARSE_INDEX_LONG = 1, __ARGPARSE_INDEX_SHORT, __ARGPARSE_INDEX_NAME };
+
+typedef struct {
+    argparse_option *option;
+    int kind;  // argparse_index_kind, 0 表示空槽
+} argparse_index_entry;
+
 /**
  * argpparse
  */
@@ -107,7 +117,10 @@ typedef struct {
     const char *epilog;       // bind description at the end
     int args_number;
     int flag;
-
+    // 初始化时构建的完美哈希表, 每个名字只对应一个槽, 查找只需要一次哈希和一次比较
+    argparse_index_entry *index;
+    unsigned index_mask;
+    unsigned index_seed;
 } XBOX_argparse;
 
 // built-in option macros
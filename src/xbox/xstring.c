@@ -10,25 +10,28 @@
  * @param length 数组长度
  */
 void XBOX_splitStr(char *str, char c, char ***result, int *length) {
-    int n = (int)strlen(str);
+    XBOX_str source = XBOX_str_from(str);
     int number = 1;
-    int i;
-    for (i = 0; i < n; i++) {
+    for (size_t i = 0; i < source.length; i++) {
         number += c == str[i];
     }
-    *length = number;
     *result = (char **)malloc(sizeof(char *) * number);
 
-    char split_str[] = {c};
-    char *token;
-    token = strtok(str, split_str);
-    i = 0;
-    while (token != NULL) {
-        (*result)[i] = (char *)malloc(sizeof(char) * ((int)strlen(token) + 1));
-        strcpy((*result)[i], token);
-        token = strtok(NULL, split_str);
+    // 与 strtok 相同跳过空的部分, 但不修改 str
+    XBOX_str_split split;
+    XBOX_str token;
+    XBOX_str_split_init(&split, source, c);
+    int i = 0;
+    while (XBOX_str_split_next(&split, &token)) {
+        if (token.length == 0) {
+            continue;
+        }
+        (*result)[i] = (char *)malloc(token.length + 1);
+        memcpy((*result)[i], token.data, token.length);
+        (*result)[i][token.length] = '\0';
         i++;
     }
+    *length = i;
 }
 
 /**
@@ -123,4 +126,71 @@ char *XBOX_splice(const char *str, int start, int end) {
     strncpy(s, str + start, end - start + 1);
     s[end - start + 1] = '\0';
     return s;
-}
\ No newline at end of file
+}
+
+XBOX_str XBOX_str_from(const char *str) {
+    XBOX_str result = {str, strlen(str)};
+    return result;
+}
+
+XBOX_str XBOX_str_sub(XBOX_str str, size_t start, size_t end) {
+    if (end > str.length) {
+        end = str.length;
+    }
+    if (start > end) {
+        start = end;
+    }
+    XBOX_str result = {str.data + start, end - start};
+    return result;
+}
+
+int XBOX_str_equal(XBOX_str str, const char *cstr) {
+    return !strncmp(str.data, cstr, str.length) && cstr[str.length] == '\0';
+}
+
+long XBOX_str_find(XBOX_str str, char c, size_t start) {
+    if (start >= str.length) {
+        return -1;
+    }
+    const char *p = (const char *)memchr(str.data + start, c, str.length - start);
+    return p ? p - str.data : -1;
+}
+
+XBOX_str XBOX_str_trim(XBOX_str str) {
+    while (str.length && *str.data == ' ') {
+        str.data++;
+        str.length--;
+    }
+    if (str.length && *str.data == '\"') {
+        str.data++;
+        str.length--;
+    }
+    while (str.length && str.data[str.length - 1] == ' ') {
+        str.length--;
+    }
+    if (str.length && str.data[str.length - 1] == '\"') {
+        str.length--;
+    }
+    return str;
+}
+
+void XBOX_str_split_init(XBOX_str_split *split, XBOX_str str, char delimiter) {
+    split->rest = str;
+    split->delimiter = delimiter;
+    split->done = 0;
+}
+
+int XBOX_str_split_next(XBOX_str_split *split, XBOX_str *token) {
+    if (split->done) {
+        return 0;
+    }
+    long pos = XBOX_str_find(split->rest, split->delimiter, 0);
+    if (pos < 0) {
+        *token = split->rest;
+        split->done = 1;
+        return 1;
+    }
+    *token = XBOX_str_sub(split->rest, 0, (size_t)pos);
+    split->rest = XBOX_str_sub(split->rest, (size_t)pos + 1, split->rest.length);
+    return 1;
+}
@@ -2,9 +2,23 @@
 #ifndef XBOX_XSTRING_H
 #define XBOX_XSTRING_H
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
+// 不持有内存的字符串切片, 指向源字符串中的一段, 不以 '\0' 结尾
+typedef struct {
+    const char *data;
+    size_t length;
+} XBOX_str;
+
+// 按字符分割的迭代器, 每次返回源字符串中的一段
+typedef struct {
+    XBOX_str rest;
+    char delimiter;
+    int done;
+} XBOX_str_split;
+
 /**
  * @brief 分割字符串, 返回数组.
  *
@@ -53,4 +67,67 @@ void XBOX_trim(char **str_p);
  */
 char *XBOX_splice(const char *str, int start, int end);
 
+/**
+ * @brief 以 '\0' 结尾的字符串的切片
+ *
+ * @param str
+ * @return XBOX_str
+ */
+XBOX_str XBOX_str_from(const char *str);
+
+/**
+ * @brief 子切片 [start, end), 超出范围的部分会被截断
+ *
+ * @param str
+ * @param start
+ * @param end
+ * @return XBOX_str
+ */
+XBOX_str XBOX_str_sub(XBOX_str str, size_t start, size_t end);
+
+/**
+ * @brief 切片是否与字符串相等
+ *
+ * @param str
+ * @param cstr
+ * @return int 相等返回 1
+ */
+int XBOX_str_equal(XBOX_str str, const char *cstr);
+
+/**
+ * @brief 从 start 开始查找字符, 可以用上一次的结果 + 1 继续查找下一个
+ *
+ * @param str
+ * @param c
+ * @param start
+ * @return long 未找到返回 -1
+ */
+long XBOX_str_find(XBOX_str str, char c, size_t start);
+
+/**
+ * @brief 去除开头结尾的空格和双引号 "", 与 XBOX_trim 相同但不复制
+ *
+ * @param str
+ * @return XBOX_str
+ */
+XBOX_str XBOX_str_trim(XBOX_str str);
+
+/**
+ * @brief 初始化分割迭代器, 与 strtok 不同, 不修改源字符串, 连续的分隔符之间返回空切片
+ *
+ * @param split
+ * @param str
+ * @param delimiter
+ */
+void XBOX_str_split_init(XBOX_str_split *split, XBOX_str str, char delimiter);
+
+/**
+ * @brief 获取下一段
+ *
+ * @param split
+ * @param token
+ * @return int 获取到返回 1, 结束返回 0
+ */
+int XBOX_str_split_next(XBOX_str_split *split, XBOX_str *token);
+
 #endif // XBOX_XSTRING_H
@@ -70,14 +70,77 @@ char *XBOX_colorful_print(XBOX_term_word *word) {
     return vt_seq;
 }
 
-int check_default_dc_config(char *name, char default_dc_config[18][3]) {
-    for (int i = 0; i < 18; i++) {
-        // 简化处理
-        // TODO
-        if (name[0] == '*') {
-            return -1;
+/**
+ * @brief FNV-1a
+ */
+static unsigned dc_suffix_hash(const char *suffix) {
+    unsigned hash = 2166136261u;
+    for (; *suffix; suffix++) {
+        hash = (hash ^ (unsigned char)*suffix) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief 把 *.ext 形式的键放入哈希表, 与之前的线性查找一致, 重复的后缀以第一个为准
+ *
+ * @param database
+ */
+static void build_dc_suffix_table(XBOX_dircolor_database *database) {
+    unsigned size = 16;
+    while (size < (unsigned)database->item_number * 2) {
+        size <<= 1;
+    }
+    database->suffix_table = (dc_kv **)calloc(size, sizeof(dc_kv *));
+    database->suffix_mask = size - 1;
+    for (int i = 0; i < database->item_number; i++) {
+        dc_kv *kv = &database->dc_kvs[i];
+        if (kv->key[0] != '*' || kv->key[1] != '.') {
+            continue;
+        }
+        unsigned slot = dc_suffix_hash(kv->key + 1) & database->suffix_mask;
+        while (database->suffix_table[slot] && strcmp(database->suffix_table[slot]->key, kv->key)) {
+            slot = (slot + 1) & database->suffix_mask;
+        }
+        if (!database->suffix_table[slot]) {
+            database->suffix_table[slot] = kv;
         }
-        if (!strcmp(name, default_dc_config[i])) {
+    }
+}
+
+/**
+ * @brief 按文件名后缀查找 LS_COLORS 中的颜色
+ *
+ * @param database
+ * @param file_name
+ * @return const char* 没有匹配的后缀时返回 NULL
+ */
+const char *XBOX_dc_suffix_color(XBOX_dircolor_database *database, const char *file_name) {
+    const char *suffix = strrchr(file_name, '.');
+    if (!suffix) {
+        return NULL;
+    }
+    unsigned slot = dc_suffix_hash(suffix) & database->suffix_mask;
+    while (database->suffix_table[slot]) {
+        if (!strcmp(database->suffix_table[slot]->key + 1, suffix)) {
+            return database->suffix_table[slot]->value;
+        }
+        slot = (slot + 1) & database->suffix_mask;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 默认配置项在 XBOX_dircolor_database 中的位置
+ *
+ * @param key
+ * @return int 不是默认配置项返回 -1
+ */
+static int check_default_dc_config(XBOX_str key) {
+    static const char *default_dc_config[18] = {
+        "rs", "di", "ln", "mh", "pi", "so", "do", "bd", "cd", "or", "mi", "su", "sg", "ca", "tw", "ow", "st", "ex"};
+    for (int i = 0; i < 18; i++) {
+        if (XBOX_str_equal(key, default_dc_config[i])) {
             return i;
         }
     }
@@ -91,62 +154,43 @@ int check_default_dc_config(char *name, char default_dc_config[18][3]) {
  * @param database
  */
 void parse_ls_colors(char *lscolors_str, XBOX_dircolor_database *database) {
-    int length = strlen(lscolors_str);
-    int item_number = 0;
-    for (int i = 0; i < length; i++) {
-        if (lscolors_str[i] == ':') {
-            item_number++;
-        }
+    XBOX_str source = XBOX_str_from(lscolors_str);
+    int item_number = 1;
+    for (size_t i = 0; i < source.length; i++) {
+        item_number += lscolors_str[i] == ':';
     }
-    database->dc_kvs = (dc_kv *)malloc(sizeof(dc_kv) * item_number);
-    database->item_number = item_number;
-    memset(database->dc_kvs, 0, sizeof(dc_kv));
-    int p = 0;
+    database->dc_kvs = (dc_kv *)calloc(item_number, sizeof(dc_kv));
+
+    // 键值对都是源字符串中的切片, 只复制到定长的 dc_kv 中
     int index = 0;
-    char default_dc_config[18][3] = {
-        "rs", "di", "ln", "mh", "pi", "so", "do", "bd", "cd", "or", "mi", "su", "sg", "ca", "tw", "ow", "st", "ex"};
-    for (int i = 0; i < length; i++) {
-        if (lscolors_str[i] == '=') {
-            strncpy(database->dc_kvs[index].key, lscolors_str + p, i - p);
-            database->dc_kvs[index].key[i - p] = 0;
-            p = i + 1;
-        } else if (lscolors_str[i] == ':') {
-            if (p == i) {
-                // 空操作
-                p++;
-                continue;
-            }
-            strncpy(database->dc_kvs[index].value, lscolors_str + p, i - p);
-            database->dc_kvs[index].value[i - p] = 0;
-            p = i + 1;
-            int offset = check_default_dc_config(database->dc_kvs[index].key, default_dc_config);
-            if (offset != -1) {
-                // 结构体内存地址赋值
-                // a little tricky
-                char *bias = (char *)&(database->dc_kvs[index].value);
-                *(u_int64_t *)((char *)database + offset * sizeof(char *)) = (u_int64_t)bias;
-            }
-            index++;
+    XBOX_str_split split;
+    XBOX_str item;
+    XBOX_str_split_init(&split, source, ':');
+    while (XBOX_str_split_next(&split, &item)) {
+        long equal = XBOX_str_find(item, '=', 0);
+        if (equal < 0) {
+            // 空操作
+            continue;
         }
-    }
-    // LS_COLORS 没有以 : 结尾, 补齐最后的 value
-    if (p != length) {
-        strncpy(database->dc_kvs[index].value, lscolors_str + p, length - p);
-        database->dc_kvs[index].value[length - p] = 0;
-        // printf("%s\n", database->dc_kvs[index].value);
-        int offset = check_default_dc_config(database->dc_kvs[index].key, default_dc_config);
+        XBOX_str key = XBOX_str_sub(item, 0, (size_t)equal);
+        XBOX_str value = XBOX_str_sub(item, (size_t)equal + 1, item.length);
+        if (key.length >= MAX_DC_KV_LENGTH || value.length >= MAX_DC_KV_LENGTH) {
+            // 放不下的键值对忽略
+            continue;
+        }
+        dc_kv *kv = &database->dc_kvs[index++];
+        memcpy(kv->key, key.data, key.length);
+        memcpy(kv->value, value.data, value.length);
+        int offset = check_default_dc_config(key);
         if (offset != -1) {
             // 结构体内存地址赋值
             // a little tricky
-            char *bias = (char *)&(database->dc_kvs[index].value);
+            char *bias = (char *)&(kv->value);
             *(u_int64_t *)((char *)database + offset * sizeof(char *)) = (u_int64_t)bias;
         }
     }
-    // for (int i=0;i<index;i++) {
-    //     printf("key = %s, value = %s\n", database->dc_kvs[i].key,
-    //     database->dc_kvs[i].value);
-    // }
-    // printf("rs = %s, di = %s\n", database->rs, database->di);
+    database->item_number = index;
+    build_dc_suffix_table(database);
 }
 
 /**
@@ -157,6 +201,7 @@ void parse_ls_colors(char *lscolors_str, XBOX_dircolor_database *database) {
 void XBOX_init_dc_database(XBOX_dircolor_database **database) {
     char *lscolors_str = getenv("LS_COLORS");
     *database = (XBOX_dircolor_database *)malloc(sizeof(XBOX_dircolor_database));
+    memset(*database, 0, sizeof(XBOX_dircolor_database));
     if (!lscolors_str) {
         lscolors_str = (char *)DEFUALT_LS_COLORS;
     }
@@ -169,6 +214,7 @@ void XBOX_init_dc_database(XBOX_dircolor_database **database) {
  * @param database 
  */
 void XBOX_free_dc_database(XBOX_dircolor_database *database) {
+    free(database->suffix_table);
     free(database->dc_kvs);
     free(database);
 }
@@ -244,22 +290,8 @@ const char *XBOX_filename_print(const char *file_name, const char *full_path, XB
                     color_code = database->sg;
                 } else {
                     // 文件名后缀匹配
-                    int dot_pos = XBOX_findChar(file_name, '.', -1);
-                    int suffix_match = 0;
-                    if (dot_pos != -1) {
-                        for (int i = 0; i < database->item_number; i++) {
-                            if (strlen(database->dc_kvs[i].key) >= 2 && database->dc_kvs[i].key[0] == '*' &&
-                                database->dc_kvs[i].key[1] == '.') {
-                                // printf("[%s] [%s]\n", database->dc_kvs[i].key + 1, file_name + dot_pos);
-                                if (!strcmp(database->dc_kvs[i].key + 1, file_name + dot_pos)) {
-                                    color_code = database->dc_kvs[i].value;
-                                    suffix_match = 1;
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                    if (!suffix_match) {
+                    color_code = (char *)XBOX_dc_suffix_color(database, file_name);
+                    if (!color_code) {
                         color_code = (char *)"0";
                     }
                 }
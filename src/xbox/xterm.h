@@ -48,6 +48,8 @@ typedef struct {
     char *orp, *mi, *su, *sg, *ca, *tw, *ow, *st, *ex;
     dc_kv *dc_kvs;  // 所有 LS_COLORS 的键值对
     int item_number;
+    dc_kv **suffix_table;  // *.ext 后缀的哈希表(开放寻址), 键为 ".ext"
+    unsigned suffix_mask;
 } XBOX_dircolor_database;
 
 
@@ -87,4 +89,13 @@ void XBOX_free_dc_database(XBOX_dircolor_database *database);
  */
 const char *XBOX_filename_print(const char *file_name, const char *full_path, XBOX_dircolor_database *database);
 
+/**
+ * @brief 按文件名后缀查找 LS_COLORS 中的颜色
+ *
+ * @param database
+ * @param file_name
+ * @return const char* 没有匹配的后缀时返回 NULL
+ */
+const char *XBOX_dc_suffix_color(XBOX_dircolor_database *database, const char *file_name);
+
 #endif // XBOX_XTERM_H
\ No newline at end of file
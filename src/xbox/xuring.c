@@ -0,0 +1,244 @@
+/*
+ *Copyright (c) 2023 All rights reserved
+ *@description: io_uring 的简单封装
+ *@author: Zhixing Lu
+ *@date: 2023-11-12
+ *@email: luzhixing12345@163.com
+ *@Github: luzhixing12345
+ */
+
+#include "xuring.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// 用户态和内核共享 head/tail, 需要 acquire/release 语义
+#define XBOX_LOAD_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define XBOX_STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+/**
+ * @brief 初始化 io_uring
+ *
+ * @param ring
+ * @param entries 提交队列的长度
+ * @return int 成功返回 0, 内核不支持或被禁止时返回 -errno, 调用者应退回同步 IO
+ */
+int XBOX_uring_init(XBOX_uring *ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(ring, 0, sizeof(XBOX_uring));
+    memset(&params, 0, sizeof(params));
+    ring->ring_fd = -1;
+
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        return -errno;
+    }
+    ring->ring_fd = fd;
+    ring->entries = params.sq_entries;
+
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        // 5.4 之后 sq 和 cq 共用一次 mmap
+        if (ring->cq_size > ring->sq_size) {
+            ring->sq_size = ring->cq_size;
+        }
+        ring->cq_size = ring->sq_size;
+    }
+    ring->sq_ptr =
+        mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        int error = errno;
+        close(fd);
+        return -error;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr =
+            mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            int error = errno;
+            munmap(ring->sq_ptr, ring->sq_size);
+            close(fd);
+            return -error;
+        }
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes =
+        mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        int error = errno;
+        if (ring->cq_ptr != ring->sq_ptr) {
+            munmap(ring->cq_ptr, ring->cq_size);
+        }
+        munmap(ring->sq_ptr, ring->sq_size);
+        close(fd);
+        return -error;
+    }
+
+    char *sq = (char *)ring->sq_ptr;
+    char *cq = (char *)ring->cq_ptr;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+/**
+ * @brief 释放 io_uring
+ *
+ * @param ring
+ */
+void XBOX_uring_exit(XBOX_uring *ring) {
+    if (ring->ring_fd < 0) {
+        return;
+    }
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr != ring->sq_ptr) {
+        munmap(ring->cq_ptr, ring->cq_size);
+    }
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->ring_fd);
+    ring->ring_fd = -1;
+}
+
+/**
+ * @brief 检查内核是否支持所有的操作
+ *        5.1 - 5.5 的内核可以创建 io_uring 但不支持 openat/statx/close 等操作, 也没有 IORING_REGISTER_PROBE
+ *
+ * @param ring
+ * @param opcodes IORING_OP_*
+ * @param number
+ * @return int 全部支持返回 1, 否则 (包括无法探测) 返回 0
+ */
+int XBOX_uring_supports(XBOX_uring *ring, const int *opcodes, int number) {
+    // 操作码是 u8, 256 项可以覆盖所有操作
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, size);
+    if (!probe) {
+        return 0;
+    }
+    int supported = syscall(__NR_io_uring_register, ring->ring_fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+    for (int i = 0; i < number && supported; i++) {
+        supported = opcodes[i] <= probe->last_op && (probe->ops[opcodes[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+    free(probe);
+    return supported;
+}
+
+/**
+ * @brief 获取一个空闲的 sqe, 内容已清零
+ *
+ * @param ring
+ * @return struct io_uring_sqe* 提交队列已满时返回 NULL
+ */
+struct io_uring_sqe *XBOX_uring_get_sqe(XBOX_uring *ring) {
+    unsigned head = XBOX_LOAD_ACQUIRE(ring->sq_head);
+    unsigned tail = *ring->sq_tail + ring->sq_queued;
+    if (tail - head >= ring->entries) {
+        return NULL;
+    }
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    ring->sq_array[index] = index;
+    ring->sq_queued++;
+    return sqe;
+}
+
+/**
+ * @brief 提交所有已填写的 sqe 并等待至少 wait_nr 个完成事件
+ *
+ * @param ring
+ * @param wait_nr
+ * @return int 提交的数量, 失败返回 -errno
+ */
+int XBOX_uring_submit_and_wait(XBOX_uring *ring, unsigned wait_nr) {
+    unsigned submit = ring->sq_queued;
+    if (submit) {
+        XBOX_STORE_RELEASE(ring->sq_tail, *ring->sq_tail + submit);
+        ring->sq_queued = 0;
+    }
+    if (!submit && !wait_nr) {
+        return 0;
+    }
+    int ret;
+    do {
+        ret = (int)syscall(
+            __NR_io_uring_enter, ring->ring_fd, submit, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (ret < 0 && errno == EINTR);
+    return ret < 0 ? -errno : ret;
+}
+
+/**
+ * @brief 获取一个完成事件, 不阻塞
+ *
+ * @param ring
+ * @return struct io_uring_cqe* 没有完成事件时返回 NULL, 处理完之后需要调用 XBOX_uring_cqe_seen
+ */
+struct io_uring_cqe *XBOX_uring_peek_cqe(XBOX_uring *ring) {
+    unsigned head = *ring->cq_head;
+    if (head == XBOX_LOAD_ACQUIRE(ring->cq_tail)) {
+        return NULL;
+    }
+    return &ring->cqes[head & *ring->cq_mask];
+}
+
+/**
+ * @brief 标记一个完成事件已处理
+ *
+ * @param ring
+ */
+void XBOX_uring_cqe_seen(XBOX_uring *ring) {
+    XBOX_STORE_RELEASE(ring->cq_head, *ring->cq_head + 1);
+}
+
+void XBOX_uring_prep_openat(struct io_uring_sqe *sqe, int dfd, const char *path, int flags, uint64_t user_data) {
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = dfd;
+    sqe->addr = (uint64_t)(uintptr_t)path;
+    sqe->open_flags = flags;
+    sqe->user_data = user_data;
+}
+
+void XBOX_uring_prep_statx(struct io_uring_sqe *sqe,
+                           int dfd,
+                           const char *path,
+                           int flags,
+                           unsigned mask,
+                           struct statx *statxbuf,
+                           uint64_t user_data) {
+    sqe->opcode = IORING_OP_STATX;
+    sqe->fd = dfd;
+    sqe->addr = (uint64_t)(uintptr_t)path;
+    sqe->len = mask;
+    sqe->off = (uint64_t)(uintptr_t)statxbuf;
+    sqe->statx_flags = flags;
+    sqe->user_data = user_data;
+}
+
+void XBOX_uring_prep_read(
+    struct io_uring_sqe *sqe, int fd, void *buf, unsigned length, uint64_t offset, uint64_t user_data) {
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = length;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+}
+
+void XBOX_uring_prep_close(struct io_uring_sqe *sqe, int fd, uint64_t user_data) {
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    sqe->user_data = user_data;
+}
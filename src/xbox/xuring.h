@@ -0,0 +1,130 @@
+/*
+ *Copyright (c) 2023 All rights reserved
+ *@description: io_uring 的简单封装
+ *@author: Zhixing Lu
+ *@date: 2023-11-12
+ *@email: luzhixing12345@163.com
+ *@Github: luzhixing12345
+ */
+
+#ifndef XBOX_XURING_H
+#define XBOX_XURING_H
+
+#include <linux/io_uring.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 不依赖 liburing, 直接使用 io_uring_setup/io_uring_enter 系统调用
+
+struct statx;
+
+typedef struct {
+    int ring_fd;
+    unsigned entries;
+    unsigned sq_queued;  // 已经填写但尚未提交的 sqe 数量
+    // 提交队列
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    // 完成队列
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    // mmap 的区域
+    void *sq_ptr;
+    void *cq_ptr;
+    size_t sq_size;
+    size_t cq_size;
+    size_t sqes_size;
+} XBOX_uring;
+
+/**
+ * @brief 初始化 io_uring
+ *
+ * @param ring
+ * @param entries 提交队列的长度
+ * @return int 成功返回 0, 内核不支持或被禁止时返回 -errno, 调用者应退回同步 IO
+ */
+int XBOX_uring_init(XBOX_uring *ring, unsigned entries);
+
+/**
+ * @brief 释放 io_uring
+ *
+ * @param ring
+ */
+void XBOX_uring_exit(XBOX_uring *ring);
+
+/**
+ * @brief 检查内核是否支持所有的操作
+ *        5.1 - 5.5 的内核可以创建 io_uring 但不支持 openat/statx/close 等操作, 也没有 IORING_REGISTER_PROBE
+ *
+ * @param ring
+ * @param opcodes IORING_OP_*
+ * @param number
+ * @return int 全部支持返回 1, 否则 (包括无法探测) 返回 0
+ */
+int XBOX_uring_supports(XBOX_uring *ring, const int *opcodes, int number);
+
+/**
+ * @brief 获取一个空闲的 sqe, 内容已清零
+ *
+ * @param ring
+ * @return struct io_uring_sqe* 提交队列已满时返回 NULL
+ */
+struct io_uring_sqe *XBOX_uring_get_sqe(XBOX_uring *ring);
+
+/**
+ * @brief 提交所有已填写的 sqe 并等待至少 wait_nr 个完成事件
+ *
+ * @param ring
+ * @param wait_nr
+ * @return int 提交的数量, 失败返回 -errno
+ */
+int XBOX_uring_submit_and_wait(XBOX_uring *ring, unsigned wait_nr);
+
+/**
+ * @brief 获取一个完成事件, 不阻塞
+ *
+ * @param ring
+ * @return struct io_uring_cqe* 没有完成事件时返回 NULL, 处理完之后需要调用 XBOX_uring_cqe_seen
+ */
+struct io_uring_cqe *XBOX_uring_peek_cqe(XBOX_uring *ring);
+
+/**
+ * @brief 标记一个完成事件已处理
+ *
+ * @param ring
+ */
+void XBOX_uring_cqe_seen(XBOX_uring *ring);
+
+/**
+ * @brief 填写 openat 请求
+ */
+void XBOX_uring_prep_openat(struct io_uring_sqe *sqe, int dfd, const char *path, int flags, uint64_t user_data);
+
+/**
+ * @brief 填写 statx 请求, path 为 "" 且 flags 包含 AT_EMPTY_PATH 时获取 dfd 本身的信息
+ */
+void XBOX_uring_prep_statx(struct io_uring_sqe *sqe,
+                           int dfd,
+                           const char *path,
+                           int flags,
+                           unsigned mask,
+                           struct statx *statxbuf,
+                           uint64_t user_data);
+
+/**
+ * @brief 填写 read 请求
+ */
+void XBOX_uring_prep_read(
+    struct io_uring_sqe *sqe, int fd, void *buf, unsigned length, uint64_t offset, uint64_t user_data);
+
+/**
+ * @brief 填写 close 请求
+ */
+void XBOX_uring_prep_close(struct io_uring_sqe *sqe, int fd, uint64_t user_data);
+
+#endif  // XBOX_XURING_H
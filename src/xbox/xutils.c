@@ -1,9 +1,167 @@
 
 #include "xutils.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <linux/limits.h>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+
+// getdents64 返回的目录项, glibc 2.30 之前的头文件中没有定义
+struct XBOX_linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+/**
+ * @brief 打开目录迭代器
+ *
+ * @param iterator
+ * @param path
+ * @param flag 同 XBOX_opendir
+ * @return int 成功返回 0, 失败返回 -errno
+ */
+int XBOX_dir_open(XBOX_DirIterator* iterator, const char* path, int flag) {
+    memset(iterator, 0, sizeof(XBOX_DirIterator));
+    iterator->fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (iterator->fd < 0) {
+        return -errno;
+    }
+    iterator->buffer = (char*)malloc(XBOX_DIR_BUFFER_SIZE);
+    if (iterator->buffer == NULL) {
+        close(iterator->fd);
+        iterator->fd = -1;
+        return -ENOMEM;
+    }
+    iterator->flag = flag;
+    return 0;
+}
+
+/**
+ * @brief 读取下一个目录项
+ *
+ * @param iterator
+ * @param entry
+ * @return int 读到返回 1, 结束返回 0, 失败返回 -errno
+ */
+int XBOX_dir_next(XBOX_DirIterator* iterator, XBOX_DirEntry* entry) {
+    for (;;) {
+        if (iterator->position >= iterator->end) {
+            long length = syscall(SYS_getdents64, iterator->fd, iterator->buffer, XBOX_DIR_BUFFER_SIZE);
+            if (length < 0) {
+                return -errno;
+            }
+            if (length == 0) {
+                return 0;
+            }
+            iterator->position = 0;
+            iterator->end = (int)length;
+        }
+        struct XBOX_linux_dirent64* dirent = (struct XBOX_linux_dirent64*)(iterator->buffer + iterator->position);
+        iterator->position += dirent->d_reclen;
+        const char* name = dirent->d_name;
+        if ((iterator->flag & XBOX_DIR_IGNORE_HIDDEN) && name[0] == '.') {
+            continue;
+        }
+        if ((iterator->flag & XBOX_DIR_IGNORE_CURRENT) && name[0] == '.' &&
+            (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        entry->name = name;
+        entry->type = dirent->d_type;
+        return 1;
+    }
+}
+
+/**
+ * @brief 关闭目录迭代器
+ *
+ * @param iterator
+ */
+void XBOX_dir_close(XBOX_DirIterator* iterator) {
+    if (iterator->fd >= 0) {
+        close(iterator->fd);
+        iterator->fd = -1;
+    }
+    free(iterator->buffer);
+    iterator->buffer = NULL;
+}
+
+/**
+ * @brief 一次遍历读取目录的所有项, 名字保存在 list 的 arena 中
+ *
+ * @param list 需要调用 XBOX_dir_list_free 释放
+ * @param path
+ * @param flag 同 XBOX_opendir
+ * @return int 成功返回 0, 失败返回 -errno
+ */
+int XBOX_dir_read(XBOX_DirList* list, const char* path, int flag) {
+    memset(list, 0, sizeof(XBOX_DirList));
+    XBOX_DirIterator iterator;
+    int ret = XBOX_dir_open(&iterator, path, flag);
+    if (ret < 0) {
+        return ret;
+    }
+    XBOX_DirEntry entry;
+    while ((ret = XBOX_dir_next(&iterator, &entry)) > 0) {
+        size_t length = strlen(entry.name) + 1;
+        if (list->names_size + length > UINT32_MAX) {
+            ret = -EOVERFLOW;
+            break;
+        }
+        // arena 和项数组都按倍数增长, 不为每一项单独分配
+        if (list->names_size + length > list->names_capacity) {
+            size_t capacity = list->names_capacity ? list->names_capacity * 2 : XBOX_DIR_BUFFER_SIZE;
+            while (capacity < list->names_size + length) {
+                capacity *= 2;
+            }
+            char* names = (char*)realloc(list->names, capacity);
+            if (names == NULL) {
+                ret = -ENOMEM;
+                break;
+            }
+            list->names = names;
+            list->names_capacity = capacity;
+        }
+        if (list->count == list->capacity) {
+            int capacity = list->capacity ? list->capacity * 2 : 1024;
+            XBOX_DirListEntry* entries =
+                (XBOX_DirListEntry*)realloc(list->entries, sizeof(XBOX_DirListEntry) * capacity);
+            if (entries == NULL) {
+                ret = -ENOMEM;
+                break;
+            }
+            list->entries = entries;
+            list->capacity = capacity;
+        }
+        memcpy(list->names + list->names_size, entry.name, length);
+        list->entries[list->count].name_offset = (uint32_t)list->names_size;
+        list->entries[list->count].type = entry.type;
+        list->names_size += length;
+        list->count++;
+    }
+    XBOX_dir_close(&iterator);
+    if (ret < 0) {
+        XBOX_dir_list_free(list);
+        return ret;
+    }
+    return 0;
+}
+
+/**
+ * @brief 释放 XBOX_dir_read 分配的内存
+ *
+ * @param list
+ */
+void XBOX_dir_list_free(XBOX_DirList* list) {
+    free(list->names);
+    free(list->entries);
+    memset(list, 0, sizeof(XBOX_DirList));
+}
 
 /**
  * @brief 打开一个目录并读取该目录下所有的文件和目录
@@ -16,61 +174,38 @@
  * @return XBOX_Dir* 需要调用 XBOX_freedir 释放
  */
 XBOX_Dir* XBOX_opendir(const char* path, int flag) {
-    DIR* dir;
-    struct dirent* entry;
-
-    int length;
-    dir = opendir(path);
-    if (dir == NULL) {
+    XBOX_DirList list;
+    int ret = XBOX_dir_read(&list, path, flag);
+    if (ret < 0) {
         // 12 是 "open failed " 的长度
         static char error_info[PATH_MAX + 12];
         memset(error_info, 0, PATH_MAX + 12);
-        sprintf(error_info, "open failed %s", path);
+        snprintf(error_info, sizeof(error_info), "open failed %s", path);
+        errno = -ret;
         perror(error_info);
         exit(1);
     }
 
+    // 只遍历一次目录, 所有 XBOX_File 放在一个连续数组中
     XBOX_Dir* directory = (XBOX_Dir*)malloc(sizeof(XBOX_Dir));
     memset(directory, 0, sizeof(XBOX_Dir));
-    while ((entry = readdir(dir)) != NULL) {
-        if ((flag & XBOX_DIR_IGNORE_HIDDEN) && entry->d_name[0] == '.') {
-            continue;
-        }
-        if ((flag & XBOX_DIR_IGNORE_CURRENT) &&
-            (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))) {
-            continue;
-        }
-        directory->count++;
-        if (entry->d_type == DT_DIR) {
+    directory->count = list.count;
+    directory->files = (XBOX_File*)malloc(sizeof(XBOX_File) * (list.count ? list.count : 1));
+    directory->dp = (XBOX_File**)malloc(sizeof(XBOX_File*) * (list.count ? list.count : 1));
+    for (int i = 0; i < list.count; i++) {
+        XBOX_File* file = &directory->files[i];
+        snprintf(file->name, sizeof(file->name), "%s", XBOX_DIR_LIST_NAME(&list, i));
+        file->type = list.entries[i].type;
+        if (file->type == DT_DIR) {
             // 目录
             directory->d_count++;
         } else {
             directory->f_count++;
         }
+        directory->dp[i] = file;
     }
-    rewinddir(dir);
-    directory->dp = (XBOX_File**)malloc(sizeof(XBOX_File*) * directory->count);
-    for (int i = 0; i < directory->count; i++) {
-        directory->dp[i] = (XBOX_File*)malloc(sizeof(XBOX_File));
-    }
-    int i = 0;
-    while ((entry = readdir(dir)) != NULL) {
-        if ((flag & XBOX_DIR_IGNORE_HIDDEN) && entry->d_name[0] == '.') {
-            continue;
-        }
-        if ((flag & XBOX_DIR_IGNORE_CURRENT) &&
-            (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))) {
-            continue;
-        }
-        length = strlen(entry->d_name);
-        strncpy(directory->dp[i]->name, entry->d_name, length);
-        directory->dp[i]->name[length] = 0;
-        directory->dp[i]->type = entry->d_type;
-        i++;
-    }
-    length = strlen(path);
-    strncpy(directory->name, path, length);
-    closedir(dir);
+    snprintf(directory->name, sizeof(directory->name), "%s", path);
+    XBOX_dir_list_free(&list);
     return directory;
 }
 
@@ -81,9 +216,7 @@ XBOX_Dir* XBOX_opendir(const char* path, int flag) {
  */
 void XBOX_freedir(XBOX_Dir* directory) {
     directory->parent = NULL;
-    for (int i = 0; i < directory->count; i++) {
-        free(directory->dp[i]);
-    }
+    free(directory->files);
     free(directory->dp);
     free(directory);
 }
@@ -213,3 +346,292 @@ int XBOX_number_length(long long number) {
     }
     return size_length;
 }
+
+/**
+ * @brief 按 key 从小到大的稳定排序, LSD 基数排序, 每次处理 8 位, 所有 key 都相同的字节跳过
+ *
+ * @param items
+ * @param number
+ * @return int 成功返回 0, 内存不足返回 -ENOMEM
+ */
+int XBOX_radix_sort(XBOX_SortItem* items, size_t number) {
+    if (number < 2) {
+        return 0;
+    }
+    size_t(*counts)[256] = calloc(8, sizeof(*counts));
+    XBOX_SortItem* temp = malloc(sizeof(XBOX_SortItem) * number);
+    if (!counts || !temp) {
+        free(counts);
+        free(temp);
+        return -ENOMEM;
+    }
+    // 一次遍历统计 8 个字节的分布
+    for (size_t i = 0; i < number; i++) {
+        uint64_t key = items[i].key;
+        for (int byte = 0; byte < 8; byte++) {
+            counts[byte][(key >> (byte * 8)) & 0xff]++;
+        }
+    }
+    XBOX_SortItem* from = items;
+    XBOX_SortItem* to = temp;
+    for (int byte = 0; byte < 8; byte++) {
+        size_t* count = counts[byte];
+        int shift = byte * 8;
+        if (count[(from[0].key >> shift) & 0xff] == number) {
+            // 例如地址的高位, 所有 key 在这个字节上都相同
+            continue;
+        }
+        size_t offset = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            size_t digit_number = count[digit];
+            count[digit] = offset;
+            offset += digit_number;
+        }
+        for (size_t i = 0; i < number; i++) {
+            to[count[(from[i].key >> shift) & 0xff]++] = from[i];
+        }
+        XBOX_SortItem* swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != items) {
+        memcpy(items, from, sizeof(XBOX_SortItem) * number);
+    }
+    free(counts);
+    free(temp);
+    return 0;
+}
+
+static int string_item_cmp(const void* a, const void* b) {
+    uint64_t x = ((const XBOX_StringItem*)a)->index;
+    uint64_t y = ((const XBOX_StringItem*)b)->index;
+    return x < y ? -1 : x > y;
+}
+
+static void string_item_swap(XBOX_StringItem* items, size_t i, size_t j) {
+    XBOX_StringItem temp = items[i];
+    items[i] = items[j];
+    items[j] = temp;
+}
+
+/**
+ * @brief items 的前 depth 个字符都相同, 从第 depth 个字符开始排序
+ */
+static void string_sort(XBOX_StringItem* items, size_t number, size_t depth) {
+    while (number > 1) {
+        if (number < 16) {
+            // 插入排序
+            for (size_t i = 1; i < number; i++) {
+                XBOX_StringItem item = items[i];
+                size_t j = i;
+                while (j > 0) {
+                    int cmp = strcmp(items[j - 1].str + depth, item.str + depth);
+                    if (cmp < 0 || (cmp == 0 && items[j - 1].index < item.index)) {
+                        break;
+                    }
+                    items[j] = items[j - 1];
+                    j--;
+                }
+                items[j] = item;
+            }
+            return;
+        }
+        // 三路划分: [0, lt) 的字符小于 pivot, [lt, gt) 等于, [gt, number) 大于
+        unsigned char pivot = (unsigned char)items[number / 2].str[depth];
+        size_t lt = 0, i = 0, gt = number;
+        while (i < gt) {
+            unsigned char c = (unsigned char)items[i].str[depth];
+            if (c < pivot) {
+                string_item_swap(items, lt++, i++);
+            } else if (c > pivot) {
+                string_item_swap(items, i, --gt);
+            } else {
+                i++;
+            }
+        }
+        string_sort(items, lt, depth);
+        string_sort(items + gt, number - gt, depth);
+        if (pivot == 0) {
+            // 中间部分是完全相同的字符串
+            qsort(items + lt, gt - lt, sizeof(XBOX_StringItem), string_item_cmp);
+            return;
+        }
+        items += lt;
+        number = gt - lt;
+        depth++;
+    }
+}
+
+/**
+ * @brief 按 str 的字典序排序, 多关键字快速排序, 每个字符只比较一次, 相同的字符串按 index 排序
+ *
+ * @param items
+ * @param number
+ */
+void XBOX_string_sort(XBOX_StringItem* items, size_t number) {
+    string_sort(items, number, 0);
+}
+
+/**
+ * @brief 初始化有界堆
+ *
+ * @param heap
+ * @param capacity 保留的项数
+ * @param cmp 与 qsort 的比较函数相同, 小于 0 表示第一个参数排在前面
+ */
+void XBOX_top_init(XBOX_TopHeap* heap, size_t capacity, int (*cmp)(const void*, const void*)) {
+    heap->items = malloc(sizeof(void*) * (capacity ? capacity : 1));
+    heap->number = 0;
+    heap->capacity = capacity;
+    heap->cmp = cmp;
+}
+
+/**
+ * @brief 从 index 开始向下调整, 堆中排在最后的项在堆顶
+ */
+static void top_sift_down(XBOX_TopHeap* heap, size_t index, size_t number) {
+    void** items = heap->items;
+    void* item = items[index];
+    for (;;) {
+        size_t child = index * 2 + 1;
+        if (child >= number) {
+            break;
+        }
+        if (child + 1 < number && heap->cmp(items[child + 1], items[child]) > 0) {
+            child++;
+        }
+        if (heap->cmp(items[child], item) <= 0) {
+            break;
+        }
+        items[index] = items[child];
+        index = child;
+    }
+    items[index] = item;
+}
+
+/**
+ * @brief 加入一项, 堆满时只有排在堆顶之前的项才会替换堆顶
+ *
+ * @param heap
+ * @param item
+ */
+void XBOX_top_push(XBOX_TopHeap* heap, void* item) {
+    void** items = heap->items;
+    if (heap->number < heap->capacity) {
+        size_t index = heap->number++;
+        while (index > 0) {
+            size_t parent = (index - 1) / 2;
+            if (heap->cmp(items[parent], item) >= 0) {
+                break;
+            }
+            items[index] = items[parent];
+            index = parent;
+        }
+        items[index] = item;
+    } else if (heap->capacity && heap->cmp(item, items[0]) < 0) {
+        items[0] = item;
+        top_sift_down(heap, 0, heap->number);
+    }
+}
+
+/**
+ * @brief 把保留的项按 cmp 的顺序排列在 heap->items 中, 之后不能再 push
+ *
+ * @param heap
+ * @return size_t 保留的项数
+ */
+size_t XBOX_top_finish(XBOX_TopHeap* heap) {
+    // 堆排序: 每次把堆顶 (排在最后的项) 放到末尾
+    for (size_t number = heap->number; number > 1; number--) {
+        void* last = heap->items[0];
+        heap->items[0] = heap->items[number - 1];
+        heap->items[number - 1] = last;
+        top_sift_down(heap, 0, number - 1);
+    }
+    return heap->number;
+}
+
+void XBOX_top_free(XBOX_TopHeap* heap) {
+    free(heap->items);
+    heap->items = NULL;
+}
+
+#define HASH_PRIME32_1 0x9E3779B1U
+#define HASH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define HASH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define HASH_STRIPE_SIZE 64
+#define HASH_STRIPES_PER_SCRAMBLE 16  // 每 1KB 打散一次累加器, 避免乘法的高位信息丢失
+
+static const uint64_t hash_secret[8] = {
+    0xc0e16b163a85a4dcULL,
+    0x890acd8dd443c47cULL,
+    0xb3889d8a6dc47761ULL,
+    0x6a0398e528f0ae6aULL,
+    0x048344ece48a855eULL,
+    0xf175cfea21871330ULL,
+    0x391ceef02702c2fdULL,
+    0x4baf8cac4784cb12ULL,
+};
+
+/**
+ * @brief 累加一个 64 字节的块, 密钥和块的序号有关, 相同的数据出现在不同的位置时结果不同
+ */
+static void hash_accumulate(uint64_t* acc, const unsigned char* stripe, uint64_t seed) {
+    for (int i = 0; i < 8; i++) {
+        uint64_t value;
+        memcpy(&value, stripe + i * 8, sizeof(uint64_t));
+        uint64_t key = value ^ (hash_secret[i] + seed);
+        acc[i ^ 1] += value;
+        acc[i] += (key & 0xffffffff) * (key >> 32);
+    }
+}
+
+static void hash_scramble(uint64_t* acc) {
+    for (int i = 0; i < 8; i++) {
+        acc[i] = (acc[i] ^ (acc[i] >> 47) ^ hash_secret[i]) * HASH_PRIME32_1;
+    }
+}
+
+/**
+ * @brief 64 位非加密哈希, 结构与 xxh3 类似: 8 条互不依赖的 64 位通道, 每次处理 64 字节
+ *        不与 xxh3 的结果兼容, 只用于在同一个进程中比较内容
+ *
+ * @param data
+ * @param size
+ * @param seed
+ * @return uint64_t
+ */
+uint64_t XBOX_hash64(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t acc[8] = {HASH_PRIME64_1,
+                       HASH_PRIME64_2,
+                       HASH_PRIME64_4,
+                       HASH_PRIME32_1,
+                       hash_secret[0],
+                       hash_secret[3],
+                       hash_secret[5],
+                       hash_secret[7]};
+    size_t stripe_number = size / HASH_STRIPE_SIZE;
+    for (size_t i = 0; i < stripe_number; i++) {
+        hash_accumulate(acc, p + i * HASH_STRIPE_SIZE, seed + i * HASH_PRIME64_2);
+        if (i % HASH_STRIPES_PER_SCRAMBLE == HASH_STRIPES_PER_SCRAMBLE - 1) {
+            hash_scramble(acc);
+        }
+    }
+    // 最后不满 64 字节的部分补 0, 长度在最后混入
+    unsigned char last[HASH_STRIPE_SIZE];
+    memset(last, 0, sizeof(last));
+    memcpy(last, p + stripe_number * HASH_STRIPE_SIZE, size % HASH_STRIPE_SIZE);
+    hash_accumulate(acc, last, seed + stripe_number * HASH_PRIME64_2);
+
+    uint64_t hash = size * HASH_PRIME64_1 + seed;
+    for (int i = 0; i < 8; i++) {
+        hash ^= (acc[i] ^ (acc[i] >> 29)) * HASH_PRIME64_2;
+        hash = ((hash << 27) | (hash >> 37)) * HASH_PRIME64_1 + HASH_PRIME64_4;
+    }
+    hash ^= hash >> 37;
+    hash *= 0x165667919E3779F9ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
@@ -6,6 +6,7 @@
 #include <dirent.h>
 #include <linux/limits.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,6 +21,8 @@
 #define XBOX_DIR_IGNORE_HIDDEN 1
 #define XBOX_DIR_IGNORE_CURRENT (1<<1)
 
+#define XBOX_DIR_BUFFER_SIZE (128 * 1024)  // getdents64 每次读取的大小
+
 
 #define XBOX_PRINT_BUFFER_SIZE 1024
 #define XBOX_MAX_INPUT_SIZE 1024
@@ -37,10 +40,62 @@ typedef struct XBOX_Dir {
     int d_count;  // 目录数量
     int f_count;  // 文件数量
     XBOX_File** dp;
+    XBOX_File* files;  // dp 指向的连续数组
     struct XBOX_Dir* parent;  // 父目录
     int is_last;
 } XBOX_Dir;
 
+typedef struct {
+    const char* name;    // 指向迭代器的缓冲区, 下一次调用 XBOX_dir_next 之前有效
+    unsigned char type;  // DT_*, 文件系统不提供类型时为 DT_UNKNOWN
+} XBOX_DirEntry;
+
+// 单次遍历的目录迭代器, 每次 getdents64 读取一大块目录项, 不为每一项分配内存
+typedef struct {
+    int fd;
+    int flag;
+    char* buffer;
+    int position;  // 下一项在 buffer 中的位置
+    int end;       // buffer 中有效数据的长度
+} XBOX_DirIterator;
+
+// 目录项的紧凑存储: 名字连续存放在 names 中, entries 只记录偏移和类型
+typedef struct {
+    uint32_t name_offset;
+    unsigned char type;
+} XBOX_DirListEntry;
+
+typedef struct {
+    char* names;
+    size_t names_size;
+    size_t names_capacity;
+    XBOX_DirListEntry* entries;
+    int count;
+    int capacity;
+} XBOX_DirList;
+
+#define XBOX_DIR_LIST_NAME(list, i) ((list)->names + (list)->entries[i].name_offset)
+
+// 排序时只移动 (key, 下标), 原来的记录保持不动
+typedef struct {
+    uint64_t key;
+    uint64_t index;
+} XBOX_SortItem;
+
+typedef struct {
+    const char* str;
+    uint64_t index;
+} XBOX_StringItem;
+
+// 只保留排在最前面的 capacity 项的有界堆, 堆顶是已保留的项中排在最后的一项
+// 新的项只需要和堆顶比较一次, 选出 n 项中的前 N 项只需要 O(n log N)
+typedef struct {
+    void** items;
+    size_t number;
+    size_t capacity;
+    int (*cmp)(const void*, const void*);  // 与 qsort 的比较函数相同, 参数是 push 的指针
+} XBOX_TopHeap;
+
 /**
  * @brief 打开一个目录并读取其中所有的文件和目录
  *
@@ -57,6 +112,49 @@ XBOX_Dir* XBOX_opendir(const char* path, int flag);
  */
 void XBOX_freedir(XBOX_Dir* directory);
 
+/**
+ * @brief 打开目录迭代器
+ *
+ * @param iterator
+ * @param path
+ * @param flag 同 XBOX_opendir
+ * @return int 成功返回 0, 失败返回 -errno
+ */
+int XBOX_dir_open(XBOX_DirIterator* iterator, const char* path, int flag);
+
+/**
+ * @brief 读取下一个目录项
+ *
+ * @param iterator
+ * @param entry
+ * @return int 读到返回 1, 结束返回 0, 失败返回 -errno
+ */
+int XBOX_dir_next(XBOX_DirIterator* iterator, XBOX_DirEntry* entry);
+
+/**
+ * @brief 关闭目录迭代器
+ *
+ * @param iterator
+ */
+void XBOX_dir_close(XBOX_DirIterator* iterator);
+
+/**
+ * @brief 一次遍历读取目录的所有项, 名字保存在 list 的 arena 中
+ *
+ * @param list 需要调用 XBOX_dir_list_free 释放
+ * @param path
+ * @param flag 同 XBOX_opendir
+ * @return int 成功返回 0, 失败返回 -errno
+ */
+int XBOX_dir_read(XBOX_DirList* list, const char* path, int flag);
+
+/**
+ * @brief 释放 XBOX_dir_read 分配的内存
+ *
+ * @param list
+ */
+void XBOX_dir_list_free(XBOX_DirList* list);
+
 /**
  * @brief 连接路径, 可变参数, 最后一个参数传 NULL
  *
@@ -90,4 +188,59 @@ char* XBOX_stat_access_mode(mode_t mode);
  */
 int XBOX_number_length(long long number);
 
+/**
+ * @brief 按 key 从小到大的稳定排序, LSD 基数排序, 每次处理 8 位, 所有 key 都相同的字节跳过
+ *
+ * @param items
+ * @param number
+ * @return int 成功返回 0, 内存不足返回 -ENOMEM
+ */
+int XBOX_radix_sort(XBOX_SortItem* items, size_t number);
+
+/**
+ * @brief 按 str 的字典序排序, 多关键字快速排序, 每个字符只比较一次, 相同的字符串按 index 排序
+ *
+ * @param items
+ * @param number
+ */
+void XBOX_string_sort(XBOX_StringItem* items, size_t number);
+
+/**
+ * @brief 初始化有界堆
+ *
+ * @param heap
+ * @param capacity 保留的项数
+ * @param cmp 与 qsort 的比较函数相同, 小于 0 表示第一个参数排在前面
+ */
+void XBOX_top_init(XBOX_TopHeap* heap, size_t capacity, int (*cmp)(const void*, const void*));
+
+/**
+ * @brief 加入一项, 堆满时只有排在堆顶之前的项才会替换堆顶
+ *
+ * @param heap
+ * @param item
+ */
+void XBOX_top_push(XBOX_TopHeap* heap, void* item);
+
+/**
+ * @brief 把保留的项按 cmp 的顺序排列在 heap->items 中, 之后不能再 push
+ *
+ * @param heap
+ * @return size_t 保留的项数
+ */
+size_t XBOX_top_finish(XBOX_TopHeap* heap);
+
+void XBOX_top_free(XBOX_TopHeap* heap);
+
+/**
+ * @brief 64 位非加密哈希, 结构与 xxh3 类似: 8 条互不依赖的 64 位通道, 每次处理 64 字节
+ *        不与 xxh3 的结果兼容, 只用于在同一个进程中比较内容
+ *
+ * @param data
+ * @param size
+ * @param seed
+ * @return uint64_t
+ */
+uint64_t XBOX_hash64(const void* data, size_t size, uint64_t seed);
+
 #endif // XBOX_XUTILS_H
@@ -0,0 +1,309 @@
+/*
+ *Copyright (c) 2023 All rights reserved
+ *@description: 双缓冲的异步输出
+ *@author: Zhixing Lu
+ *@date: 2023-11-26
+ *@email: luzhixing12345@163.com
+ *@Github: luzhixing12345
+ */
+
+#define _GNU_SOURCE
+#include "xwriter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+static int write_all(int fd, const char *data, size_t size) {
+    while (size) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        data += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief 把整块缓冲区的页交给管道
+ *
+ * @return int 成功返回 0, vmsplice 不可用时返回 EINVAL 等, 调用者退回 write
+ */
+static int vmsplice_all(int fd, char *data, size_t size) {
+    while (size) {
+        struct iovec iov = {data, size};
+        ssize_t n = vmsplice(fd, &iov, 1, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        data += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+static void *writer_thread_run(void *arg) {
+    XBOX_writer *writer = (XBOX_writer *)arg;
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        while (!writer->stop && writer->queued == 0) {
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+        if (writer->queued == 0) {
+            break;
+        }
+        int index = writer->next_write;
+        size_t length = writer->lengths[index];
+        int splice = writer->spliced[index];
+        int failed = writer->error;
+        if (splice) {
+            // 管道的容量可能被读端调大, 每次写之前更新, 超过缓冲区大小之后不再使用 vmsplice
+            int pipe_size = fcntl(writer->fd, F_GETPIPE_SZ);
+            if (pipe_size > 0 && (size_t)pipe_size > writer->pipe_size) {
+                writer->pipe_size = (size_t)pipe_size;
+            }
+            if (writer->pipe_size > writer->buffer_size) {
+                writer->use_vmsplice = 0;
+                splice = 0;
+            }
+        }
+        pthread_mutex_unlock(&writer->lock);
+
+        int error = 0;
+        if (!failed) {
+            if (splice && vmsplice_all(writer->fd, writer->buffers[index], length)) {
+                splice = 0;
+            }
+            if (!splice) {
+                error = write_all(writer->fd, writer->buffers[index], length);
+            }
+        }
+
+        pthread_mutex_lock(&writer->lock);
+        if (error && !writer->error) {
+            writer->error = error;
+        }
+        if (writer->spliced[index] && !splice) {
+            // vmsplice 失败, 之后的缓冲区都直接 write
+            writer->use_vmsplice = 0;
+        }
+        writer->spliced[index] = splice;
+        writer->completed_bytes += length;
+        writer->next_write = (writer->next_write + 1) % writer->buffer_number;
+        writer->queued--;
+        pthread_cond_broadcast(&writer->cond);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+/**
+ * @brief 缓冲区是否可以重新填充, 需要持有锁
+ *        vmsplice 写出的缓冲区要等管道中之后写入的数据超过管道容量, 即这些页已经被读端取走
+ */
+static int writer_buffer_free(XBOX_writer *writer, int index) {
+    uint64_t end = writer->end_offsets[index];
+    if (writer->spliced[index]) {
+        end += writer->pipe_size;
+    }
+    return writer->completed_bytes >= end;
+}
+
+/**
+ * @brief 把正在填充的缓冲区交给写线程, 并等待下一个缓冲区可用, 需要持有锁
+ */
+static void writer_submit(XBOX_writer *writer) {
+    int index = writer->fill;
+    writer->submitted_bytes += writer->lengths[index];
+    writer->end_offsets[index] = writer->submitted_bytes;
+    // 只有整块的缓冲区使用 vmsplice, 刷新时不满的部分直接复制到管道
+    writer->spliced[index] = writer->use_vmsplice && writer->lengths[index] == writer->buffer_size;
+    writer->queued++;
+    pthread_cond_broadcast(&writer->cond);
+
+    writer->fill = (writer->fill + 1) % writer->buffer_number;
+    index = writer->fill;
+    while (!writer_buffer_free(writer, index)) {
+        if (writer->queued == 0) {
+            // 之后没有足够的数据把这些页挤出管道 (例如刚刚刷新过), 换一块新的内存
+            // 旧的页被管道引用, munmap 之后仍然有效
+            char *buffer = mmap(NULL, writer->buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (buffer != MAP_FAILED) {
+                munmap(writer->buffers[index], writer->buffer_size);
+                writer->buffers[index] = buffer;
+                writer->spliced[index] = 0;
+                break;
+            }
+        }
+        pthread_cond_wait(&writer->cond, &writer->lock);
+    }
+    writer->lengths[index] = 0;
+}
+
+/**
+ * @brief 初始化并启动写线程
+ *
+ * @param writer
+ * @param fd
+ * @return int 成功返回 0, 失败返回 -errno
+ */
+int XBOX_writer_init(XBOX_writer *writer, int fd) {
+    memset(writer, 0, sizeof(XBOX_writer));
+    writer->fd = fd;
+    writer->buffer_size = XBOX_WRITER_BUFFER_SIZE;
+    writer->buffer_number = 2;
+
+    struct stat st;
+    if (!fstat(fd, &st) && S_ISFIFO(st.st_mode)) {
+        int pipe_size = fcntl(fd, F_GETPIPE_SZ);
+        if (pipe_size > 0 && (size_t)pipe_size <= writer->buffer_size) {
+            writer->use_vmsplice = 1;
+            writer->pipe_size = (size_t)pipe_size;
+            writer->buffer_number = 3;
+        }
+    }
+    for (int i = 0; i < writer->buffer_number; i++) {
+        writer->buffers[i] =
+            mmap(NULL, writer->buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (writer->buffers[i] == MAP_FAILED) {
+            int error = errno;
+            for (int j = 0; j < i; j++) {
+                munmap(writer->buffers[j], writer->buffer_size);
+            }
+            return -error;
+        }
+    }
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->cond, NULL);
+    int error = pthread_create(&writer->thread, NULL, writer_thread_run, writer);
+    if (error) {
+        for (int i = 0; i < writer->buffer_number; i++) {
+            munmap(writer->buffers[i], writer->buffer_size);
+        }
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->cond);
+        return -error;
+    }
+    return 0;
+}
+
+/**
+ * @brief 写入数据, 缓冲区满时交给写线程
+ *
+ * @param writer
+ * @param data
+ * @param size
+ */
+void XBOX_writer_write(XBOX_writer *writer, const void *data, size_t size) {
+    const char *p = (const char *)data;
+    if (writer->sync) {
+        int error = write_all(writer->fd, p, size);
+        if (error && !writer->error) {
+            writer->error = error;
+        }
+        return;
+    }
+    // 填充的缓冲区只属于调用者, 只有交给写线程时才需要加锁
+    while (size) {
+        size_t *length = &writer->lengths[writer->fill];
+        size_t n = writer->buffer_size - *length;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(writer->buffers[writer->fill] + *length, p, n);
+        *length += n;
+        p += n;
+        size -= n;
+        if (*length == writer->buffer_size) {
+            pthread_mutex_lock(&writer->lock);
+            writer_submit(writer);
+            pthread_mutex_unlock(&writer->lock);
+        }
+    }
+}
+
+/**
+ * @brief 等待已经写入的数据全部写到 fd
+ *
+ * @param writer
+ */
+void XBOX_writer_flush(XBOX_writer *writer) {
+    if (writer->sync) {
+        return;
+    }
+    pthread_mutex_lock(&writer->lock);
+    if (writer->lengths[writer->fill]) {
+        writer_submit(writer);
+    }
+    while (writer->queued) {
+        pthread_cond_wait(&writer->cond, &writer->lock);
+    }
+    pthread_mutex_unlock(&writer->lock);
+}
+
+/**
+ * @brief fork 之后在子进程中调用, 子进程中没有写线程, 之后的数据直接写到 fd
+ *        父进程 fork 之前需要先 XBOX_writer_flush, 子进程不会再访问锁和缓冲区
+ *
+ * @param writer
+ */
+void XBOX_writer_detach(XBOX_writer *writer) {
+    writer->sync = 1;
+}
+
+/**
+ * @brief 写出剩余的数据, 停止写线程并释放缓冲区
+ *
+ * @param writer
+ * @return int 成功返回 0, 写失败返回 -errno
+ */
+int XBOX_writer_close(XBOX_writer *writer) {
+    if (writer->sync) {
+        return -writer->error;
+    }
+    XBOX_writer_flush(writer);
+    pthread_mutex_lock(&writer->lock);
+    writer->stop = 1;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+    for (int i = 0; i < writer->buffer_number; i++) {
+        munmap(writer->buffers[i], writer->buffer_size);
+    }
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->cond);
+    return -writer->error;
+}
+
+static ssize_t writer_stream_write(void *cookie, const char *data, size_t size) {
+    XBOX_writer_write((XBOX_writer *)cookie, data, size);
+    return (ssize_t)size;
+}
+
+/**
+ * @brief 写入 writer 的 FILE, 可以直接替换 stdout 使用 printf
+ *
+ * @param writer
+ * @return FILE* 在 XBOX_writer_close 之前需要 fclose
+ */
+FILE *XBOX_writer_stream(XBOX_writer *writer) {
+    cookie_io_functions_t functions = {NULL, writer_stream_write, NULL, NULL};
+    writer->stream = fopencookie(writer, "w", functions);
+    if (writer->stream) {
+        // stdio 的缓冲区只用于合并很小的写, 数据很快就会复制到 writer 的缓冲区
+        setvbuf(writer->stream, NULL, _IOFBF, 64 * 1024);
+    }
+    return writer->stream;
+}
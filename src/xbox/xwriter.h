@@ -0,0 +1,97 @@
+/*
+ *Copyright (c) 2023 All rights reserved
+ *@description: 双缓冲的异步输出
+ *@author: Zhixing Lu
+ *@date: 2023-11-26
+ *@email: luzhixing12345@163.com
+ *@Github: luzhixing12345
+ */
+
+#ifndef XBOX_XWRITER_H
+#define XBOX_XWRITER_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// 格式化线程填充一个缓冲区的同时, 写线程把另一个缓冲区写到 fd
+// fd 是管道时整块的缓冲区通过 vmsplice 把页直接交给管道, 不再复制一次
+// vmsplice 之后管道仍然引用这些页, 需要之后再写入至少一个管道容量的数据才能复用, 所以管道使用三个缓冲区
+
+#define XBOX_WRITER_BUFFER_SIZE (1024 * 1024)
+#define XBOX_WRITER_MAX_BUFFERS 3
+
+typedef struct {
+    int fd;
+    int use_vmsplice;  // fd 是管道并且 vmsplice 可用
+    int sync;          // 没有写线程, 直接 write, 例如 fork 之后的子进程
+    size_t pipe_size;  // 见过的最大管道容量
+    size_t buffer_size;
+    int buffer_number;
+    char *buffers[XBOX_WRITER_MAX_BUFFERS];  // mmap 分配, 被管道引用的页在 munmap 之后仍然有效
+    size_t lengths[XBOX_WRITER_MAX_BUFFERS];
+    uint64_t end_offsets[XBOX_WRITER_MAX_BUFFERS];  // 缓冲区最后一个字节之后在输出中的位置
+    int spliced[XBOX_WRITER_MAX_BUFFERS];           // 通过 vmsplice 写出
+    int fill;                                       // 格式化线程正在填充的缓冲区
+    int next_write;                                 // 写线程下一个要写的缓冲区
+    int queued;                                     // 等待写线程写出的缓冲区数量
+    uint64_t submitted_bytes;
+    uint64_t completed_bytes;
+    int stop;
+    int error;  // 第一次写失败的 errno
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    FILE *stream;
+} XBOX_writer;
+
+/**
+ * @brief 初始化并启动写线程
+ *
+ * @param writer
+ * @param fd
+ * @return int 成功返回 0, 失败返回 -errno
+ */
+int XBOX_writer_init(XBOX_writer *writer, int fd);
+
+/**
+ * @brief 写入数据, 缓冲区满时交给写线程
+ *
+ * @param writer
+ * @param data
+ * @param size
+ */
+void XBOX_writer_write(XBOX_writer *writer, const void *data, size_t size);
+
+/**
+ * @brief 等待已经写入的数据全部写到 fd
+ *
+ * @param writer
+ */
+void XBOX_writer_flush(XBOX_writer *writer);
+
+/**
+ * @brief fork 之后在子进程中调用, 子进程中没有写线程, 之后的数据直接写到 fd
+ *
+ * @param writer
+ */
+void XBOX_writer_detach(XBOX_writer *writer);
+
+/**
+ * @brief 写出剩余的数据, 停止写线程并释放缓冲区
+ *
+ * @param writer
+ * @return int 成功返回 0, 写失败返回 -errno
+ */
+int XBOX_writer_close(XBOX_writer *writer);
+
+/**
+ * @brief 写入 writer 的 FILE, 可以直接替换 stdout 使用 printf
+ *
+ * @param writer
+ * @return FILE* 在 XBOX_writer_close 之前需要 fclose
+ */
+FILE *XBOX_writer_stream(XBOX_writer *writer);
+
+#endif  // XBOX_XWRITER_H
@@ -36,33 +36,72 @@ def test_difference(command1, command2):
         return None
 
 
-def main():
+def test_golden(command, expected_path, update):
+    # GNU readelf 没有的选项 (--filter/--sort/--top) 只能和保存的输出比较
+    output = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+
+    if update:
+        with open(expected_path, "w", encoding="utf-8") as f:
+            f.write(output.stdout)
+        return "passed"
+
+    with open(expected_path, "r", encoding="utf-8") as f:
+        expected = f.read()
+
+    if output.stdout == expected and output.stderr == "":
+        return "passed"
+    else:
+        print(f"  [failed]: {command} (expected {expected_path})")
+        print_diff(expected, output.stdout)
+        if output.stderr:
+            print(output.stderr)
+        return None
+
+
+def main(update):
     with open("./test.json", "r", encoding="utf-8") as f:
         data = json5.load(f)
 
     for program_name in data:
         print(f"testing {program_name}...")
         my_program_name = f"./src/{program_name}"
-        files = data[program_name]["files"]
-        argruments = data[program_name]["args"]
+        # "groups" 中的文件只测试各自的 args, 例如系统库只比较部分选项
+        groups = [data[program_name]] + data[program_name].get("groups", [])
 
         case_number = 0
         passed_case_number = 0
-        for file in files:
-            for args in argruments:
-                case_number += 1
-                command1 = [program_name] + args.split(" ") + [file]
-                command2 = [my_program_name] + args.split(" ") + [file]
-                result = test_difference(command1, command2)
-                if result == "passed":
-                    passed_case_number += 1
+        for group in groups:
+            for file in group["files"]:
+                for args in group["args"]:
+                    case_number += 1
+                    command1 = [program_name] + args.split(" ") + [file]
+                    command2 = [my_program_name] + args.split(" ") + [file]
+                    result = test_difference(command1, command2)
+                    if result == "passed":
+                        passed_case_number += 1
         print(f"{program_name} passed [{passed_case_number}/{case_number}]")
 
+        # "golden" 中的每一项: 用 args 运行 file, 标准输出需要和 expected 文件一致
+        golden = data[program_name].get("golden", [])
+        if len(golden) == 0:
+            continue
+        passed_case_number = 0
+        for case in golden:
+            command = [my_program_name] + case["args"].split(" ") + [case["file"]]
+            result = test_golden(command, case["expected"], update)
+            if result == "passed":
+                passed_case_number += 1
+        print(f"{program_name} golden passed [{passed_case_number}/{len(golden)}]")
+
 
 if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--update-golden", action="store_true", help="rewrite the expected files of \"golden\"")
+    cli = parser.parse_args()
+
     DEBUG = 0
     if not DEBUG:
-        main()
+        main(cli.update_golden)
     else:
         # test single instruction
         instruction = "readelf examples/a -s"